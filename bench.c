@@ -0,0 +1,638 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <string.h>
+#include "nmath.h"
+
+/* NOURSMATH BENCHMARKS
+*  Build and run with: make bench, at -O3 -DNDEBUG.
+*  ./bench.bin [filter] [-o results.csv|results.json]
+*    filter: only benchmarks whose function name contains filter.
+*    -o: also write results to a CSV or JSON file, depending on extension.
+*        Compare two result files with compare.bin, see compare.c.
+*  Each benchmark: BENCH_WARMUP untimed calls, then timed calls until
+*  BENCH_BUDGET_NS is spent, with BENCH_SAMPLES_MIN to BENCH_SAMPLES_MAX
+*  samples. Reports median and p99 of the samples, and median ns per element:
+*  array elements for linalg, tiles for pathfinding.
+*  Allocations: nmath_malloc, nmath_calloc and nmath_realloc calls, counted
+*  with a nmath_set_allocator hook. -1 with NMATH_ALIGNMENT: malloc is not
+*  aligned, the default allocator is kept. */
+
+/********************** 0.1 MICROSECOND RESOLUTION CLOCK **********************/
+//  Modified from: https://gist.github.com/ForeverZer0/0a4f80fc02b96e19380ebb7a3debbee5
+#if defined(__linux)
+#  define MICROSECOND_CLOCK
+#  define HAVE_POSIX_TIMER
+#  include <time.h>
+#  ifdef CLOCK_MONOTONIC
+#     define CLOCKID CLOCK_MONOTONIC
+#  else
+#     define CLOCKID CLOCK_REALTIME
+#  endif
+#elif defined(__APPLE__)
+#  define MICROSECOND_CLOCK
+#  define HAVE_MACH_TIMER
+#  include <mach/mach_time.h>
+#elif defined(_WIN32)
+#  define MICROSECOND_CLOCK
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#endif
+
+uint64_t get_ns() {
+    static uint64_t is_init = 0;
+#if defined(__APPLE__)
+    static mach_timebase_info_data_t info;
+    if (0 == is_init) {
+        mach_timebase_info(&info);
+        is_init = 1;
+    }
+    uint64_t now;
+    now = mach_absolute_time();
+    now *= info.numer;
+    now /= info.denom;
+    return now;
+#elif defined(__linux)
+    static struct timespec linux_rate;
+    if (0 == is_init) {
+        clock_getres(CLOCKID, &linux_rate);
+        is_init = 1;
+    }
+    uint64_t now;
+    struct timespec spec;
+    clock_gettime(CLOCKID, &spec);
+    now = spec.tv_sec * 1.0e9 + spec.tv_nsec;
+    return now;
+#elif defined(_WIN32)
+    static LARGE_INTEGER win_frequency;
+    if (0 == is_init) {
+        QueryPerformanceFrequency(&win_frequency);
+        is_init = 1;
+    }
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((1e9 * now.QuadPart) / win_frequency.QuadPart);
+#endif
+}
+#ifndef MICROSECOND_CLOCK
+#  define FAILSAFE_CLOCK
+#  define get_ns() (((double)clock())/CLOCKS_PER_SEC*1e9) // [ns]
+#endif
+
+/*****************************BENCH CONSTANTS***************************/
+#define BENCH_WARMUP 2
+#define BENCH_SAMPLES_MIN 5
+#define BENCH_SAMPLES_MAX 1000
+#define BENCH_BUDGET_NS 50000000ULL // per benchmark, without warmup
+#define BENCH_MOVE 8 // move and sight of units on maps
+#define BENCH_FLOOD_MAX 64 // unitGradient: O(tiles^2) closed list scans
+#define BENCH_SEED 0x6E6D617468ULL // maps are identical for every run
+
+enum BENCH_SIZES {
+    BENCH_ARR_LEN_MIN = 1 << 10,
+    BENCH_ARR_LEN_MAX = 1 << 20,
+    BENCH_ARR_LEN_FACTOR = 32,
+    BENCH_MAP_LEN_MIN = 16,
+    BENCH_MAP_LEN_MAX = 1024,
+    BENCH_MAP_LEN_FACTOR = 4,
+    BENCH_SQ_LEN_MIN = 64,
+    BENCH_SQ_LEN_MAX = 512,
+    BENCH_SQ_LEN_FACTOR = 2,
+};
+
+/*****************************BENCH GLOBALS*****************************/
+const char * bench_filter = NULL;
+const char * bench_map_name = "-"; // generated map of pathfinding benchmarks
+uint64_t bench_samples[BENCH_SAMPLES_MAX];
+
+/* Machine-readable results file */
+enum BENCH_FORMATS {
+    BENCH_FORMAT_CSV = 0,
+    BENCH_FORMAT_JSON = 1,
+};
+FILE * bench_out = NULL;
+int bench_format = BENCH_FORMAT_CSV;
+size_t bench_records = 0;
+
+/* Allocations during timed calls only */
+size_t bench_allocs = 0;
+void * bench_malloc(size_t size) {
+    bench_allocs++;
+    return (malloc(size));
+}
+void * bench_calloc(size_t num, size_t size) {
+    bench_allocs++;
+    return (calloc(num, size));
+}
+void * bench_realloc(void * ptr, size_t size) {
+    bench_allocs++;
+    return (realloc(ptr, size));
+}
+#define BENCH_ALLOCS_RESET do {bench_allocs = 0;} while (0)
+#define BENCH_ALLOCS ((NMATH_ALIGNMENT == 0) ? (int64_t)bench_allocs : (int64_t)-1)
+
+int bench_compare(const void * a, const void * b) {
+    uint64_t sample_a = *(const uint64_t *)a, sample_b = *(const uint64_t *)b;
+    return ((sample_a > sample_b) - (sample_a < sample_b));
+}
+
+void bench_out_open(const char * filename) {
+    const char * extension = strrchr(filename, '.');
+    bench_format = ((extension != NULL) && (strcmp(extension, ".json") == 0)) ? BENCH_FORMAT_JSON : BENCH_FORMAT_CSV;
+    bench_out = fopen(filename, "w+");
+    if (bench_out == NULL) {
+        printf("bench: could not open %s\n", filename);
+        exit(1);
+    }
+    switch (bench_format) {
+        case BENCH_FORMAT_CSV:
+            fprintf(bench_out, "function,type,map,size,threads,median_ns,p99_ns,ns_per_elem,elem_per_s,allocs\n");
+            break;
+        case BENCH_FORMAT_JSON:
+            fprintf(bench_out, "[\n");
+            break;
+    }
+}
+
+void bench_out_close() {
+    if (bench_out == NULL) {
+        return;
+    }
+    if (bench_format == BENCH_FORMAT_JSON) {
+        fprintf(bench_out, "\n]\n");
+    }
+    fclose(bench_out);
+    bench_out = NULL;
+}
+
+/* allocs: per call, -1 if not counted */
+void bench_report(const char * name, const char * type, size_t size, size_t elements, size_t sample_num, int64_t allocs) {
+    qsort(bench_samples, sample_num, sizeof(*bench_samples), bench_compare);
+    uint64_t median = bench_samples[sample_num / 2];
+    uint64_t p99 = bench_samples[(sample_num * 99) / 100];
+    double ns_per_elem = (double)median / elements;
+    double elem_per_s = (median > 0) ? (1.0e9 * elements / median) : 0.0;
+    printf("%-40s %-14s %-6s %8zu %4d %14llu %14llu %12.4f %8lld\n", name, type, bench_map_name, size, nmath_get_threads(), (unsigned long long)median, (unsigned long long)p99, ns_per_elem, (long long)allocs);
+    if (bench_out == NULL) {
+        return;
+    }
+    switch (bench_format) {
+        case BENCH_FORMAT_CSV:
+            fprintf(bench_out, "%s,%s,%s,%zu,%d,%llu,%llu,%.4f,%.4e,%lld\n", name, type, bench_map_name, size, nmath_get_threads(), (unsigned long long)median, (unsigned long long)p99, ns_per_elem, elem_per_s, (long long)allocs);
+            break;
+        case BENCH_FORMAT_JSON:
+            fprintf(bench_out, "%s{\"function\": \"%s\", \"type\": \"%s\", \"map\": \"%s\", \"size\": %zu, \"threads\": %d, \"median_ns\": %llu, \"p99_ns\": %llu, \"ns_per_elem\": %.4f, \"elem_per_s\": %.4e, \"allocs\": %lld}", (bench_records > 0) ? ",\n" : "", name, type, bench_map_name, size, nmath_get_threads(), (unsigned long long)median, (unsigned long long)p99, ns_per_elem, elem_per_s, (long long)allocs);
+            break;
+    }
+    bench_records++;
+}
+
+/* Benchmark call. setup before and cleanup after each call are not timed.
+*  name: function name, for filter. size: row_len, sq_len or arr_len. */
+#define BENCH(name, type, size, elements, setup, call, cleanup) do {\
+    if ((bench_filter == NULL) || (strstr(name, bench_filter) != NULL)) {\
+        for (size_t warmup = 0; warmup < BENCH_WARMUP; warmup++) {\
+            setup;\
+            call;\
+            cleanup;\
+        }\
+        size_t sample_num = 0;\
+        int64_t sample_allocs = 0;\
+        uint64_t bench_start = get_ns();\
+        while ((sample_num < BENCH_SAMPLES_MIN) || ((sample_num < BENCH_SAMPLES_MAX) && ((get_ns() - bench_start) < BENCH_BUDGET_NS))) {\
+            setup;\
+            BENCH_ALLOCS_RESET;\
+            uint64_t sample_start = get_ns();\
+            call;\
+            bench_samples[sample_num++] = get_ns() - sample_start;\
+            sample_allocs = BENCH_ALLOCS;\
+            cleanup;\
+        }\
+        bench_report(name, type, size, elements, sample_num, sample_allocs);\
+    }\
+} while (0)
+
+#define BENCH_NOTHING do {} while (0)
+
+/* keeps results alive at -O3 */
+volatile double bench_sink;
+
+/*******************************LINALG**********************************/
+#define REGISTER_ENUM(type) void bench_linalg_##type(size_t arr_len) {\
+    type * matrix1 = malloc(arr_len * sizeof(type));\
+    type * matrix2 = malloc(arr_len * sizeof(type));\
+    type * out = malloc(arr_len * sizeof(type));\
+    for (size_t i = 0; i < arr_len; i++) {\
+        matrix1[i] = (type)((i * 7) % 13 + 1);\
+        matrix2[i] = (type)((i * 5) % 11 + 1);\
+    }\
+    BENCH("linalg_minus_noM", #type, arr_len, arr_len, BENCH_NOTHING, linalg_minus_noM_##type(out, matrix1, matrix2, arr_len), BENCH_NOTHING);\
+    BENCH("linalg_mult_noM", #type, arr_len, arr_len, BENCH_NOTHING, linalg_mult_noM_##type(out, matrix1, matrix2, arr_len), BENCH_NOTHING);\
+    BENCH("linalg_div_noM", #type, arr_len, arr_len, BENCH_NOTHING, linalg_div_noM_##type(out, matrix1, matrix2, arr_len), BENCH_NOTHING);\
+    BENCH("linalg_plus_scalar_noM", #type, arr_len, arr_len, BENCH_NOTHING, linalg_plus_scalar_noM_##type(out, matrix1, 3, arr_len), BENCH_NOTHING);\
+    BENCH("linalg_mask_noM", #type, arr_len, arr_len, BENCH_NOTHING, linalg_mask_noM_##type(out, matrix1, matrix2, arr_len), BENCH_NOTHING);\
+    BENCH("linalg_sum", #type, arr_len, arr_len, BENCH_NOTHING, bench_sink = linalg_sum_##type(matrix1, arr_len), BENCH_NOTHING);\
+    BENCH("linalg_max", #type, arr_len, arr_len, BENCH_NOTHING, bench_sink = linalg_max_##type(matrix1, arr_len), BENCH_NOTHING);\
+    BENCH("linalg_count", #type, arr_len, arr_len, BENCH_NOTHING, bench_sink = linalg_count_##type(matrix1, 5, arr_len), BENCH_NOTHING);\
+    BENCH("linalg_dotProduct", #type, arr_len, arr_len, BENCH_NOTHING, bench_sink = linalg_dotProduct_##type(matrix1, matrix2, arr_len), BENCH_NOTHING);\
+    free(matrix1);\
+    free(matrix2);\
+    free(out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* Comparisons and any: integer types only */
+#define REGISTER_ENUM(type) void bench_linalg_compare_##type(size_t arr_len) {\
+    type * matrix1 = malloc(arr_len * sizeof(type));\
+    type * matrix2 = malloc(arr_len * sizeof(type));\
+    type * out = malloc(arr_len * sizeof(type));\
+    bit_array_t * mask = calloc(NMATH_BIT_ARRAY_SIZE_CEIL(arr_len), sizeof(*mask));\
+    for (size_t i = 0; i < arr_len; i++) {\
+        matrix1[i] = (type)((i * 7) % 13 + 1);\
+        matrix2[i] = (type)((i * 5) % 11 + 1);\
+    }\
+    BENCH("linalg_greater_noM", #type, arr_len, arr_len, BENCH_NOTHING, linalg_greater_noM_##type(out, matrix1, matrix2, arr_len), BENCH_NOTHING);\
+    BENCH("linalg_sgreater_noM", #type, arr_len, arr_len, BENCH_NOTHING, linalg_sgreater_noM_##type(out, matrix1, 6, arr_len), BENCH_NOTHING);\
+    BENCH("linalg_greater_bitmask", #type, arr_len, arr_len, BENCH_NOTHING, linalg_greater_bitmask_##type(mask, matrix1, matrix2, arr_len), BENCH_NOTHING);\
+    BENCH("linalg_any", #type, arr_len, arr_len, BENCH_NOTHING, bench_sink = linalg_any_##type(out, arr_len), BENCH_NOTHING);\
+    free(matrix1);\
+    free(matrix2);\
+    free(out);\
+    free(mask);\
+}
+TEMPLATE_TYPES_INT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) void bench_linalg_square_##type(size_t sq_len) {\
+    size_t sq_num = sq_len * sq_len;\
+    type * matrix1 = malloc(sq_num * sizeof(type));\
+    type * matrix2 = malloc(sq_num * sizeof(type));\
+    type * out = malloc(sq_num * sizeof(type));\
+    type * buffer = malloc(NMATH_MATMUL_BUFFER_LEN * sizeof(type));\
+    type * vec = malloc(sq_len * sizeof(type));\
+    size_t * pivots = malloc(sq_len * sizeof(*pivots));\
+    for (size_t i = 0; i < sq_num; i++) {\
+        matrix1[i] = (type)((i * 7) % 13) / 13 - (type)0.5;\
+        matrix2[i] = (type)((i * 5) % 11) / 11 - (type)0.5;\
+    }\
+    for (size_t i = 0; i < sq_len; i++) {\
+        matrix1[i * sq_len + i] += sq_len;\
+        vec[i] = 1;\
+    }\
+    BENCH("linalg_matmul_noM", #type, sq_len, sq_num, BENCH_NOTHING, linalg_matmul_noM_##type(out, matrix1, matrix2, buffer, sq_len, sq_len, sq_len), BENCH_NOTHING);\
+    BENCH("linalg_lu_noM", #type, sq_len, sq_num, memcpy(out, matrix1, sq_num * sizeof(type)), linalg_lu_noM_##type(out, pivots, sq_len), BENCH_NOTHING);\
+    BENCH("linalg_determinant_noM", #type, sq_len, sq_num, BENCH_NOTHING, bench_sink = linalg_determinant_noM_##type(matrix1, out, pivots, sq_len), BENCH_NOTHING);\
+    linalg_lu_noM_##type(memcpy(out, matrix1, sq_num * sizeof(type)), pivots, sq_len);\
+    BENCH("linalg_solve_noM", #type, sq_len, sq_num, BENCH_NOTHING, linalg_solve_noM_##type(buffer, out, pivots, vec, sq_len), BENCH_NOTHING);\
+    BENCH("linalg_inverse_noM", #type, sq_len, sq_num, BENCH_NOTHING, linalg_inverse_noM_##type(matrix2, out, pivots, sq_len), BENCH_NOTHING);\
+    if (sq_len <= BENCH_SQ_LEN_MIN * 2) {\
+        for (size_t i = 0; i < sq_len; i++) {\
+            for (size_t j = 0; j < i; j++) {\
+                matrix1[i * sq_len + j] = matrix1[j * sq_len + i];\
+            }\
+        }\
+        BENCH("linalg_eigen_symmetric_noM", #type, sq_len, sq_num, memcpy(out, matrix1, sq_num * sizeof(type)), linalg_eigen_symmetric_noM_##type(out, vec, buffer, sq_len), BENCH_NOTHING);\
+    }\
+    free(matrix1);\
+    free(matrix2);\
+    free(out);\
+    free(buffer);\
+    free(vec);\
+    free(pivots);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* Maps with row_len == col_len */
+#define REGISTER_ENUM(type) void bench_linalg_map_##type(size_t row_len) {\
+    size_t tile_num = row_len * row_len;\
+    type * matrix = malloc(tile_num * sizeof(type));\
+    type * out = malloc(tile_num * sizeof(type));\
+    type * buffer = malloc(tile_num * sizeof(type));\
+    type kernel[5] = {1, 4, 6, 4, 1};\
+    for (size_t i = 0; i < tile_num; i++) {\
+        matrix[i] = (type)((i * 7) % 13 + 1);\
+    }\
+    BENCH("linalg_convolve2D_separable_noM", #type, row_len, tile_num, BENCH_NOTHING, linalg_convolve2D_separable_noM_##type(out, matrix, buffer, kernel, kernel, row_len, row_len, 5, 5, NMATH_BORDER_CLAMP), BENCH_NOTHING);\
+    BENCH("linalg_box_filter_noM", #type, row_len, tile_num, BENCH_NOTHING, linalg_box_filter_noM_##type(out, matrix, buffer, row_len, row_len, 3, NMATH_BORDER_CLAMP), BENCH_NOTHING);\
+    struct nmath_csr_##type * csr = NULL;\
+    BENCH("linalg_csr_grid", #type, row_len, tile_num, BENCH_NOTHING, csr = linalg_csr_grid_##type(matrix, row_len, row_len, NMATH_SQUARE_NEIGHBOURS), linalg_csr_free_##type(csr));\
+    csr = linalg_csr_grid_##type(matrix, row_len, row_len, NMATH_SQUARE_NEIGHBOURS);\
+    BENCH("linalg_csr_spmv_noM", #type, row_len, tile_num, BENCH_NOTHING, linalg_csr_spmv_noM_##type(out, csr, matrix), BENCH_NOTHING);\
+    linalg_csr_free_##type(csr);\
+    free(matrix);\
+    free(out);\
+    free(buffer);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/*****************************THREAD SCALING****************************/
+/* Threaded kernels from 1 thread to nmath_get_threads() at startup.
+*  Single-threaded unless nmath.c is compiled with -fopenmp. */
+void bench_threads() {
+    int threads_max = nmath_get_threads();
+    size_t arr_len = BENCH_ARR_LEN_MAX * 4, sq_len = BENCH_SQ_LEN_MAX;
+    float * matrix1 = malloc(arr_len * sizeof(*matrix1));
+    float * matrix2 = malloc(arr_len * sizeof(*matrix2));
+    float * out = malloc(arr_len * sizeof(*out));
+    float * buffer = malloc(NMATH_MATMUL_BUFFER_LEN * sizeof(*buffer));
+    for (size_t i = 0; i < arr_len; i++) {
+        matrix1[i] = (float)((i * 7) % 13);
+        matrix2[i] = (float)((i * 5) % 11);
+    }
+    for (int threads = 1; ; threads *= 2) {
+        threads = (threads < threads_max) ? threads : threads_max;
+        nmath_set_threads(threads);
+        BENCH("threads_linalg_mult_noM", "float", arr_len, arr_len, BENCH_NOTHING, linalg_mult_noM_float(out, matrix1, matrix2, arr_len), BENCH_NOTHING);
+        BENCH("threads_linalg_sum", "float", arr_len, arr_len, BENCH_NOTHING, bench_sink = linalg_sum_float(matrix1, arr_len), BENCH_NOTHING);
+        BENCH("threads_linalg_matmul_noM", "float", sq_len, sq_len * sq_len, BENCH_NOTHING, linalg_matmul_noM_float(out, matrix1, matrix2, buffer, sq_len, sq_len, sq_len), BENCH_NOTHING);
+        if (threads == threads_max) {
+            break;
+        }
+    }
+    nmath_set_threads(0);
+    free(matrix1);
+    free(matrix2);
+    free(out);
+    free(buffer);
+}
+
+/*******************************CONTAINERS******************************/
+void bench_darr(size_t num) {
+    int32_t * darr = NULL;
+    BENCH("DARR_PUT", "int32_t", num, num, darr = DARR_INIT(darr, int32_t, 16), for (size_t i = 0; i < num; i++) {DARR_PUT(darr, (int32_t)i);}, DARR_FREE(darr));
+    BENCH("DARR_INSERT", "int32_t", num, num, darr = DARR_INIT(darr, int32_t, 16), for (size_t i = 0; i < num; i++) {DARR_INSERT(darr, (int32_t)i, 0);}, DARR_FREE(darr));
+    BENCH("DARR_POP", "int32_t", num, num, darr = DARR_INIT(darr, int32_t, num + 1); for (size_t i = 0; i < num; i++) {DARR_PUT(darr, (int32_t)i);}, while (DARR_NUM(darr) > 0) {bench_sink = DARR_POP(darr);}, DARR_FREE(darr));
+    BENCH("DARR_DEL", "int32_t", num, num, darr = DARR_INIT(darr, int32_t, num + 1); for (size_t i = 0; i < num; i++) {DARR_PUT(darr, (int32_t)i);}, while (DARR_NUM(darr) > 0) {DARR_DEL(darr, 0);}, DARR_FREE(darr));
+}
+
+void bench_dtab(size_t num) {
+    struct dtab * dtab_ptr = NULL;
+    BENCH("DTAB_ADD", "int32_t", num, num, DTAB_INIT(dtab_ptr, int32_t), for (size_t i = 1; i <= num; i++) {int32_t value = i; DTAB_ADD(dtab_ptr, &value, i);}, DTAB_FREE(dtab_ptr));
+    DTAB_INIT(dtab_ptr, int32_t);
+    for (size_t i = 1; i <= num; i++) {
+        int32_t value = i;
+        DTAB_ADD(dtab_ptr, &value, i);
+    }
+    BENCH("DTAB_GET", "int32_t", num, num, BENCH_NOTHING, for (size_t i = 1; i <= num; i++) {bench_sink = *(int32_t *)DTAB_GET(dtab_ptr, i);}, BENCH_NOTHING);
+    DTAB_FREE(dtab_ptr);
+}
+
+/*****************************MAP GENERATOR*****************************/
+/* Seeded maps in the flat layout: costmap[row * col_len + col].
+*  costmap: NMATH_COSTMAP_BLOCKED or costs 1 to 3.
+*  blockmap: NMATH_BLOCKMAP_MIN on walls. Water blocks movement, not sight.
+*  splitmix64: same seed, same map, on every platform. */
+enum BENCH_MAPS {
+    BENCH_MAP_OPEN = 0,  // no walls, rough terrain patches
+    BENCH_MAP_NOISE = 1, // BENCH_NOISE_WALLS percent random walls: may be disconnected
+    BENCH_MAP_MAZE = 2,  // perfect maze, corridors 1 tile wide
+    BENCH_MAP_ROOMS = 3, // rooms joined by corridors
+    BENCH_MAP_RIVER = 4, // meandering rivers, bridges every BENCH_BRIDGE_GAP rows
+    BENCH_MAP_NUM = 5,
+};
+
+const char * bench_map_names[BENCH_MAP_NUM] = {"open", "noise", "maze", "rooms", "river"};
+
+#define BENCH_NOISE_WALLS 30
+#define BENCH_ROOM_TILES 256 // one room per BENCH_ROOM_TILES tiles
+#define BENCH_ROOM_LEN_MIN 3
+#define BENCH_ROOM_LEN_MAX 12
+#define BENCH_RIVER_GAP 256 // one river per BENCH_RIVER_GAP columns
+#define BENCH_BRIDGE_GAP 16
+
+uint64_t bench_rand(uint64_t * state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (z ^ (z >> 31));
+}
+
+/* Terrain cost: 1 on 80% of tiles, 2 on 15%, 3 on 5% */
+int32_t bench_rand_cost(uint64_t * state) {
+    uint64_t percent = bench_rand(state) % 100;
+    return ((percent < 80) ? 1 : ((percent < 95) ? 2 : 3));
+}
+
+/* Recursive backtracker on cells at odd (row, col), explicit stack */
+void bench_map_maze(int32_t * costmap, size_t row_len, size_t col_len, uint64_t * state) {
+    size_t cell_rows = (row_len - 1) / 2, cell_cols = (col_len - 1) / 2;
+    if ((cell_rows == 0) || (cell_cols == 0)) {
+        return;
+    }
+    size_t * stack = malloc(cell_rows * cell_cols * sizeof(*stack));
+    size_t stack_num = 0;
+    costmap[1 * col_len + 1] = 1;
+    stack[stack_num++] = 0;
+    while (stack_num > 0) {
+        size_t cell = stack[stack_num - 1], cell_row = cell / cell_cols, cell_col = cell % cell_cols;
+        size_t unvisited[NMATH_SQUARE_NEIGHBOURS], unvisited_num = 0;
+        for (int i = 0; i < NMATH_SQUARE_NEIGHBOURS; i++) {
+            int64_t next_row = (int64_t)cell_row + q_cycle4_zmzp(i), next_col = (int64_t)cell_col + q_cycle4_mzpz(i);
+            if ((next_row >= 0) && (next_col >= 0) && (next_row < (int64_t)cell_rows) && (next_col < (int64_t)cell_cols)) {
+                if (costmap[(2 * next_row + 1) * col_len + (2 * next_col + 1)] == NMATH_COSTMAP_BLOCKED) {
+                    unvisited[unvisited_num++] = next_row * cell_cols + next_col;
+                }
+            }
+        }
+        if (unvisited_num == 0) {
+            stack_num--;
+            continue;
+        }
+        size_t next = unvisited[bench_rand(state) % unvisited_num];
+        size_t next_row = next / cell_cols, next_col = next % cell_cols;
+        costmap[(cell_row + next_row + 1) * col_len + (cell_col + next_col + 1)] = 1;
+        costmap[(2 * next_row + 1) * col_len + (2 * next_col + 1)] = 1;
+        stack[stack_num++] = next;
+    }
+    free(stack);
+}
+
+/* Each room joined to the previous one by an L-shaped corridor */
+void bench_map_rooms(int32_t * costmap, size_t row_len, size_t col_len, uint64_t * state) {
+    size_t room_num = (row_len * col_len) / BENCH_ROOM_TILES;
+    room_num = (room_num < 2) ? 2 : room_num;
+    size_t previous_row = 0, previous_col = 0;
+    for (size_t room = 0; room < room_num; room++) {
+        size_t height = BENCH_ROOM_LEN_MIN + bench_rand(state) % (BENCH_ROOM_LEN_MAX - BENCH_ROOM_LEN_MIN + 1);
+        size_t width = BENCH_ROOM_LEN_MIN + bench_rand(state) % (BENCH_ROOM_LEN_MAX - BENCH_ROOM_LEN_MIN + 1);
+        height = (height < row_len) ? height : row_len;
+        width = (width < col_len) ? width : col_len;
+        size_t top = bench_rand(state) % (row_len - height + 1), left = bench_rand(state) % (col_len - width + 1);
+        for (size_t row = top; row < (top + height); row++) {
+            for (size_t col = left; col < (left + width); col++) {
+                costmap[row * col_len + col] = bench_rand_cost(state);
+            }
+        }
+        size_t center_row = top + height / 2, center_col = left + width / 2;
+        if (room > 0) {
+            size_t col_min = (previous_col < center_col) ? previous_col : center_col;
+            size_t col_max = (previous_col < center_col) ? center_col : previous_col;
+            size_t row_min = (previous_row < center_row) ? previous_row : center_row;
+            size_t row_max = (previous_row < center_row) ? center_row : previous_row;
+            for (size_t col = col_min; col <= col_max; col++) {
+                costmap[previous_row * col_len + col] = 1;
+            }
+            for (size_t row = row_min; row <= row_max; row++) {
+                costmap[row * col_len + center_col] = 1;
+            }
+        }
+        previous_row = center_row;
+        previous_col = center_col;
+    }
+}
+
+/* Rivers 3 tiles wide, drifting one column at most per row */
+void bench_map_river(int32_t * costmap, size_t row_len, size_t col_len, uint64_t * state) {
+    size_t river_num = 1 + col_len / BENCH_RIVER_GAP;
+    for (size_t river = 0; river < river_num; river++) {
+        int64_t center = (int64_t)(col_len * (river + 1) / (river_num + 1));
+        for (size_t row = 0; row < row_len; row++) {
+            center += (int64_t)(bench_rand(state) % 3) - 1;
+            center = (center < 1) ? 1 : ((center > ((int64_t)col_len - 2)) ? ((int64_t)col_len - 2) : center);
+            bool bridge = ((row % BENCH_BRIDGE_GAP) == (BENCH_BRIDGE_GAP / 2));
+            for (int64_t col = center - 1; col <= (center + 1); col++) {
+                if ((col >= 0) && (col < (int64_t)col_len)) {
+                    costmap[row * col_len + col] = bridge ? 1 : NMATH_COSTMAP_BLOCKED;
+                }
+            }
+        }
+    }
+}
+
+void bench_map_generate(int32_t * costmap, int32_t * blockmap, size_t row_len, size_t col_len, int map, uint64_t seed) {
+    uint64_t state = seed;
+    size_t tile_num = row_len * col_len;
+    bool walled = (map == BENCH_MAP_MAZE) || (map == BENCH_MAP_ROOMS);
+    for (size_t i = 0; i < tile_num; i++) {
+        costmap[i] = walled ? NMATH_COSTMAP_BLOCKED : bench_rand_cost(&state);
+        if ((map == BENCH_MAP_NOISE) && ((bench_rand(&state) % 100) < BENCH_NOISE_WALLS)) {
+            costmap[i] = NMATH_COSTMAP_BLOCKED;
+        }
+    }
+    switch (map) {
+        case BENCH_MAP_MAZE:
+            bench_map_maze(costmap, row_len, col_len, &state);
+            break;
+        case BENCH_MAP_ROOMS:
+            bench_map_rooms(costmap, row_len, col_len, &state);
+            break;
+        case BENCH_MAP_RIVER:
+            bench_map_river(costmap, row_len, col_len, &state);
+            break;
+    }
+    for (size_t i = 0; i < tile_num; i++) {
+        bool wall = (costmap[i] == NMATH_COSTMAP_BLOCKED) && (map != BENCH_MAP_RIVER);
+        blockmap[i] = wall ? NMATH_BLOCKMAP_MIN : NMATH_BLOCKMAP_BLOCKED;
+    }
+}
+
+/* First moveable tile from (row, col), in raster order (step 1) or reverse (step -1), wrapping */
+struct nmath_point_int32_t bench_map_moveable(int32_t * costmap, size_t row_len, size_t col_len, size_t row, size_t col, int step) {
+    int64_t tile_num = row_len * col_len, start = row * col_len + col;
+    for (int64_t i = 0; i < tile_num; i++) {
+        size_t tile = ((start + step * i) % tile_num + tile_num) % tile_num;
+        if (costmap[tile] >= NMATH_COSTMAP_MOVEABLEMIN) {
+            struct nmath_point_int32_t moveable = {tile % col_len, tile / col_len};
+            return (moveable);
+        }
+    }
+    struct nmath_point_int32_t none = {col, row};
+    return (none);
+}
+
+/*****************************PATHFINDING*******************************/
+void bench_pathfinding(size_t row_len, int map) {
+    size_t tile_num = row_len * row_len;
+    int32_t * costmap = malloc(tile_num * sizeof(*costmap));
+    int32_t * blockmap = malloc(tile_num * sizeof(*blockmap));
+    int32_t * movemap = malloc(tile_num * sizeof(*movemap));
+    int32_t * out = malloc(tile_num * sizeof(*out));
+    int32_t * list = NULL;
+    bench_map_generate(costmap, blockmap, row_len, row_len, map, BENCH_SEED);
+    bench_map_name = bench_map_names[map];
+    struct nmath_point_int32_t center = bench_map_moveable(costmap, row_len, row_len, row_len / 2, row_len / 2, 1);
+    struct nmath_point_int32_t origin = bench_map_moveable(costmap, row_len, row_len, 0, 0, 1);
+    struct nmath_point_int32_t corner = bench_map_moveable(costmap, row_len, row_len, row_len - 1, row_len - 1, -1);
+    struct nmath_hexpoint_int32_t hex_center = {center.x, 0, center.y};
+    int8_t range[2] = {1, 2};
+    pathfinding_Map_Moveto_noM_int32_t(movemap, costmap, row_len, row_len, center, BENCH_MOVE);
+
+    BENCH("pathfinding_Map_Moveto_noM", "int32_t", row_len, tile_num, BENCH_NOTHING, pathfinding_Map_Moveto_noM_int32_t(out, costmap, row_len, row_len, center, BENCH_MOVE), BENCH_NOTHING);
+    BENCH("pathfinding_Map_Moveto", "int32_t", row_len, tile_num, BENCH_NOTHING, list = pathfinding_Map_Moveto_int32_t(costmap, row_len, row_len, center, BENCH_MOVE, NMATH_POINTS_MODE_LIST), DARR_FREE(list));
+    BENCH("pathfinding_Map_Moveto_Hex", "int32_t", row_len, tile_num, BENCH_NOTHING, list = pathfinding_Map_Moveto_Hex_int32_t(costmap, row_len, row_len, hex_center, BENCH_MOVE, NMATH_POINTS_MODE_MATRIX), nmath_free(list));
+    BENCH("pathfinding_Map_Visible_noM", "int32_t", row_len, tile_num, BENCH_NOTHING, pathfinding_Map_Visible_noM_int32_t(out, blockmap, row_len, row_len, center, BENCH_MOVE), BENCH_NOTHING);
+    BENCH("pathfinding_Map_Visible_Hex", "int32_t", row_len, tile_num, BENCH_NOTHING, list = pathfinding_Map_Visible_Hex_int32_t(blockmap, row_len, row_len, hex_center, BENCH_MOVE, NMATH_POINTS_MODE_MATRIX), nmath_free(list));
+    BENCH("pathfinding_Map_Attackto_noM", "int32_t", row_len, tile_num, BENCH_NOTHING, pathfinding_Map_Attackto_noM_int32_t(out, movemap, row_len, row_len, BENCH_MOVE, range, NMATH_MOVETILE_INCLUDE), BENCH_NOTHING);
+    BENCH("pathfinding_Map_Attackfrom_noM", "int32_t", row_len, tile_num, BENCH_NOTHING, pathfinding_Map_Attackfrom_noM_int32_t(out, movemap, row_len, row_len, center, range), BENCH_NOTHING);
+    struct nmath_sq_neighbors_int32_t direction_block, pushto;
+    BENCH("pathfinding_Direction_Block", "int32_t", row_len, tile_num, BENCH_NOTHING, direction_block = pathfinding_Direction_Block_int32_t(costmap, row_len, row_len, center), BENCH_NOTHING);
+    pathfinding_Map_Attackfrom_noM_int32_t(out, movemap, row_len, row_len, center, range);
+    BENCH("pathfinding_Direction_Pushto", "int32_t", row_len, tile_num, BENCH_NOTHING, pushto = pathfinding_Direction_Pushto_int32_t(out, row_len, row_len, range, center), BENCH_NOTHING);
+    BENCH("pathfinding_Map_PushPullto_noM", "int32_t", row_len, tile_num, BENCH_NOTHING, pathfinding_Map_PushPullto_noM_int32_t(out, direction_block, pushto, row_len, row_len, center), BENCH_NOTHING);
+    if (row_len <= BENCH_FLOOD_MAX) {
+        BENCH("pathfinding_Map_unitGradient_noM", "int32_t", row_len, tile_num, BENCH_NOTHING, pathfinding_Map_unitGradient_noM_int32_t(out, costmap, row_len, row_len, &center, 1), BENCH_NOTHING);
+    }
+    BENCH("pathfinding_Astar_List", "int32_t", row_len, tile_num, list = DARR_INIT(list, int32_t, 64), list = pathfinding_Astar_List_int32_t(list, costmap, row_len, row_len, origin, corner), DARR_FREE(list));
+    BENCH("pathfinding_Astar_Map", "int32_t", row_len, tile_num, memset(out, 0, tile_num * sizeof(*out)), pathfinding_Astar_Map_int32_t(out, costmap, row_len, row_len, origin, corner), BENCH_NOTHING);
+    bench_map_name = "-";
+    free(costmap);
+    free(blockmap);
+    free(movemap);
+    free(out);
+}
+
+/*******************************RUN ALL*********************************/
+int main(int argc, char * argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-o") == 0) && ((i + 1) < argc)) {
+            bench_out_open(argv[++i]);
+        } else {
+            bench_filter = argv[i];
+        }
+    }
+#if NMATH_ALIGNMENT == 0
+    struct nmath_allocator counting = {bench_malloc, bench_calloc, bench_realloc, free};
+    nmath_set_allocator(counting);
+#endif
+    printf("simd: %s\n", nmath_simd_name(nmath_get_simd()));
+    printf("%-40s %-14s %-6s %8s %4s %14s %14s %12s %8s\n", "function", "type", "map", "size", "thr", "median [ns]", "p99 [ns]", "ns/elem", "allocs");
+    for (size_t arr_len = BENCH_ARR_LEN_MIN; arr_len <= BENCH_ARR_LEN_MAX; arr_len *= BENCH_ARR_LEN_FACTOR) {
+#define REGISTER_ENUM(type) bench_linalg_##type(arr_len);
+        TEMPLATE_TYPES_INT
+        TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+#define REGISTER_ENUM(type) bench_linalg_compare_##type(arr_len);
+        TEMPLATE_TYPES_INT
+#undef REGISTER_ENUM
+    }
+    for (size_t sq_len = BENCH_SQ_LEN_MIN; sq_len <= BENCH_SQ_LEN_MAX; sq_len *= BENCH_SQ_LEN_FACTOR) {
+#define REGISTER_ENUM(type) bench_linalg_square_##type(sq_len);
+        TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+    }
+    for (size_t row_len = BENCH_MAP_LEN_MIN; row_len <= BENCH_MAP_LEN_MAX; row_len *= BENCH_MAP_LEN_FACTOR) {
+#define REGISTER_ENUM(type) bench_linalg_map_##type(row_len);
+        TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+        for (int map = 0; map < BENCH_MAP_NUM; map++) {
+            bench_pathfinding(row_len, map);
+        }
+    }
+    bench_darr(1 << 10);
+    bench_darr(1 << 14);
+    bench_dtab(1 << 8);
+    bench_dtab(1 << 11);
+    bench_threads();
+    bench_out_close();
+#ifdef NMATH_HISTOGRAMS
+    nmath_histogram_dump(stdout);
+#endif
+    return (0);
+}
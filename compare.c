@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "nmath.h"
+
+/* NOURSMATH BENCHMARK COMPARISON
+*  Build and run with: make compare BENCH_BASE=base.csv BENCH_NEW=new.csv
+*  ./compare.bin base new [threshold]
+*    base, new: CSV or JSON results files written by bench.bin -o.
+*    threshold: regression if new median is slower than base median by more
+*    than threshold percent. Default COMPARE_THRESHOLD.
+*  Benchmarks are matched by function, type, map, size and threads.
+*  Regressions are also flagged when allocations per call increase.
+*  Report is printed and written to nmath_bench_compare.txt.
+*  Exits with 1 if any regression is found, for CI. */
+
+FILE * globalf;
+
+void dupprintf(FILE * f, char const * fmt, ...) { // duplicate printf
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    va_start(ap, fmt);
+    vfprintf(f, fmt, ap);
+    va_end(ap);
+}
+
+/****************************COMPARE CONSTANTS**************************/
+#define COMPARE_THRESHOLD 10.0 // [%]
+#define COMPARE_NOISE_NS 100 // smaller median differences are never flagged
+#define COMPARE_LINE_LEN 512
+#define COMPARE_NAME_LEN 64
+
+struct Compare_Record {
+    char function[COMPARE_NAME_LEN];
+    char type[COMPARE_NAME_LEN];
+    char map[COMPARE_NAME_LEN];
+    unsigned long long size;
+    int threads;
+    unsigned long long median;
+    unsigned long long p99;
+    double ns_per_elem;
+    double elem_per_s;
+    long long allocs;
+    bool matched;
+};
+
+/* One record per line, in bench.bin CSV or JSON output format. */
+bool compare_parse_csv(struct Compare_Record * record, const char * line) {
+    return (sscanf(line, "%63[^,],%63[^,],%63[^,],%llu,%d,%llu,%llu,%lf,%lf,%lld", record->function, record->type, record->map, &record->size, &record->threads, &record->median, &record->p99, &record->ns_per_elem, &record->elem_per_s, &record->allocs) == 10);
+}
+
+bool compare_parse_json(struct Compare_Record * record, const char * line) {
+    const char * start = strchr(line, '{');
+    if (start == NULL) {
+        return (false);
+    }
+    return (sscanf(start, "{\"function\": \"%63[^\"]\", \"type\": \"%63[^\"]\", \"map\": \"%63[^\"]\", \"size\": %llu, \"threads\": %d, \"median_ns\": %llu, \"p99_ns\": %llu, \"ns_per_elem\": %lf, \"elem_per_s\": %lf, \"allocs\": %lld}", record->function, record->type, record->map, &record->size, &record->threads, &record->median, &record->p99, &record->ns_per_elem, &record->elem_per_s, &record->allocs) == 10);
+}
+
+struct Compare_Record * compare_read(const char * filename) {
+    FILE * file = fopen(filename, "r");
+    if (file == NULL) {
+        dupprintf(globalf, "compare: could not open %s\n", filename);
+        return (NULL);
+    }
+    struct Compare_Record * records = DARR_INIT(records, struct Compare_Record, 64);
+    struct Compare_Record record;
+    char line[COMPARE_LINE_LEN];
+    while (fgets(line, COMPARE_LINE_LEN, file) != NULL) {
+        memset(&record, 0, sizeof(record));
+        if (compare_parse_csv(&record, line) || compare_parse_json(&record, line)) {
+            DARR_PUT(records, record);
+        }
+    }
+    fclose(file);
+    return (records);
+}
+
+bool compare_match(const struct Compare_Record * a, const struct Compare_Record * b) {
+    return ((strcmp(a->function, b->function) == 0) && (strcmp(a->type, b->type) == 0) && (strcmp(a->map, b->map) == 0) && (a->size == b->size) && (a->threads == b->threads));
+}
+
+void compare_print(const char * flag, const struct Compare_Record * base, const struct Compare_Record * new, double change) {
+    dupprintf(globalf, "%-11s %-40s %-14s %-6s %8llu %4d %14llu %14llu %+9.1f%% %6lld %6lld\n", flag, new->function, new->type, new->map, new->size, new->threads, base->median, new->median, change, base->allocs, new->allocs);
+}
+
+int main(int argc, char * argv[]) {
+    globalf = fopen("nmath_bench_compare.txt", "w+");
+    if (argc < 3) {
+        dupprintf(globalf, "usage: %s base new [threshold]\n", argv[0]);
+        return (1);
+    }
+    double threshold = (argc > 3) ? atof(argv[3]) : COMPARE_THRESHOLD;
+    struct Compare_Record * base = compare_read(argv[1]);
+    struct Compare_Record * new = compare_read(argv[2]);
+    if ((base == NULL) || (new == NULL)) {
+        return (1);
+    }
+    dupprintf(globalf, "base: %s (%zu)  new: %s (%zu)  threshold: %.1f%%\n", argv[1], DARR_NUM(base), argv[2], DARR_NUM(new), threshold);
+    dupprintf(globalf, "%-11s %-40s %-14s %-6s %8s %4s %14s %14s %10s %6s %6s\n", "", "function", "type", "map", "size", "thr", "base [ns]", "new [ns]", "change", "b_allc", "n_allc");
+    size_t regressions = 0, improvements = 0, matches = 0;
+    for (size_t i = 0; i < DARR_NUM(new); i++) {
+        struct Compare_Record * current = &new[i];
+        struct Compare_Record * previous = NULL;
+        for (size_t j = 0; j < DARR_NUM(base); j++) {
+            if (!base[j].matched && compare_match(&base[j], current)) {
+                previous = &base[j];
+                break;
+            }
+        }
+        if (previous == NULL) {
+            dupprintf(globalf, "%-11s %-40s %-14s %-6s %8llu %4d\n", "NEW", current->function, current->type, current->map, current->size, current->threads);
+            continue;
+        }
+        previous->matched = true;
+        matches++;
+        double change = (previous->median > 0) ? (100.0 * ((double)current->median - previous->median) / previous->median) : 0.0;
+        bool noise = (current->median > previous->median ? current->median - previous->median : previous->median - current->median) < COMPARE_NOISE_NS;
+        bool allocs_up = (previous->allocs >= 0) && (current->allocs > previous->allocs);
+        if ((!noise && (change > threshold)) || allocs_up) {
+            compare_print(allocs_up ? "REGR_ALLOCS" : "REGRESSION", previous, current, change);
+            regressions++;
+        } else if (!noise && (change < -threshold)) {
+            compare_print("FASTER", previous, current, change);
+            improvements++;
+        }
+    }
+    for (size_t j = 0; j < DARR_NUM(base); j++) {
+        if (!base[j].matched) {
+            dupprintf(globalf, "%-11s %-40s %-14s %-6s %8llu %4d\n", "MISSING", base[j].function, base[j].type, base[j].map, base[j].size, base[j].threads);
+        }
+    }
+    dupprintf(globalf, "compared: %zu  regressions: %zu  faster: %zu\n", matches, regressions, improvements);
+    if (regressions > 0) {
+        dupprintf(globalf, "SOME BENCHMARKS REGRESSED (%zu/%zu)\n", regressions, matches);
+    } else {
+        dupprintf(globalf, "NO BENCHMARK REGRESSED (%zu)\n", matches);
+    }
+    DARR_FREE(base);
+    DARR_FREE(new);
+    fclose(globalf);
+    return (regressions > 0);
+}
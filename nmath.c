@@ -1,4 +1,625 @@
 #include "nmath.h"
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+/* NMATH_PRAGMA: _Pragma with macro arguments */
+#define NMATH_PRAGMA(x) _Pragma(#x)
+
+/********************************* MEMORY ************************************/
+static struct nmath_allocator nmath_allocator = {NULL, NULL, NULL, NULL};
+
+void nmath_set_allocator(struct nmath_allocator allocator) {
+    nmath_allocator = allocator;
+}
+
+struct nmath_allocator nmath_get_allocator(void) {
+    return (nmath_allocator);
+}
+
+#if NMATH_ALIGNMENT > 0
+#define NMATH_ALIGNMENT_MIN (NMATH_ALIGNMENT < sizeof(void *) ? sizeof(void *) : NMATH_ALIGNMENT)
+
+/* posix_memalign memory is released with free, _aligned_malloc memory
+*  with _aligned_free only: nmath_free picks the right one. */
+static void * nmath_aligned_malloc(size_t bytesize) {
+#ifdef _WIN32
+    return (_aligned_malloc(bytesize > 0 ? bytesize : 1, NMATH_ALIGNMENT_MIN));
+#else
+    void * out = NULL;
+    if (posix_memalign(&out, NMATH_ALIGNMENT_MIN, bytesize > 0 ? bytesize : 1) != 0) {
+        out = NULL;
+    }
+    return (out);
+#endif
+}
+
+static void nmath_aligned_free(void * ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+#endif
+
+static void * nmath_malloc_raw(size_t bytesize) {
+    if (nmath_allocator.malloc_fn != NULL) {
+        return (nmath_allocator.malloc_fn(bytesize));
+    }
+#if NMATH_ALIGNMENT > 0
+    return (nmath_aligned_malloc(bytesize));
+#else
+    return (malloc(bytesize));
+#endif
+}
+
+/* (nmath_malloc): parentheses stop NMATH_ALLOC_DEBUG macro expansion. */
+void * (nmath_malloc)(size_t bytesize) {
+    NMATH_STATS_ADD(allocs, 1);
+    return (nmath_malloc_raw(bytesize));
+}
+
+void * (nmath_calloc)(size_t num, size_t bytesize) {
+    NMATH_STATS_ADD(allocs, 1);
+    if (nmath_allocator.calloc_fn != NULL) {
+        return (nmath_allocator.calloc_fn(num, bytesize));
+    }
+    if ((NMATH_ALIGNMENT == 0) && (nmath_allocator.malloc_fn == NULL)) {
+        return (calloc(num, bytesize));
+    }
+    if ((bytesize > 0) && (num > (SIZE_MAX / bytesize))) {
+        return (NULL);
+    }
+    void * out = nmath_malloc_raw(num * bytesize);
+    if (out != NULL) {
+        memset(out, 0, num * bytesize);
+    }
+    return (out);
+}
+
+void * (nmath_realloc)(void * ptr, size_t bytesize) {
+    NMATH_STATS_ADD(allocs, 1);
+    if (nmath_allocator.realloc_fn != NULL) {
+        return (nmath_allocator.realloc_fn(ptr, bytesize));
+    }
+#if (NMATH_ALIGNMENT > 0) && defined(_WIN32)
+    return (_aligned_realloc(ptr, bytesize > 0 ? bytesize : 1, NMATH_ALIGNMENT_MIN));
+#elif NMATH_ALIGNMENT > 0
+    /* realloc keeps alignment most of the time: copy only when it does not. */
+    void * out = realloc(ptr, bytesize);
+    if ((out != NULL) && (((uintptr_t)out % NMATH_ALIGNMENT) != 0)) {
+        void * aligned = nmath_aligned_malloc(bytesize);
+        if (aligned != NULL) {
+            memcpy(aligned, out, bytesize);
+        }
+        free(out);
+        out = aligned;
+    }
+    return (out);
+#else
+    return (realloc(ptr, bytesize));
+#endif
+}
+
+void (nmath_free)(void * ptr) {
+    if (nmath_allocator.free_fn != NULL) {
+        nmath_allocator.free_fn(ptr);
+    } else {
+#if NMATH_ALIGNMENT > 0
+        nmath_aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+}
+
+/* NMATH_ALLOC_DEBUG: every live allocation is in an open addressing table,
+*  with the function that allocated it. Counts are per function, in
+*  nmath_alloc_sites. Tables use stdlib directly, not nmath_allocator. */
+#ifdef NMATH_ALLOC_DEBUG
+#define NMATH_ALLOC_SITES_MAX 512
+#define NMATH_ALLOC_TABLE_LEN_MIN 1024
+#define NMATH_ALLOC_TOMBSTONE ((void *)(uintptr_t)1)
+#ifdef _OPENMP
+#define NMATH_ALLOC_CRITICAL NMATH_PRAGMA(omp critical (nmath_alloc))
+#else
+#define NMATH_ALLOC_CRITICAL
+#endif
+
+struct nmath_alloc_site {
+    const char * func;
+    struct nmath_alloc_count count;
+};
+
+struct nmath_alloc_entry {
+    void * ptr;
+    size_t bytesize;
+    size_t site;
+};
+
+static struct nmath_alloc_site nmath_alloc_sites[NMATH_ALLOC_SITES_MAX];
+static size_t nmath_alloc_sites_num = 0;
+static struct nmath_alloc_entry * nmath_alloc_table = NULL;
+static size_t nmath_alloc_table_len = 0; // power of 2
+static size_t nmath_alloc_table_used = 0; // live and tombstones
+
+static size_t nmath_alloc_hash(void * ptr) {
+    uint64_t hash = (uint64_t)(uintptr_t)ptr * 0x9E3779B97F4A7C15ULL;
+    return ((size_t)(hash >> 32) & (nmath_alloc_table_len - 1));
+}
+
+static void nmath_alloc_atexit(void) {
+    struct nmath_alloc_count total = nmath_alloc_count(NULL);
+    if (total.live_num > 0) {
+        nmath_alloc_report(stderr);
+    }
+}
+
+static size_t nmath_alloc_site(const char * func) {
+    for (size_t i = 0; i < nmath_alloc_sites_num; i++) {
+        if ((nmath_alloc_sites[i].func == func) || (strcmp(nmath_alloc_sites[i].func, func) == 0)) {
+            return (i);
+        }
+    }
+    if (nmath_alloc_sites_num == 0) {
+        atexit(nmath_alloc_atexit);
+    }
+    if (nmath_alloc_sites_num == NMATH_ALLOC_SITES_MAX) {
+        /* last site gathers every other function */
+        nmath_alloc_sites[NMATH_ALLOC_SITES_MAX - 1].func = "(other)";
+        return (NMATH_ALLOC_SITES_MAX - 1);
+    }
+    memset(&nmath_alloc_sites[nmath_alloc_sites_num], 0, sizeof(*nmath_alloc_sites));
+    nmath_alloc_sites[nmath_alloc_sites_num].func = func;
+    return (nmath_alloc_sites_num++);
+}
+
+static bool nmath_alloc_insert(void * ptr, size_t bytesize, size_t site);
+
+/* Out of memory: false, old table kept. */
+static bool nmath_alloc_rehash(size_t table_len) {
+    struct nmath_alloc_entry * table = calloc(table_len, sizeof(*table));
+    if (table == NULL) {
+        return (false);
+    }
+    struct nmath_alloc_entry * old_table = nmath_alloc_table;
+    size_t old_len = nmath_alloc_table_len;
+    nmath_alloc_table = table;
+    nmath_alloc_table_len = table_len;
+    nmath_alloc_table_used = 0;
+    for (size_t i = 0; i < old_len; i++) {
+        if ((old_table[i].ptr != NULL) && (old_table[i].ptr != NMATH_ALLOC_TOMBSTONE)) {
+            nmath_alloc_insert(old_table[i].ptr, old_table[i].bytesize, old_table[i].site);
+        }
+    }
+    free(old_table);
+    return (true);
+}
+
+/* Not inserted: no table, or a full one that could not grow. Probes need
+*  one empty entry to stop. */
+static bool nmath_alloc_insert(void * ptr, size_t bytesize, size_t site) {
+    if ((nmath_alloc_table_used + 1) * 2 > nmath_alloc_table_len) {
+        size_t live = 0;
+        for (size_t i = 0; i < nmath_alloc_sites_num; i++) {
+            live += nmath_alloc_sites[i].count.live_num;
+        }
+        size_t table_len = NMATH_ALLOC_TABLE_LEN_MIN;
+        while (table_len < (live + 1) * 4) {
+            table_len *= 2;
+        }
+        if (!nmath_alloc_rehash(table_len) && ((nmath_alloc_table_used + 1) >= nmath_alloc_table_len)) {
+            return (false);
+        }
+    }
+    size_t i = nmath_alloc_hash(ptr);
+    while ((nmath_alloc_table[i].ptr != NULL) && (nmath_alloc_table[i].ptr != NMATH_ALLOC_TOMBSTONE)) {
+        i = (i + 1) & (nmath_alloc_table_len - 1);
+    }
+    if (nmath_alloc_table[i].ptr == NULL) {
+        nmath_alloc_table_used++;
+    }
+    nmath_alloc_table[i].ptr = ptr;
+    nmath_alloc_table[i].bytesize = bytesize;
+    nmath_alloc_table[i].site = site;
+    return (true);
+}
+
+/* Untracked pointers, like NULL, are ignored. */
+static void nmath_alloc_untrack(void * ptr) {
+    if ((ptr == NULL) || (nmath_alloc_table_len == 0)) {
+        return;
+    }
+    size_t i = nmath_alloc_hash(ptr);
+    while (nmath_alloc_table[i].ptr != NULL) {
+        if (nmath_alloc_table[i].ptr == ptr) {
+            struct nmath_alloc_count * count = &nmath_alloc_sites[nmath_alloc_table[i].site].count;
+            count->live_num--;
+            count->live_bytes -= nmath_alloc_table[i].bytesize;
+            nmath_alloc_table[i].ptr = NMATH_ALLOC_TOMBSTONE;
+            return;
+        }
+        i = (i + 1) & (nmath_alloc_table_len - 1);
+    }
+}
+
+static void nmath_alloc_track(void * ptr, size_t bytesize, const char * func) {
+    size_t site = nmath_alloc_site(func);
+    nmath_alloc_sites[site].count.calls++;
+    nmath_alloc_sites[site].count.bytes += bytesize;
+    if (ptr == NULL) {
+        return;
+    }
+    /* ptr already live: it was freed with plain free, and reused. */
+    nmath_alloc_untrack(ptr);
+    if (nmath_alloc_insert(ptr, bytesize, site)) {
+        nmath_alloc_sites[site].count.live_num++;
+        nmath_alloc_sites[site].count.live_bytes += bytesize;
+    }
+}
+
+void * nmath_malloc_debug(size_t bytesize, const char * func) {
+    void * out = (nmath_malloc)(bytesize);
+    NMATH_ALLOC_CRITICAL
+    nmath_alloc_track(out, bytesize, func);
+    return (out);
+}
+
+void * nmath_calloc_debug(size_t num, size_t bytesize, const char * func) {
+    void * out = (nmath_calloc)(num, bytesize);
+    NMATH_ALLOC_CRITICAL
+    nmath_alloc_track(out, num * bytesize, func);
+    return (out);
+}
+
+void * nmath_realloc_debug(void * ptr, size_t bytesize, const char * func) {
+    void * out = (nmath_realloc)(ptr, bytesize);
+    NMATH_ALLOC_CRITICAL
+    {
+        if ((out != NULL) || (bytesize == 0)) {
+            nmath_alloc_untrack(ptr);
+        }
+        nmath_alloc_track(out, bytesize, func);
+    }
+    return (out);
+}
+
+void nmath_free_debug(void * ptr) {
+    NMATH_ALLOC_CRITICAL
+    nmath_alloc_untrack(ptr);
+    (nmath_free)(ptr);
+}
+#endif
+
+struct nmath_alloc_count nmath_alloc_count(const char * func) {
+    struct nmath_alloc_count out = {0};
+#ifdef NMATH_ALLOC_DEBUG
+    for (size_t i = 0; i < nmath_alloc_sites_num; i++) {
+        if ((func == NULL) || (strcmp(nmath_alloc_sites[i].func, func) == 0)) {
+            out.calls += nmath_alloc_sites[i].count.calls;
+            out.bytes += nmath_alloc_sites[i].count.bytes;
+            out.live_num += nmath_alloc_sites[i].count.live_num;
+            out.live_bytes += nmath_alloc_sites[i].count.live_bytes;
+        }
+    }
+#endif
+    return (out);
+}
+
+void nmath_alloc_report(FILE * out) {
+#ifdef NMATH_ALLOC_DEBUG
+    struct nmath_alloc_count total = nmath_alloc_count(NULL);
+    fprintf(out, "nmath allocations: %zu calls, %zu bytes, %zu leaks, %zu bytes leaked\n", total.calls, total.bytes, total.live_num, total.live_bytes);
+    fprintf(out, "%-48s %10s %14s %10s %14s\n", "function", "calls", "bytes", "leaks", "leaked bytes");
+    for (size_t i = 0; i < nmath_alloc_sites_num; i++) {
+        struct nmath_alloc_count * count = &nmath_alloc_sites[i].count;
+        fprintf(out, "%-48s %10zu %14zu %10zu %14zu\n", nmath_alloc_sites[i].func, count->calls, count->bytes, count->live_num, count->live_bytes);
+    }
+#else
+    fprintf(out, "nmath allocations: compile with NMATH_ALLOC_DEBUG\n");
+#endif
+}
+
+/********************************* THREADS ***********************************/
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static int nmath_threads = 0;
+
+void nmath_set_threads(int threads) {
+    nmath_threads = (threads > 0) ? threads : 0;
+}
+
+int nmath_get_threads(void) {
+#ifdef _OPENMP
+    return ((nmath_threads > 0) ? nmath_threads : omp_get_max_threads());
+#else
+    return (1);
+#endif
+}
+
+/********************************** STATS ************************************/
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+uint64_t nmath_get_ns(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency = {0};
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return ((uint64_t)((1e9 * now.QuadPart) / frequency.QuadPart));
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec spec;
+    clock_gettime(CLOCK_MONOTONIC, &spec);
+    return ((uint64_t)spec.tv_sec * 1000000000ULL + (uint64_t)spec.tv_nsec);
+#else
+    return ((uint64_t)((double)clock() / CLOCKS_PER_SEC * 1e9));
+#endif
+}
+
+/* NMATH_STATS_BEGIN: resets counters, unless called by another instrumented
+*  function. NMATH_STATS_END: wall time of the outermost call.
+*  Per thread: concurrent calls do not share counters or nesting depth. */
+#ifdef NMATH_STATS
+_Thread_local struct nmath_stats nmath_stats = {0};
+static _Thread_local size_t nmath_stats_depth = 0;
+static _Thread_local uint64_t nmath_stats_start = 0;
+#define NMATH_STATS_BEGIN do {if (nmath_stats_depth++ == 0) {\
+    memset(&nmath_stats, 0, sizeof(nmath_stats));\
+    nmath_stats_start = nmath_get_ns();\
+}} while (0)
+#define NMATH_STATS_END do {if (--nmath_stats_depth == 0) {\
+    nmath_stats.ns = nmath_get_ns() - nmath_stats_start;\
+}} while (0)
+#else
+#define NMATH_STATS_BEGIN do {} while (0)
+#define NMATH_STATS_END do {} while (0)
+#endif
+
+struct nmath_stats nmath_get_stats(void) {
+#ifdef NMATH_STATS
+    return (nmath_stats);
+#else
+    struct nmath_stats out = {0};
+    return (out);
+#endif
+}
+
+/******************************** HISTOGRAMS *********************************/
+static const char * nmath_histogram_names[NMATH_HISTOGRAM_NUM] = {
+    "pathfinding_Map_Moveto_noM",
+    "pathfinding_Map_Moveto",
+    "pathfinding_Map_Moveto_Hex",
+    "pathfinding_Map_Visible_noM",
+    "pathfinding_Map_Visible",
+    "pathfinding_Map_Visible_Hex",
+    "pathfinding_Map_Attackto_noM",
+    "pathfinding_Map_Attackto",
+    "pathfinding_Map_Attackfrom_noM",
+    "pathfinding_Map_Attackfrom",
+    "pathfinding_Map_unitGradient_noM",
+    "pathfinding_Map_unitGradient",
+    "pathfinding_Astar_List",
+    "pathfinding_Astar_Map",
+};
+
+uint64_t nmath_histogram_bucket_ns(size_t bucket) {
+    if (bucket < NMATH_HISTOGRAM_SUB_LEN) {
+        return ((uint64_t)bucket);
+    }
+    size_t shift = bucket / NMATH_HISTOGRAM_SUB_LEN - 1;
+    return ((uint64_t)(NMATH_HISTOGRAM_SUB_LEN + bucket % NMATH_HISTOGRAM_SUB_LEN) << shift);
+}
+
+/* NMATH_HISTOGRAM_START: declares start time. NMATH_HISTOGRAM_END: records.
+*  One block of histograms per thread that ever recorded, in a lock-free
+*  list, kept until exit. Only the owner thread writes in a block. */
+#ifdef NMATH_HISTOGRAMS
+struct nmath_histogram {
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[NMATH_HISTOGRAM_BUCKETS];
+};
+
+struct nmath_histogram_block {
+    struct nmath_histogram histograms[NMATH_HISTOGRAM_NUM];
+    struct nmath_histogram_block * next;
+};
+
+static struct nmath_histogram_block * nmath_histogram_blocks = NULL;
+static _Thread_local struct nmath_histogram_block * nmath_histogram_block = NULL;
+
+static size_t nmath_histogram_bucket(uint64_t ns) {
+    if (ns < NMATH_HISTOGRAM_SUB_LEN) {
+        return ((size_t)ns);
+    }
+    size_t exponent = 63 - (size_t)__builtin_clzll(ns);
+    size_t shift = exponent - NMATH_HISTOGRAM_SUB_BITS;
+    return ((shift + 1) * NMATH_HISTOGRAM_SUB_LEN + (size_t)((ns >> shift) - NMATH_HISTOGRAM_SUB_LEN));
+}
+
+#define NMATH_HISTOGRAM_START uint64_t nmath_histogram_start = nmath_get_ns()
+#define NMATH_HISTOGRAM_END(histogram) nmath_histogram_record((histogram), nmath_get_ns() - nmath_histogram_start)
+
+/* Relaxed: readers may see counts a few calls old, never torn. */
+#define NMATH_HISTOGRAM_STORE(var, value) __atomic_store_n(&(var), (value), __ATOMIC_RELAXED)
+#define NMATH_HISTOGRAM_LOAD(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+
+static struct nmath_histogram_block * nmath_histogram_block_new(void) {
+    struct nmath_histogram_block * block = calloc(1, sizeof(*block));
+    if (block == NULL) {
+        return (NULL);
+    }
+    for (size_t i = 0; i < NMATH_HISTOGRAM_NUM; i++) {
+        block->histograms[i].min = UINT64_MAX;
+    }
+    block->next = __atomic_load_n(&nmath_histogram_blocks, __ATOMIC_ACQUIRE);
+    while (!__atomic_compare_exchange_n(&nmath_histogram_blocks, &block->next, block, true, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+    }
+    return (block);
+}
+#else
+#define NMATH_HISTOGRAM_START do {} while (0)
+#define NMATH_HISTOGRAM_END(histogram) do {} while (0)
+#endif
+
+void nmath_histogram_record(int histogram, uint64_t ns) {
+#ifdef NMATH_HISTOGRAMS
+    if ((histogram < 0) || (histogram >= NMATH_HISTOGRAM_NUM)) {
+        return;
+    }
+    if (nmath_histogram_block == NULL) {
+        nmath_histogram_block = nmath_histogram_block_new();
+        if (nmath_histogram_block == NULL) {
+            return;
+        }
+    }
+    struct nmath_histogram * current = &nmath_histogram_block->histograms[histogram];
+    size_t bucket = nmath_histogram_bucket(ns);
+    NMATH_HISTOGRAM_STORE(current->buckets[bucket], current->buckets[bucket] + 1);
+    NMATH_HISTOGRAM_STORE(current->count, current->count + 1);
+    if (ns < current->min) {
+        NMATH_HISTOGRAM_STORE(current->min, ns);
+    }
+    if (ns > current->max) {
+        NMATH_HISTOGRAM_STORE(current->max, ns);
+    }
+#endif
+}
+
+void nmath_histogram_buckets(int histogram, uint64_t * buckets) {
+    memset(buckets, 0, NMATH_HISTOGRAM_BUCKETS * sizeof(*buckets));
+#ifdef NMATH_HISTOGRAMS
+    struct nmath_histogram_block * block = __atomic_load_n(&nmath_histogram_blocks, __ATOMIC_ACQUIRE);
+    for (; block != NULL; block = block->next) {
+        for (size_t i = 0; i < NMATH_HISTOGRAM_BUCKETS; i++) {
+            buckets[i] += NMATH_HISTOGRAM_LOAD(block->histograms[histogram].buckets[i]);
+        }
+    }
+#endif
+}
+
+#ifdef NMATH_HISTOGRAMS
+/* Percentile: lowest value of the bucket of the ceil(count * permille / 1000)th
+*  call, clamped to exact [min, max]. */
+static uint64_t nmath_histogram_percentile(uint64_t * buckets, struct nmath_latency * latency, uint64_t permille) {
+    uint64_t rank = (latency->count * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NMATH_HISTOGRAM_BUCKETS; i++) {
+        seen += buckets[i];
+        if ((seen >= rank) && (seen > 0)) {
+            uint64_t out = nmath_histogram_bucket_ns(i);
+            out = (out < latency->min) ? latency->min : out;
+            return ((out > latency->max) ? latency->max : out);
+        }
+    }
+    return (0);
+}
+#endif
+
+struct nmath_latency nmath_histogram_get(int histogram) {
+    struct nmath_latency out = {0};
+    if ((histogram < 0) || (histogram >= NMATH_HISTOGRAM_NUM)) {
+        return (out);
+    }
+    out.name = nmath_histogram_names[histogram];
+#ifdef NMATH_HISTOGRAMS
+    uint64_t * buckets = calloc(NMATH_HISTOGRAM_BUCKETS, sizeof(*buckets));
+    if (buckets == NULL) {
+        return (out);
+    }
+    nmath_histogram_buckets(histogram, buckets);
+    out.min = UINT64_MAX;
+    struct nmath_histogram_block * block = __atomic_load_n(&nmath_histogram_blocks, __ATOMIC_ACQUIRE);
+    for (; block != NULL; block = block->next) {
+        uint64_t min = NMATH_HISTOGRAM_LOAD(block->histograms[histogram].min);
+        uint64_t max = NMATH_HISTOGRAM_LOAD(block->histograms[histogram].max);
+        out.min = (min < out.min) ? min : out.min;
+        out.max = (max > out.max) ? max : out.max;
+    }
+    for (size_t i = 0; i < NMATH_HISTOGRAM_BUCKETS; i++) {
+        out.count += buckets[i];
+    }
+    if (out.count == 0) {
+        out.min = 0;
+    }
+    out.p50 = nmath_histogram_percentile(buckets, &out, 500);
+    out.p99 = nmath_histogram_percentile(buckets, &out, 990);
+    out.p999 = nmath_histogram_percentile(buckets, &out, 999);
+    free(buckets);
+#endif
+    return (out);
+}
+
+void nmath_histogram_dump(FILE * out) {
+    fprintf(out, "%-34s %10s %12s %12s %12s %12s %12s\n", "function", "count", "min [ns]", "p50 [ns]", "p99 [ns]", "p999 [ns]", "max [ns]");
+    for (int i = 0; i < NMATH_HISTOGRAM_NUM; i++) {
+        struct nmath_latency latency = nmath_histogram_get(i);
+        if (latency.count > 0) {
+            fprintf(out, "%-34s %10llu %12llu %12llu %12llu %12llu %12llu\n", latency.name, (unsigned long long)latency.count, (unsigned long long)latency.min, (unsigned long long)latency.p50, (unsigned long long)latency.p99, (unsigned long long)latency.p999, (unsigned long long)latency.max);
+        }
+    }
+}
+
+void nmath_histogram_reset(void) {
+#ifdef NMATH_HISTOGRAMS
+    struct nmath_histogram_block * block = __atomic_load_n(&nmath_histogram_blocks, __ATOMIC_ACQUIRE);
+    for (; block != NULL; block = block->next) {
+        memset(block->histograms, 0, sizeof(block->histograms));
+        for (size_t i = 0; i < NMATH_HISTOGRAM_NUM; i++) {
+            block->histograms[i].min = UINT64_MAX;
+        }
+    }
+#endif
+}
+
+/* NMATH_PARALLEL_CHUNKS: call on NMATH_PARALLEL_CHUNK_LEN chunks [start,
+*  start + len) of arr_len elements, in parallel, then return. call is the
+*  serial kernel##_serial, never the parallel kernel: no recursion, whatever
+*  NMATH_PARALLEL_THRESHOLD is.
+*  NMATH_PARALLEL_REDUCE: same, combines chunk results into var, of type
+*  vartype and initial value init, with op. Declared in the parallel branch
+*  only: no unused variable without OpenMP. */
+#ifdef _OPENMP
+#define NMATH_PARALLEL_IF(len) (((len) >= NMATH_PARALLEL_THRESHOLD) && (nmath_get_threads() > 1))
+#define NMATH_PARALLEL_CHUNK_START(call) \
+    size_t start = chunk * NMATH_PARALLEL_CHUNK_LEN;\
+    size_t len = ((arr_len - start) < NMATH_PARALLEL_CHUNK_LEN) ? (arr_len - start) : NMATH_PARALLEL_CHUNK_LEN;\
+    call;
+#define NMATH_PARALLEL_CHUNKS(call) if (NMATH_PARALLEL_IF(arr_len)) {\
+    size_t chunk_num = (arr_len + NMATH_PARALLEL_CHUNK_LEN - 1) / NMATH_PARALLEL_CHUNK_LEN;\
+    NMATH_PRAGMA(omp parallel for num_threads(nmath_get_threads()) schedule(static))\
+    for (size_t chunk = 0; chunk < chunk_num; chunk++) {\
+        NMATH_PARALLEL_CHUNK_START(call)\
+    }\
+    return;\
+}
+#define NMATH_PARALLEL_REDUCE(vartype, var, init, op, call) if (NMATH_PARALLEL_IF(arr_len)) {\
+    vartype var = init;\
+    size_t chunk_num = (arr_len + NMATH_PARALLEL_CHUNK_LEN - 1) / NMATH_PARALLEL_CHUNK_LEN;\
+    NMATH_PRAGMA(omp parallel for num_threads(nmath_get_threads()) schedule(static) reduction(op:var))\
+    for (size_t chunk = 0; chunk < chunk_num; chunk++) {\
+        NMATH_PARALLEL_CHUNK_START(call)\
+    }\
+    return (var);\
+}
+/* NMATH_PARALLEL_FOR: next for loop in parallel, if len is large enough */
+#define NMATH_PARALLEL_FOR(len) NMATH_PRAGMA(omp parallel for if(NMATH_PARALLEL_IF(len)) num_threads(nmath_get_threads()) schedule(static))
+#else
+#define NMATH_PARALLEL_IF(len) (false)
+#define NMATH_PARALLEL_CHUNKS(call)
+#define NMATH_PARALLEL_REDUCE(vartype, var, init, op, call)
+#define NMATH_PARALLEL_FOR(len)
+#endif
 
 /*********************************** DTAB ************************************/
 
@@ -193,16 +814,6 @@ TEMPLATE_TYPES_INT
 
 /******************************** UTILITIES **********************************/
 
-#define REGISTER_ENUM(type) type nmath_inbounds_##type(type pos, type boundmin, type boundmax) {\
-    type out = 0;\
-    out = pos < boundmin ? boundmin : pos;\
-    out = out > boundmax ? boundmax : out;\
-    return (out);\
-}
-TEMPLATE_TYPES_INT
-TEMPLATE_TYPES_FLOAT
-#undef REGISTER_ENUM
-
 /********************************* Q_MATH ************************************/
 
 // sequence_geometric: Geometrically decreasing integer/float
@@ -215,49 +826,1457 @@ TEMPLATE_TYPES_FLOAT
     type out = (sign * (distance / geo_factor) < 1) ? sign : (distance / geo_factor);\
     return (out);\
 }
-TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+int32_t q_sequence_fgeometric_int32_t(int32_t current, int32_t destination, float geo_factor) {
+    int32_t distance = current - destination;\
+    int32_t sign = (int32_t )copysign(1, distance);\
+    int32_t out = (sign * (int32_t)(distance / geo_factor) < 1) ? sign : (int32_t)(distance / geo_factor);\
+    return (out);\
+
+}
+
+
+// sequence_pingpong: oscillating integer sequence. upper is excluded.
+// modulo: x % 2 = 0,1,2,0,1,2,0...for x++
+// pingpong(x, 2, 0) = 0,1,2,1,0,1,2... for x++
+#define REGISTER_ENUM(type) type q_sequence_pingpong_##type(type current, type upper, type lower) {\
+    type mod_factor = (2 * (upper - lower) - 2);\
+    type term1 = mod_factor - (current % mod_factor);\
+    type term2 = current % mod_factor;\
+    return (fmin(term1, term2) + lower);\
+}
+TEMPLATE_TYPES_INT
+#undef REGISTER_ENUM
+
+// Sometimes attributed to John Carmack...
+#define REGISTER_ENUM(type) float q_sqrt_##type(type in_int) {\
+    const float x2 = in_int * 0.5f;\
+    const float threehalfs = 1.5f;\
+    union {\
+        float f;\
+        unsigned long i;\
+    } conv  = { .f = in_int };\
+    conv.i  = 0x5f3759df - (conv.i >> 1);\
+    conv.f  *= (threehalfs - (x2 * conv.f * conv.f));\
+    return conv.f;\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/****************************** SIMD KERNELS **********************************/
+/* Element-wise kernels on NMATH_SIMD_BYTESIZE vectors, using GCC/clang vector
+*  extensions: lowered to SSE2/AVX2 on x86, NEON on ARM, even at -O0.
+*  Scalar loop for remainders, bool, integer division, and compilers without
+*  vector extensions (tcc) or with NMATH_NO_SIMD defined.
+*  Kernels are compiled once per SIMD level, see SIMD DISPATCH. */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(__TINYC__) && !defined(NMATH_NO_SIMD)
+#define NMATH_SIMD
+#endif
+#if defined(NMATH_SIMD) && defined(__x86_64__)
+#define NMATH_SIMD_X86
+#endif
+
+/****************************** SIMD DISPATCH *********************************/
+/* nmath_simd_level: index in kernel dispatch tables, -1 until detected.
+*  Detected once, on first kernel call or nmath_*_simd call. Environment
+*  variable NMATH_SIMD, a level name, caps the detected level. */
+static int nmath_simd_level = -1;
+static int nmath_simd_detected = -1;
+
+static const char * const nmath_simd_names[NMATH_SIMD_LEVEL_NUM] = {
+#ifdef NMATH_SIMD_X86
+    "scalar", "sse2", "avx2", "avx512"
+#else
+    "scalar", "vector", "avx2", "avx512"
+#endif
+};
+
+const char * nmath_simd_name(int level) {
+    return (((level >= 0) && (level < NMATH_SIMD_LEVEL_NUM)) ? nmath_simd_names[level] : "unknown");
+}
+
+int nmath_detect_simd(void) {
+    if (nmath_simd_detected >= 0) {
+        return (nmath_simd_detected);
+    }
+    int level = NMATH_SIMD_SCALAR;
+#if defined(NMATH_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq")) {
+        level = NMATH_SIMD_AVX512;
+    } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        level = NMATH_SIMD_AVX2;
+    } else {
+        level = NMATH_SIMD_SSE2;
+    }
+#elif defined(NMATH_SIMD)
+    level = NMATH_SIMD_SSE2;
+#endif
+    nmath_simd_detected = level;
+    return (level);
+}
+
+static int nmath_simd_init(void) {
+    int level = nmath_detect_simd();
+    const char * cap = getenv("NMATH_SIMD");
+    if (cap != NULL) {
+        for (int i = 0; i < level; i++) {
+            if (strcmp(cap, nmath_simd_names[i]) == 0) {
+                level = i;
+                break;
+            }
+        }
+    }
+    nmath_simd_level = level;
+    return (level);
+}
+
+void nmath_set_simd(int level) {
+    int detected = nmath_detect_simd();
+    nmath_simd_level = ((level < 0) || (level > detected)) ? detected : level;
+}
+
+int nmath_get_simd(void) {
+    return ((nmath_simd_level >= 0) ? nmath_simd_level : nmath_simd_init());
+}
+
+#define NMATH_SIMD_LEVEL ((nmath_simd_level >= 0) ? nmath_simd_level : nmath_simd_init())
+
+#ifdef NMATH_SIMD
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#endif
+
+#define NMATH_SIMD_BYTESIZE 32
+#define NMATH_SIMD_LEN(type) (NMATH_SIMD_BYTESIZE / sizeof(type))
+
+/* NMATH_DISPATCH_VARIANTS: body(kernel##_level, simd_loop, target, ...) for
+*  every SIMD level compiled in. Scalar variant: simd_loop is removed.
+*  Vectors stay NMATH_SIMD_BYTESIZE wide: AVX-512 variants gain the VL, BW
+*  and DQ instructions on 256-bit vectors (64-bit multiply, min/max, masks).
+*  NMATH_DISPATCH: static kernel(params), calling the variant of the current
+*  SIMD level through a table of function pointers. */
+#ifdef NMATH_SIMD_X86
+#define NMATH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define NMATH_TARGET_AVX512 __attribute__((target("avx512f,avx512vl,avx512bw,avx512dq,fma")))
+#define NMATH_DISPATCH_VARIANTS(body, kernel, simd_loop, ...) \
+body(kernel##_scalar, NMATH_SIMD_LOOP_NONE, , __VA_ARGS__)\
+body(kernel##_sse2, simd_loop, , __VA_ARGS__)\
+body(kernel##_avx2, simd_loop, NMATH_TARGET_AVX2, __VA_ARGS__)\
+body(kernel##_avx512, simd_loop, NMATH_TARGET_AVX512, __VA_ARGS__)
+#define NMATH_DISPATCH_TABLE(kernel) {kernel##_scalar, kernel##_sse2, kernel##_avx2, kernel##_avx512}
+#elif defined(NMATH_SIMD)
+#define NMATH_DISPATCH_VARIANTS(body, kernel, simd_loop, ...) \
+body(kernel##_scalar, NMATH_SIMD_LOOP_NONE, , __VA_ARGS__)\
+body(kernel##_sse2, simd_loop, , __VA_ARGS__)
+#define NMATH_DISPATCH_TABLE(kernel) {kernel##_scalar, kernel##_sse2, kernel##_sse2, kernel##_sse2}
+#else
+#define NMATH_DISPATCH_VARIANTS(body, kernel, simd_loop, ...) \
+body(kernel##_scalar, NMATH_SIMD_LOOP_NONE, , __VA_ARGS__)
+#define NMATH_DISPATCH_TABLE(kernel) {kernel##_scalar, kernel##_scalar, kernel##_scalar, kernel##_scalar}
+#endif
+
+#define NMATH_DISPATCH(ret, kernel, params, args) static ret (* const kernel##_table[NMATH_SIMD_LEVEL_NUM]) params = NMATH_DISPATCH_TABLE(kernel);\
+static ret kernel params {\
+    return (kernel##_table[NMATH_SIMD_LEVEL] args);\
+}
+#define NMATH_DISPATCH_VOID(kernel, params, args) static void (* const kernel##_table[NMATH_SIMD_LEVEL_NUM]) params = NMATH_DISPATCH_TABLE(kernel);\
+static void kernel params {\
+    kernel##_table[NMATH_SIMD_LEVEL] args;\
+}
+
+#ifdef NMATH_SIMD
+/* Unaligned, aliasing vector types, like __m256i_u */
+#define REGISTER_ENUM(type) typedef type nmath_vec_##type __attribute__((vector_size(NMATH_SIMD_BYTESIZE), aligned(1), may_alias));
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define NMATH_SIMD_LOOP_VV(type, op) for (; (i + NMATH_SIMD_LEN(type)) <= arr_len; i += NMATH_SIMD_LEN(type)) {\
+    *(nmath_vec_##type *)(out + i) = *(nmath_vec_##type *)(matrix1 + i) op *(nmath_vec_##type *)(matrix2 + i);\
+}
+#define NMATH_SIMD_LOOP_VS(type, op) for (; (i + NMATH_SIMD_LEN(type)) <= arr_len; i += NMATH_SIMD_LEN(type)) {\
+    *(nmath_vec_##type *)(out + i) = *(nmath_vec_##type *)(matrix + i) op value;\
+}
+#else
+#define NMATH_SIMD_LOOP_VV(type, op)
+#define NMATH_SIMD_LOOP_VS(type, op)
+#endif
+#define NMATH_SIMD_LOOP_NONE(...)
+
+/* NMATH_KERNEL_VV: out[i] = matrix1[i] op matrix2[i]. out can be matrix1. */
+#define NMATH_KERNEL_VV_BODY(kernel, simd_loop, target, type, op) target static void kernel##_serial(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
+    size_t i = 0;\
+    simd_loop(type, op)\
+    for (; i < arr_len; i++) {\
+        out[i] = matrix1[i] op matrix2[i];\
+    }\
+}\
+target static void kernel(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
+    NMATH_PARALLEL_CHUNKS(kernel##_serial(out + start, matrix1 + start, matrix2 + start, len))\
+    kernel##_serial(out, matrix1, matrix2, arr_len);\
+}
+
+/* NMATH_KERNEL_VS: out[i] = matrix[i] op value. out can be matrix. */
+#define NMATH_KERNEL_VS_BODY(kernel, simd_loop, target, type, op) target static void kernel##_serial(type * out, type * matrix, type value, size_t arr_len) {\
+    size_t i = 0;\
+    simd_loop(type, op)\
+    for (; i < arr_len; i++) {\
+        out[i] = matrix[i] op value;\
+    }\
+}\
+target static void kernel(type * out, type * matrix, type value, size_t arr_len) {\
+    NMATH_PARALLEL_CHUNKS(kernel##_serial(out + start, matrix + start, value, len))\
+    kernel##_serial(out, matrix, value, arr_len);\
+}
+
+#define NMATH_KERNEL_VV(type, kernel, op, simd_loop) NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_VV_BODY, kernel, simd_loop, type, op)\
+NMATH_DISPATCH_VOID(kernel, (type * out, type * matrix1, type * matrix2, size_t arr_len), (out, matrix1, matrix2, arr_len))
+#define NMATH_KERNEL_VS(type, kernel, op, simd_loop) NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_VS_BODY, kernel, simd_loop, type, op)\
+NMATH_DISPATCH_VOID(kernel, (type * out, type * matrix, type value, size_t arr_len), (out, matrix, value, arr_len))
+
+#define REGISTER_ENUM(type) \
+NMATH_KERNEL_VV(type, nmath_kernel_plus_##type, +, NMATH_SIMD_LOOP_VV)\
+NMATH_KERNEL_VV(type, nmath_kernel_minus_##type, -, NMATH_SIMD_LOOP_VV)\
+NMATH_KERNEL_VV(type, nmath_kernel_mult_##type, *, NMATH_SIMD_LOOP_VV)\
+NMATH_KERNEL_VS(type, nmath_kernel_plus_scalar_##type, +, NMATH_SIMD_LOOP_VS)\
+NMATH_KERNEL_VS(type, nmath_kernel_minus_scalar_##type, -, NMATH_SIMD_LOOP_VS)\
+NMATH_KERNEL_VS(type, nmath_kernel_mult_scalar_##type, *, NMATH_SIMD_LOOP_VS)
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) \
+NMATH_KERNEL_VV(type, nmath_kernel_div_##type, /, NMATH_SIMD_LOOP_VV)\
+NMATH_KERNEL_VS(type, nmath_kernel_div_scalar_##type, /, NMATH_SIMD_LOOP_VS)
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) \
+NMATH_KERNEL_VV(type, nmath_kernel_div_##type, /, NMATH_SIMD_LOOP_NONE)\
+NMATH_KERNEL_VS(type, nmath_kernel_div_scalar_##type, /, NMATH_SIMD_LOOP_NONE)
+TEMPLATE_TYPES_INT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) \
+NMATH_KERNEL_VV(type, nmath_kernel_plus_##type, +, NMATH_SIMD_LOOP_NONE)\
+NMATH_KERNEL_VV(type, nmath_kernel_minus_##type, -, NMATH_SIMD_LOOP_NONE)\
+NMATH_KERNEL_VS(type, nmath_kernel_plus_scalar_##type, +, NMATH_SIMD_LOOP_NONE)\
+NMATH_KERNEL_VS(type, nmath_kernel_minus_scalar_##type, -, NMATH_SIMD_LOOP_NONE)
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+/* Comparison kernels: out[i] = (matrix1[i] op matrix2[i]) as 0/1 in type, or
+*  as bit i of a bit_array_t mask. Vector comparisons give 0/-1 lanes:
+*  & 1 for type output, movemask for bit output. */
+#ifdef NMATH_SIMD
+typedef int8_t nmath_vbyte __attribute__((vector_size(NMATH_SIMD_BYTESIZE)));
+
+/* nmath_movemask: 1 bit per lane_bytesize lane of 0/-1 comparison result */
+static inline __attribute__((always_inline)) uint32_t nmath_movemask(nmath_vbyte * cmp, size_t lane_bytesize) {
+    uint32_t bits = 0;
+#ifdef __SSE2__
+    union {
+        nmath_vbyte vec;
+        __m128i half[2];
+    } split;
+    split.vec = *cmp;
+    switch (lane_bytesize) {
+        case 1:
+            bits = (uint32_t)_mm_movemask_epi8(split.half[0]) | ((uint32_t)_mm_movemask_epi8(split.half[1]) << 16);
+            break;
+        case 2:
+            bits = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(split.half[0], split.half[1]));
+            break;
+        case 4:
+            bits = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(split.half[0])) | ((uint32_t)_mm_movemask_ps(_mm_castsi128_ps(split.half[1])) << 4);
+            break;
+        case 8:
+            bits = (uint32_t)_mm_movemask_pd(_mm_castsi128_pd(split.half[0])) | ((uint32_t)_mm_movemask_pd(_mm_castsi128_pd(split.half[1])) << 2);
+            break;
+    }
+#else
+    for (size_t lane = 0; lane < (NMATH_SIMD_BYTESIZE / lane_bytesize); lane++) {
+        bits |= (uint32_t)((*cmp)[lane * lane_bytesize] & 1) << lane;
+    }
+#endif
+    return (bits);
+}
+
+#define NMATH_SIMD_LOOP_CMP_VV(type, op) for (; (i + NMATH_SIMD_LEN(type)) <= arr_len; i += NMATH_SIMD_LEN(type)) {\
+    *(nmath_vec_##type *)(out + i) = ((nmath_vec_##type)(*(nmath_vec_##type *)(matrix1 + i) op *(nmath_vec_##type *)(matrix2 + i))) & 1;\
+}
+#define NMATH_SIMD_LOOP_CMP_VS(type, op) for (; (i + NMATH_SIMD_LEN(type)) <= arr_len; i += NMATH_SIMD_LEN(type)) {\
+    *(nmath_vec_##type *)(out + i) = ((nmath_vec_##type)(*(nmath_vec_##type *)(matrix + i) op value)) & 1;\
+}
+#define NMATH_SIMD_LOOP_BITMASK_VV(type, op) for (; (i + NMATH_SIMD_LEN(type)) <= arr_len; i += NMATH_SIMD_LEN(type)) {\
+    nmath_vbyte cmp = (nmath_vbyte)(*(nmath_vec_##type *)(matrix1 + i) op *(nmath_vec_##type *)(matrix2 + i));\
+    NMATH_BITMASK_WRITE(mask, i, nmath_movemask(&cmp, sizeof(type)));\
+}
+#define NMATH_SIMD_LOOP_BITMASK_VS(type, op) for (; (i + NMATH_SIMD_LEN(type)) <= arr_len; i += NMATH_SIMD_LEN(type)) {\
+    nmath_vbyte cmp = (nmath_vbyte)(*(nmath_vec_##type *)(matrix + i) op value);\
+    NMATH_BITMASK_WRITE(mask, i, nmath_movemask(&cmp, sizeof(type)));\
+}
+#else
+#define NMATH_SIMD_LOOP_CMP_VV(type, op)
+#define NMATH_SIMD_LOOP_CMP_VS(type, op)
+#define NMATH_SIMD_LOOP_BITMASK_VV(type, op)
+#define NMATH_SIMD_LOOP_BITMASK_VS(type, op)
+#endif
+
+/* NMATH_BITMASK_WRITE: or bits into mask from bit i. Clears each word first:
+*  vector lengths divide NMATH_BIT_ARRAY_BITSPER, so bits never straddle words. */
+#define NMATH_BITMASK_WRITE(mask, i, bits) do {\
+    if (((i) % NMATH_BIT_ARRAY_BITSPER) == 0) {\
+        mask[(i) / NMATH_BIT_ARRAY_BITSPER] = 0;\
+    }\
+    mask[(i) / NMATH_BIT_ARRAY_BITSPER] |= ((bit_array_t)(bits)) << ((i) % NMATH_BIT_ARRAY_BITSPER);\
+} while(0)
+
+#define NMATH_KERNEL_CMP_VV_BODY(kernel, simd_loop, target, type, op) target static void kernel##_serial(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
+    size_t i = 0;\
+    simd_loop(type, op)\
+    for (; i < arr_len; i++) {\
+        out[i] = (matrix1[i] op matrix2[i]);\
+    }\
+}\
+target static void kernel(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
+    NMATH_PARALLEL_CHUNKS(kernel##_serial(out + start, matrix1 + start, matrix2 + start, len))\
+    kernel##_serial(out, matrix1, matrix2, arr_len);\
+}
+
+#define NMATH_KERNEL_CMP_VS_BODY(kernel, simd_loop, target, type, op) target static void kernel##_serial(type * out, type * matrix, type value, size_t arr_len) {\
+    size_t i = 0;\
+    simd_loop(type, op)\
+    for (; i < arr_len; i++) {\
+        out[i] = (matrix[i] op value);\
+    }\
+}\
+target static void kernel(type * out, type * matrix, type value, size_t arr_len) {\
+    NMATH_PARALLEL_CHUNKS(kernel##_serial(out + start, matrix + start, value, len))\
+    kernel##_serial(out, matrix, value, arr_len);\
+}
+
+#define NMATH_KERNEL_BITMASK_VV_BODY(kernel, simd_loop, target, type, op) target static void kernel##_serial(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len) {\
+    size_t i = 0;\
+    simd_loop(type, op)\
+    for (; i < arr_len; i++) {\
+        NMATH_BITMASK_WRITE(mask, i, (matrix1[i] op matrix2[i]));\
+    }\
+}\
+target static void kernel(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len) {\
+    NMATH_PARALLEL_CHUNKS(kernel##_serial(mask + start / NMATH_BIT_ARRAY_BITSPER, matrix1 + start, matrix2 + start, len))\
+    kernel##_serial(mask, matrix1, matrix2, arr_len);\
+}
+
+#define NMATH_KERNEL_BITMASK_VS_BODY(kernel, simd_loop, target, type, op) target static void kernel##_serial(bit_array_t * mask, type * matrix, type value, size_t arr_len) {\
+    size_t i = 0;\
+    simd_loop(type, op)\
+    for (; i < arr_len; i++) {\
+        NMATH_BITMASK_WRITE(mask, i, (matrix[i] op value));\
+    }\
+}\
+target static void kernel(bit_array_t * mask, type * matrix, type value, size_t arr_len) {\
+    NMATH_PARALLEL_CHUNKS(kernel##_serial(mask + start / NMATH_BIT_ARRAY_BITSPER, matrix + start, value, len))\
+    kernel##_serial(mask, matrix, value, arr_len);\
+}
+
+#define NMATH_KERNEL_CMP_VV(type, kernel, op, simd_loop) NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_CMP_VV_BODY, kernel, simd_loop, type, op)\
+NMATH_DISPATCH_VOID(kernel, (type * out, type * matrix1, type * matrix2, size_t arr_len), (out, matrix1, matrix2, arr_len))
+#define NMATH_KERNEL_CMP_VS(type, kernel, op, simd_loop) NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_CMP_VS_BODY, kernel, simd_loop, type, op)\
+NMATH_DISPATCH_VOID(kernel, (type * out, type * matrix, type value, size_t arr_len), (out, matrix, value, arr_len))
+#define NMATH_KERNEL_BITMASK_VV(type, kernel, op, simd_loop) NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_BITMASK_VV_BODY, kernel, simd_loop, type, op)\
+NMATH_DISPATCH_VOID(kernel, (bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len), (mask, matrix1, matrix2, arr_len))
+#define NMATH_KERNEL_BITMASK_VS(type, kernel, op, simd_loop) NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_BITMASK_VS_BODY, kernel, simd_loop, type, op)\
+NMATH_DISPATCH_VOID(kernel, (bit_array_t * mask, type * matrix, type value, size_t arr_len), (mask, matrix, value, arr_len))
+
+/* suffix: _##type, pasted by the caller so that bool is not expanded to _Bool */
+#define NMATH_KERNELS_CMP(type, suffix, cmp_vv, cmp_vs, bitmask_vv, bitmask_vs) \
+NMATH_KERNEL_CMP_VV(type, nmath_kernel_smaller##suffix, <, cmp_vv)\
+NMATH_KERNEL_CMP_VV(type, nmath_kernel_seq##suffix, <=, cmp_vv)\
+NMATH_KERNEL_CMP_VV(type, nmath_kernel_greater##suffix, >, cmp_vv)\
+NMATH_KERNEL_CMP_VV(type, nmath_kernel_geq##suffix, >=, cmp_vv)\
+NMATH_KERNEL_CMP_VV(type, nmath_kernel_equal##suffix, ==, cmp_vv)\
+NMATH_KERNEL_CMP_VS(type, nmath_kernel_ssmaller##suffix, <, cmp_vs)\
+NMATH_KERNEL_CMP_VS(type, nmath_kernel_sseq##suffix, <=, cmp_vs)\
+NMATH_KERNEL_CMP_VS(type, nmath_kernel_sgreater##suffix, >, cmp_vs)\
+NMATH_KERNEL_CMP_VS(type, nmath_kernel_sgeq##suffix, >=, cmp_vs)\
+NMATH_KERNEL_BITMASK_VV(type, nmath_kernel_smaller_bitmask##suffix, <, bitmask_vv)\
+NMATH_KERNEL_BITMASK_VV(type, nmath_kernel_seq_bitmask##suffix, <=, bitmask_vv)\
+NMATH_KERNEL_BITMASK_VV(type, nmath_kernel_greater_bitmask##suffix, >, bitmask_vv)\
+NMATH_KERNEL_BITMASK_VV(type, nmath_kernel_geq_bitmask##suffix, >=, bitmask_vv)\
+NMATH_KERNEL_BITMASK_VV(type, nmath_kernel_equal_bitmask##suffix, ==, bitmask_vv)\
+NMATH_KERNEL_BITMASK_VS(type, nmath_kernel_ssmaller_bitmask##suffix, <, bitmask_vs)\
+NMATH_KERNEL_BITMASK_VS(type, nmath_kernel_sseq_bitmask##suffix, <=, bitmask_vs)\
+NMATH_KERNEL_BITMASK_VS(type, nmath_kernel_sgreater_bitmask##suffix, >, bitmask_vs)\
+NMATH_KERNEL_BITMASK_VS(type, nmath_kernel_sgeq_bitmask##suffix, >=, bitmask_vs)
+
+#define REGISTER_ENUM(type) NMATH_KERNELS_CMP(type, _##type, NMATH_SIMD_LOOP_CMP_VV, NMATH_SIMD_LOOP_CMP_VS, NMATH_SIMD_LOOP_BITMASK_VV, NMATH_SIMD_LOOP_BITMASK_VS)
+TEMPLATE_TYPES_INT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) NMATH_KERNELS_CMP(type, _##type, NMATH_SIMD_LOOP_NONE, NMATH_SIMD_LOOP_NONE, NMATH_SIMD_LOOP_NONE, NMATH_SIMD_LOOP_NONE)
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+/* Floats: equal within tolerance, |matrix1[i] - matrix2[i]| < tolerance */
+#ifdef NMATH_SIMD
+#define NMATH_SIMD_LOOP_BITMASK_TOL(type) for (; (i + NMATH_SIMD_LEN(type)) <= arr_len; i += NMATH_SIMD_LEN(type)) {\
+    nmath_vec_##type diff = *(nmath_vec_##type *)(matrix1 + i) - *(nmath_vec_##type *)(matrix2 + i);\
+    nmath_vbyte cmp = (nmath_vbyte)((diff < tolerance) & (-diff < tolerance));\
+    NMATH_BITMASK_WRITE(mask, i, nmath_movemask(&cmp, sizeof(type)));\
+}
+#else
+#define NMATH_SIMD_LOOP_BITMASK_TOL(type)
+#endif
+
+#define NMATH_KERNEL_BITMASK_TOL_BODY(kernel, simd_loop, target, type) target static void kernel##_serial(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len, type tolerance) {\
+    size_t i = 0;\
+    simd_loop(type)\
+    for (; i < arr_len; i++) {\
+        NMATH_BITMASK_WRITE(mask, i, (fabs(matrix1[i] - matrix2[i]) < tolerance));\
+    }\
+}\
+target static void kernel(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len, type tolerance) {\
+    NMATH_PARALLEL_CHUNKS(kernel##_serial(mask + start / NMATH_BIT_ARRAY_BITSPER, matrix1 + start, matrix2 + start, len, tolerance))\
+    kernel##_serial(mask, matrix1, matrix2, arr_len, tolerance);\
+}
+
+#define REGISTER_ENUM(type) NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_BITMASK_TOL_BODY, nmath_kernel_equal_bitmask_##type, NMATH_SIMD_LOOP_BITMASK_TOL, type)\
+NMATH_DISPATCH_VOID(nmath_kernel_equal_bitmask_##type, (bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len, type tolerance), (mask, matrix1, matrix2, arr_len, tolerance))
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* Floats: comparison and mask kernels give 1.0 or 0.0. Vector comparisons
+*  give 0/-1 integer lanes: & with the bits of 1.0 in an integer vector as
+*  wide as type, itype. */
+#ifdef NMATH_SIMD
+#define NMATH_VEC_ONES(type, itype, cmp) ((nmath_vec_##type)((nmath_vec_##itype)(cmp) & (nmath_vec_##itype)((nmath_vec_##type){0} + (type)1)))
+
+#define NMATH_SIMD_LOOP_CMP_VV_ONES(type, itype, op) for (; (i + NMATH_SIMD_LEN(type)) <= arr_len; i += NMATH_SIMD_LEN(type)) {\
+    *(nmath_vec_##type *)(out + i) = NMATH_VEC_ONES(type, itype, *(nmath_vec_##type *)(matrix1 + i) op *(nmath_vec_##type *)(matrix2 + i));\
+}
+#define NMATH_SIMD_LOOP_CMP_VS_ONES(type, itype, op) for (; (i + NMATH_SIMD_LEN(type)) <= arr_len; i += NMATH_SIMD_LEN(type)) {\
+    *(nmath_vec_##type *)(out + i) = NMATH_VEC_ONES(type, itype, *(nmath_vec_##type *)(matrix + i) op value);\
+}
+#define NMATH_SIMD_LOOP_MASK(type, itype) for (; (i + NMATH_SIMD_LEN(type)) <= arr_len; i += NMATH_SIMD_LEN(type)) {\
+    *(nmath_vec_##type *)(out + i) = NMATH_VEC_ONES(type, itype, (*(nmath_vec_##type *)(matrix + i) != 0) & (*(nmath_vec_##type *)(mask + i) > 0));\
+}
+#else
+#define NMATH_SIMD_LOOP_CMP_VV_ONES(type, itype, op)
+#define NMATH_SIMD_LOOP_CMP_VS_ONES(type, itype, op)
+#define NMATH_SIMD_LOOP_MASK(type, itype)
+#endif
+
+#define NMATH_SIMD_LOOP_CMP_VV_float(type, op) NMATH_SIMD_LOOP_CMP_VV_ONES(type, int32_t, op)
+#define NMATH_SIMD_LOOP_CMP_VS_float(type, op) NMATH_SIMD_LOOP_CMP_VS_ONES(type, int32_t, op)
+#define NMATH_SIMD_LOOP_CMP_VV_double(type, op) NMATH_SIMD_LOOP_CMP_VV_ONES(type, int64_t, op)
+#define NMATH_SIMD_LOOP_CMP_VS_double(type, op) NMATH_SIMD_LOOP_CMP_VS_ONES(type, int64_t, op)
+
+#define REGISTER_ENUM(type) \
+NMATH_KERNEL_CMP_VV(type, nmath_kernel_smaller_##type, <, NMATH_SIMD_LOOP_CMP_VV_##type)\
+NMATH_KERNEL_CMP_VV(type, nmath_kernel_seq_##type, <=, NMATH_SIMD_LOOP_CMP_VV_##type)\
+NMATH_KERNEL_CMP_VV(type, nmath_kernel_greater_##type, >, NMATH_SIMD_LOOP_CMP_VV_##type)\
+NMATH_KERNEL_CMP_VV(type, nmath_kernel_geq_##type, >=, NMATH_SIMD_LOOP_CMP_VV_##type)\
+NMATH_KERNEL_CMP_VV(type, nmath_kernel_equal_##type, ==, NMATH_SIMD_LOOP_CMP_VV_##type)\
+NMATH_KERNEL_CMP_VS(type, nmath_kernel_ssmaller_##type, <, NMATH_SIMD_LOOP_CMP_VS_##type)\
+NMATH_KERNEL_CMP_VS(type, nmath_kernel_sseq_##type, <=, NMATH_SIMD_LOOP_CMP_VS_##type)\
+NMATH_KERNEL_CMP_VS(type, nmath_kernel_sgreater_##type, >, NMATH_SIMD_LOOP_CMP_VS_##type)\
+NMATH_KERNEL_CMP_VS(type, nmath_kernel_sgeq_##type, >=, NMATH_SIMD_LOOP_CMP_VS_##type)
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* NMATH_KERNEL_MASK: out[i] = matrix[i] && (mask[i] > 0), like linalg_mask */
+#define NMATH_KERNEL_MASK_BODY(kernel, simd_loop, target, type, itype) target static void kernel##_serial(type * out, type * matrix, type * mask, size_t arr_len) {\
+    size_t i = 0;\
+    simd_loop(type, itype)\
+    for (; i < arr_len; i++) {\
+        out[i] = matrix[i] && (mask[i] > 0);\
+    }\
+}\
+target static void kernel(type * out, type * matrix, type * mask, size_t arr_len) {\
+    NMATH_PARALLEL_CHUNKS(kernel##_serial(out + start, matrix + start, mask + start, len))\
+    kernel##_serial(out, matrix, mask, arr_len);\
+}
+#define NMATH_KERNEL_MASK(type, itype, kernel) NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_MASK_BODY, kernel, NMATH_SIMD_LOOP_MASK, type, itype)\
+NMATH_DISPATCH_VOID(kernel, (type * out, type * matrix, type * mask, size_t arr_len), (out, matrix, mask, arr_len))
+
+#define REGISTER_ENUM(type) NMATH_KERNEL_MASK(type, type, nmath_kernel_mask_##type)
+TEMPLATE_TYPES_INT
+#undef REGISTER_ENUM
+
+NMATH_KERNEL_MASK(float, int32_t, nmath_kernel_mask_float)
+NMATH_KERNEL_MASK(double, int64_t, nmath_kernel_mask_double)
+
+/* Reductions: blocks of NMATH_REDUCE_UNROLL vectors, independent accumulators.
+*  any/all/isIn test a whole block with one movemask and exit early. */
+#define NMATH_REDUCE_UNROLL 4
+#define NMATH_REDUCE_BLOCK(type) (NMATH_REDUCE_UNROLL * NMATH_SIMD_LEN(type))
+
+#ifdef NMATH_SIMD
+#define NMATH_VEC_AT(type, array, i) (*(nmath_vec_##type *)((array) + (i)))
+
+#define NMATH_SIMD_LOOP_FIND(type, op) for (; (i + NMATH_REDUCE_BLOCK(type)) <= arr_len; i += NMATH_REDUCE_BLOCK(type)) {\
+    nmath_vbyte cmp = (nmath_vbyte)((NMATH_VEC_AT(type, matrix, i) op value)\
+                                  | (NMATH_VEC_AT(type, matrix, i + NMATH_SIMD_LEN(type)) op value)\
+                                  | (NMATH_VEC_AT(type, matrix, i + 2 * NMATH_SIMD_LEN(type)) op value)\
+                                  | (NMATH_VEC_AT(type, matrix, i + 3 * NMATH_SIMD_LEN(type)) op value));\
+    if (nmath_movemask(&cmp, sizeof(type))) {\
+        return (true);\
+    }\
+}
+
+#define NMATH_SIMD_LOOP_COUNT(type) for (; (i + NMATH_SIMD_LEN(type)) <= arr_len; i += NMATH_SIMD_LEN(type)) {\
+    nmath_vbyte cmp = (nmath_vbyte)(NMATH_VEC_AT(type, matrix, i) == value);\
+    count += (size_t)__builtin_popcount(nmath_movemask(&cmp, sizeof(type)));\
+}
+
+#define NMATH_SIMD_LOOP_SUM(type) if (arr_len >= NMATH_REDUCE_BLOCK(type)) {\
+    nmath_vec_##type acc[NMATH_REDUCE_UNROLL] = {0};\
+    for (; (i + NMATH_REDUCE_BLOCK(type)) <= arr_len; i += NMATH_REDUCE_BLOCK(type)) {\
+        for (size_t k = 0; k < NMATH_REDUCE_UNROLL; k++) {\
+            acc[k] += NMATH_VEC_AT(type, matrix, i + k * NMATH_SIMD_LEN(type));\
+        }\
+    }\
+    acc[0] = (acc[0] + acc[1]) + (acc[2] + acc[3]);\
+    for (size_t lane = 0; lane < NMATH_SIMD_LEN(type); lane++) {\
+        sum[0] += acc[0][lane];\
+    }\
+}
+
+/* Branchless lane select through an integer vector of the same lane width:
+*  vector ?: is C++ only in GCC */
+#define NMATH_VEC_SELECT(type, itype, mask, a, b) ((nmath_vec_##type)(((nmath_vec_##itype)(mask) & (nmath_vec_##itype)(a)) | (~(nmath_vec_##itype)(mask) & (nmath_vec_##itype)(b))))
+
+#define NMATH_SIMD_LOOP_EXTREMUM(type, itype, op) if (arr_len >= NMATH_REDUCE_BLOCK(type)) {\
+    nmath_vec_##type acc[NMATH_REDUCE_UNROLL];\
+    for (size_t k = 0; k < NMATH_REDUCE_UNROLL; k++) {\
+        acc[k] = NMATH_VEC_AT(type, matrix, k * NMATH_SIMD_LEN(type));\
+    }\
+    for (i = NMATH_REDUCE_BLOCK(type); (i + NMATH_REDUCE_BLOCK(type)) <= arr_len; i += NMATH_REDUCE_BLOCK(type)) {\
+        for (size_t k = 0; k < NMATH_REDUCE_UNROLL; k++) {\
+            nmath_vec_##type vec = NMATH_VEC_AT(type, matrix, i + k * NMATH_SIMD_LEN(type));\
+            acc[k] = NMATH_VEC_SELECT(type, itype, vec op acc[k], vec, acc[k]);\
+        }\
+    }\
+    for (size_t k = 1; k < NMATH_REDUCE_UNROLL; k++) {\
+        acc[0] = NMATH_VEC_SELECT(type, itype, acc[k] op acc[0], acc[k], acc[0]);\
+    }\
+    for (size_t lane = 0; lane < NMATH_SIMD_LEN(type); lane++) {\
+        extremum[0] = (acc[0][lane] op extremum[0]) ? acc[0][lane] : extremum[0];\
+    }\
+}
+#else
+#define NMATH_SIMD_LOOP_FIND(type, op)
+#define NMATH_SIMD_LOOP_COUNT(type)
+#define NMATH_SIMD_LOOP_SUM(type)
+#define NMATH_SIMD_LOOP_EXTREMUM(type, itype, op)
+#endif
+
+/* NMATH_KERNEL_FIND: true if any matrix[i] op value */
+#define NMATH_KERNEL_FIND_BODY(kernel, simd_loop, target, type, op) target static bool kernel##_serial(type * matrix, type value, size_t arr_len) {\
+    size_t i = 0;\
+    simd_loop(type, op)\
+    for (; i < arr_len; i++) {\
+        if (matrix[i] op value) {\
+            return (true);\
+        }\
+    }\
+    return (false);\
+}\
+target static bool kernel(type * matrix, type value, size_t arr_len) {\
+    NMATH_PARALLEL_REDUCE(bool, found, false, ||, found = found || kernel##_serial(matrix + start, value, len))\
+    return (kernel##_serial(matrix, value, arr_len));\
+}
+#define NMATH_KERNEL_FIND(type, kernel, op) NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_FIND_BODY, kernel, NMATH_SIMD_LOOP_FIND, type, op)\
+NMATH_DISPATCH(bool, kernel, (type * matrix, type value, size_t arr_len), (matrix, value, arr_len))
+
+#define NMATH_KERNEL_COUNT_BODY(kernel, simd_loop, target, type) target static size_t kernel##_serial(type * matrix, type value, size_t arr_len) {\
+    size_t i = 0, count = 0;\
+    simd_loop(type)\
+    for (; i < arr_len; i++) {\
+        count += (matrix[i] == value);\
+    }\
+    return (count);\
+}\
+target static size_t kernel(type * matrix, type value, size_t arr_len) {\
+    NMATH_PARALLEL_REDUCE(size_t, count, 0, +, count += kernel##_serial(matrix + start, value, len))\
+    return (kernel##_serial(matrix, value, arr_len));\
+}
+
+#define NMATH_KERNEL_SUM_BODY(kernel, simd_loop, target, type) target static type kernel##_serial(type * matrix, size_t arr_len) {\
+    size_t i = 0;\
+    type sum[NMATH_REDUCE_UNROLL] = {0};\
+    simd_loop(type)\
+    for (; (i + NMATH_REDUCE_UNROLL) <= arr_len; i += NMATH_REDUCE_UNROLL) {\
+        for (size_t k = 0; k < NMATH_REDUCE_UNROLL; k++) {\
+            sum[k] += matrix[i + k];\
+        }\
+    }\
+    for (; i < arr_len; i++) {\
+        sum[0] += matrix[i];\
+    }\
+    return ((sum[0] + sum[1]) + (sum[2] + sum[3]));\
+}\
+target static type kernel(type * matrix, size_t arr_len) {\
+    NMATH_PARALLEL_REDUCE(type, total, 0, +, total += kernel##_serial(matrix + start, len))\
+    return (kernel##_serial(matrix, arr_len));\
+}
+
+#define REGISTER_ENUM(type) \
+NMATH_KERNEL_FIND(type, nmath_kernel_find_equal_##type, ==)\
+NMATH_KERNEL_FIND(type, nmath_kernel_find_nequal_##type, !=)\
+NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_COUNT_BODY, nmath_kernel_count_##type, NMATH_SIMD_LOOP_COUNT, type)\
+NMATH_DISPATCH(size_t, nmath_kernel_count_##type, (type * matrix, type value, size_t arr_len), (matrix, value, arr_len))\
+NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_SUM_BODY, nmath_kernel_sum_##type, NMATH_SIMD_LOOP_SUM, type)\
+NMATH_DISPATCH(type, nmath_kernel_sum_##type, (type * matrix, size_t arr_len), (matrix, arr_len))
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* NMATH_KERNEL_EXTREMUM: min with <, max with >. arr_len > 0.
+*  reduction: OpenMP reduction, min or max
+*  itype: integer lane type as wide as type, for NMATH_VEC_SELECT */
+#define NMATH_KERNEL_EXTREMUM_BODY(kernel, simd_loop, target, type, itype, op, reduction) target static type kernel##_serial(type * matrix, size_t arr_len) {\
+    size_t i = 0;\
+    type extremum[NMATH_REDUCE_UNROLL] = {matrix[0], matrix[0], matrix[0], matrix[0]};\
+    simd_loop(type, itype, op)\
+    for (; (i + NMATH_REDUCE_UNROLL) <= arr_len; i += NMATH_REDUCE_UNROLL) {\
+        for (size_t k = 0; k < NMATH_REDUCE_UNROLL; k++) {\
+            extremum[k] = (matrix[i + k] op extremum[k]) ? matrix[i + k] : extremum[k];\
+        }\
+    }\
+    for (; i < arr_len; i++) {\
+        extremum[0] = (matrix[i] op extremum[0]) ? matrix[i] : extremum[0];\
+    }\
+    for (size_t k = 1; k < NMATH_REDUCE_UNROLL; k++) {\
+        extremum[0] = (extremum[k] op extremum[0]) ? extremum[k] : extremum[0];\
+    }\
+    return (extremum[0]);\
+}\
+target static type kernel(type * matrix, size_t arr_len) {\
+    NMATH_PARALLEL_REDUCE(type, parallel, matrix[0], reduction, type chunk_extremum = kernel##_serial(matrix + start, len); parallel = (chunk_extremum op parallel) ? chunk_extremum : parallel)\
+    return (kernel##_serial(matrix, arr_len));\
+}
+#define NMATH_KERNEL_EXTREMUM(type, itype, kernel, op, reduction) NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_EXTREMUM_BODY, kernel, NMATH_SIMD_LOOP_EXTREMUM, type, itype, op, reduction)\
+NMATH_DISPATCH(type, kernel, (type * matrix, size_t arr_len), (matrix, arr_len))
+
+#define REGISTER_ENUM(type) \
+NMATH_KERNEL_EXTREMUM(type, type, nmath_kernel_min_##type, <, min)\
+NMATH_KERNEL_EXTREMUM(type, type, nmath_kernel_max_##type, >, max)
+TEMPLATE_TYPES_INT
+#undef REGISTER_ENUM
+
+NMATH_KERNEL_EXTREMUM(float, int32_t, nmath_kernel_min_float, <, min)
+NMATH_KERNEL_EXTREMUM(float, int32_t, nmath_kernel_max_float, >, max)
+NMATH_KERNEL_EXTREMUM(double, int64_t, nmath_kernel_min_double, <, min)
+NMATH_KERNEL_EXTREMUM(double, int64_t, nmath_kernel_max_double, >, max)
+
+/* GEMM: out = matrix1 * matrix2, BLIS-style. matrix2 is packed in KC x NC
+*  blocks of NR-column micro-panels (L2/L3), matrix1 in MC x KC blocks of
+*  MR-row micro-panels (L2). The micro-kernel keeps an MR x NR tile of out
+*  in MR * 2 vector registers. Panels are zero-padded: no edge cases in the
+*  k loop. Dispatched like the other kernels: AVX2 and AVX-512 variants
+*  use FMA. */
+#define NMATH_GEMM_MR 4
+#define NMATH_GEMM_NR(type) (2 * NMATH_SIMD_LEN(type))
+
+/* packA[ir * kc + k * MR + r] = matrix1[(ir + r) * ld + k] */
+#define REGISTER_ENUM(type) static void nmath_gemm_packA_##type(type * packA, type * matrix1, size_t ld, size_t mc, size_t kc) {\
+    for (size_t ir = 0; ir < mc; ir += NMATH_GEMM_MR) {\
+        for (size_t k = 0; k < kc; k++) {\
+            for (size_t r = 0; r < NMATH_GEMM_MR; r++) {\
+                *packA++ = ((ir + r) < mc) ? matrix1[(ir + r) * ld + k] : 0;\
+            }\
+        }\
+    }\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* packB[jr * kc + k * NR + c] = matrix2[k * ld + jr + c] */
+#define REGISTER_ENUM(type) static void nmath_gemm_packB_##type(type * packB, type * matrix2, size_t ld, size_t kc, size_t nc) {\
+    for (size_t jr = 0; jr < nc; jr += NMATH_GEMM_NR(type)) {\
+        size_t nr = ((nc - jr) < NMATH_GEMM_NR(type)) ? (nc - jr) : NMATH_GEMM_NR(type);\
+        for (size_t k = 0; k < kc; k++) {\
+            memcpy(packB, matrix2 + k * ld + jr, nr * sizeof(type));\
+            memset(packB + nr, 0, (NMATH_GEMM_NR(type) - nr) * sizeof(type));\
+            packB += NMATH_GEMM_NR(type);\
+        }\
+    }\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* out[mr x nr] += packA panel * packB panel. ld: row length of out.
+*  Vector micro-kernel: MR x NR tile in MR * 2 vectors, then return. */
+#ifdef NMATH_SIMD
+#define NMATH_SIMD_LOOP_GEMM(type) {\
+    nmath_vec_##type acc[NMATH_GEMM_MR][2] = {0};\
+    for (size_t k = 0; k < kc; k++) {\
+        nmath_vec_##type b0 = *(nmath_vec_##type *)(packB + k * NMATH_GEMM_NR(type));\
+        nmath_vec_##type b1 = *(nmath_vec_##type *)(packB + k * NMATH_GEMM_NR(type) + NMATH_SIMD_LEN(type));\
+        for (size_t r = 0; r < NMATH_GEMM_MR; r++) {\
+            type a = packA[k * NMATH_GEMM_MR + r];\
+            acc[r][0] += a * b0;\
+            acc[r][1] += a * b1;\
+        }\
+    }\
+    if ((mr == NMATH_GEMM_MR) && (nr == NMATH_GEMM_NR(type))) {\
+        for (size_t r = 0; r < NMATH_GEMM_MR; r++) {\
+            *(nmath_vec_##type *)(out + r * ld) += acc[r][0];\
+            *(nmath_vec_##type *)(out + r * ld + NMATH_SIMD_LEN(type)) += acc[r][1];\
+        }\
+    } else {\
+        for (size_t r = 0; r < mr; r++) {\
+            for (size_t c = 0; c < nr; c++) {\
+                out[r * ld + c] += acc[r][c / NMATH_SIMD_LEN(type)][c % NMATH_SIMD_LEN(type)];\
+            }\
+        }\
+    }\
+    return;\
+}
+#else
+#define NMATH_SIMD_LOOP_GEMM(type)
+#endif
+#define NMATH_GEMM_KERNEL_BODY(kernel, simd_loop, target, type) target static void kernel(type * out, size_t ld, type * packA, type * packB, size_t kc, size_t mr, size_t nr) {\
+    simd_loop(type)\
+    type acc[NMATH_GEMM_MR][NMATH_GEMM_NR(type)];\
+    memset(acc, 0, sizeof(acc));\
+    for (size_t k = 0; k < kc; k++) {\
+        for (size_t r = 0; r < NMATH_GEMM_MR; r++) {\
+            type a = packA[k * NMATH_GEMM_MR + r];\
+            for (size_t c = 0; c < NMATH_GEMM_NR(type); c++) {\
+                acc[r][c] += a * packB[k * NMATH_GEMM_NR(type) + c];\
+            }\
+        }\
+    }\
+    for (size_t r = 0; r < mr; r++) {\
+        for (size_t c = 0; c < nr; c++) {\
+            out[r * ld + c] += acc[r][c];\
+        }\
+    }\
+}
+#define REGISTER_ENUM(type) NMATH_DISPATCH_VARIANTS(NMATH_GEMM_KERNEL_BODY, nmath_gemm_kernel_##type, NMATH_SIMD_LOOP_GEMM, type)\
+NMATH_DISPATCH_VOID(nmath_gemm_kernel_##type, (type * out, size_t ld, type * packA, type * packB, size_t kc, size_t mr, size_t nr), (out, ld, packA, packB, kc, mr, nr))
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* out[i] += value * matrix[i] */
+#ifdef NMATH_SIMD
+#define NMATH_SIMD_LOOP_AXPY(type) for (; (i + NMATH_SIMD_LEN(type)) <= arr_len; i += NMATH_SIMD_LEN(type)) {\
+    *(nmath_vec_##type *)(out + i) += value * *(nmath_vec_##type *)(matrix + i);\
+}
+#else
+#define NMATH_SIMD_LOOP_AXPY(type)
+#endif
+#define NMATH_KERNEL_AXPY_BODY(kernel, simd_loop, target, type) target static void kernel(type * out, type * matrix, type value, size_t arr_len) {\
+    size_t i = 0;\
+    simd_loop(type)\
+    for (; i < arr_len; i++) {\
+        out[i] += value * matrix[i];\
+    }\
+}
+#define REGISTER_ENUM(type) NMATH_DISPATCH_VARIANTS(NMATH_KERNEL_AXPY_BODY, nmath_kernel_axpy_##type, NMATH_SIMD_LOOP_AXPY, type)\
+NMATH_DISPATCH_VOID(nmath_kernel_axpy_##type, (type * out, type * matrix, type value, size_t arr_len), (out, matrix, value, arr_len))
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/********************************* LINALG ************************************/
+
+/* LU: right-looking, NMATH_LU_BLOCK columns at a time. Each panel is factored
+*  column by column with partial pivoting, then U12 = L11^-1 * A12 and the
+*  trailing matrix A22 -= L21 * U12, row by row for contiguous inner loops.
+*  Whole rows are swapped: pivots[k] is the row swapped with row k. */
+#define REGISTER_ENUM(type) int linalg_lu_noM_##type(type * lu, size_t * pivots, size_t sq_len) {\
+    int sign = 1;\
+    bool singular = false;\
+    for (size_t k0 = 0; k0 < sq_len; k0 += NMATH_LU_BLOCK) {\
+        size_t k_end = ((sq_len - k0) < NMATH_LU_BLOCK) ? sq_len : (k0 + NMATH_LU_BLOCK);\
+        for (size_t k = k0; k < k_end; k++) {\
+            size_t pivot = k;\
+            for (size_t i = k + 1; i < sq_len; i++) {\
+                if (fabs(lu[i * sq_len + k]) > fabs(lu[pivot * sq_len + k])) {\
+                    pivot = i;\
+                }\
+            }\
+            pivots[k] = pivot;\
+            if (lu[pivot * sq_len + k] == 0) {\
+                singular = true;\
+                continue;\
+            }\
+            if (pivot != k) {\
+                sign = -sign;\
+                for (size_t j = 0; j < sq_len; j++) {\
+                    type temp = lu[k * sq_len + j];\
+                    lu[k * sq_len + j] = lu[pivot * sq_len + j];\
+                    lu[pivot * sq_len + j] = temp;\
+                }\
+            }\
+            for (size_t i = k + 1; i < sq_len; i++) {\
+                type l = (lu[i * sq_len + k] /= lu[k * sq_len + k]);\
+                for (size_t j = k + 1; j < k_end; j++) {\
+                    lu[i * sq_len + j] -= l * lu[k * sq_len + j];\
+                }\
+            }\
+        }\
+        for (size_t k = k0; k < k_end; k++) {\
+            for (size_t i = k + 1; i < k_end; i++) {\
+                type l = lu[i * sq_len + k];\
+                for (size_t j = k_end; j < sq_len; j++) {\
+                    lu[i * sq_len + j] -= l * lu[k * sq_len + j];\
+                }\
+            }\
+        }\
+        for (size_t i = k_end; i < sq_len; i++) {\
+            for (size_t k = k0; k < k_end; k++) {\
+                type l = lu[i * sq_len + k];\
+                for (size_t j = k_end; j < sq_len; j++) {\
+                    lu[i * sq_len + j] -= l * lu[k * sq_len + j];\
+                }\
+            }\
+        }\
+    }\
+    return (singular ? 0 : sign);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type linalg_determinant_noM_##type(type * square_mat, type * buffer, size_t * pivots, size_t sq_len) {\
+    memcpy(buffer, square_mat, sq_len * sq_len * sizeof(type));\
+    type determinant = linalg_lu_noM_##type(buffer, pivots, sq_len);\
+    for (size_t i = 0; (i < sq_len) && (determinant != 0); i++) {\
+        determinant *= buffer[i * sq_len + i];\
+    }\
+    return (determinant);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type linalg_determinant_##type(type * square_mat, size_t sq_len) {\
+    type * buffer = nmath_malloc(sq_len * sq_len * sizeof(type));\
+    size_t * pivots = nmath_malloc(sq_len * sizeof(size_t));\
+    type determinant = linalg_determinant_noM_##type(square_mat, buffer, pivots, sq_len);\
+    nmath_free(buffer);\
+    nmath_free(pivots);\
+    return (determinant);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* Integers: fraction-free Bareiss elimination, exact in int64_t. */
+#define REGISTER_ENUM(type) type linalg_determinant_##type(type * square_mat, size_t sq_len) {\
+    int64_t * buffer = nmath_malloc(sq_len * sq_len * sizeof(int64_t));\
+    for (size_t i = 0; i < (sq_len * sq_len); i++) {\
+        buffer[i] = (int64_t)square_mat[i];\
+    }\
+    int64_t sign = 1, previous = 1, determinant = (sq_len > 0) ? 0 : 1;\
+    for (size_t k = 0; k < sq_len; k++) {\
+        size_t pivot = k;\
+        while ((pivot < sq_len) && (buffer[pivot * sq_len + k] == 0)) {\
+            pivot++;\
+        }\
+        if (pivot == sq_len) {\
+            sign = 0;\
+            break;\
+        }\
+        if (pivot != k) {\
+            sign = -sign;\
+            for (size_t j = 0; j < sq_len; j++) {\
+                int64_t temp = buffer[k * sq_len + j];\
+                buffer[k * sq_len + j] = buffer[pivot * sq_len + j];\
+                buffer[pivot * sq_len + j] = temp;\
+            }\
+        }\
+        for (size_t i = k + 1; i < sq_len; i++) {\
+            for (size_t j = k + 1; j < sq_len; j++) {\
+                buffer[i * sq_len + j] = (buffer[i * sq_len + j] * buffer[k * sq_len + k] - buffer[i * sq_len + k] * buffer[k * sq_len + j]) / previous;\
+            }\
+        }\
+        previous = buffer[k * sq_len + k];\
+    }\
+    if (sq_len > 0) {\
+        determinant = sign * buffer[(sq_len - 1) * sq_len + (sq_len - 1)];\
+    }\
+    nmath_free(buffer);\
+    return ((type)determinant);\
+}
+TEMPLATE_TYPES_INT
+#undef REGISTER_ENUM
+
+/* Solve: x = P * b, forward substitution with unit L, back substitution with U */
+#define REGISTER_ENUM(type) type * linalg_solve_noM_##type(type * x, type * lu, size_t * pivots, type * b, size_t sq_len) {\
+    if (x != b) {\
+        memcpy(x, b, sq_len * sizeof(type));\
+    }\
+    for (size_t k = 0; k < sq_len; k++) {\
+        type temp = x[k];\
+        x[k] = x[pivots[k]];\
+        x[pivots[k]] = temp;\
+    }\
+    for (size_t i = 1; i < sq_len; i++) {\
+        type sum = x[i];\
+        for (size_t k = 0; k < i; k++) {\
+            sum -= lu[i * sq_len + k] * x[k];\
+        }\
+        x[i] = sum;\
+    }\
+    for (size_t i = sq_len; i-- > 0;) {\
+        type sum = x[i];\
+        for (size_t k = i + 1; k < sq_len; k++) {\
+            sum -= lu[i * sq_len + k] * x[k];\
+        }\
+        x[i] = sum / lu[i * sq_len + i];\
+    }\
+    return (x);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_solve_##type(type * square_mat, type * b, size_t sq_len) {\
+    type * lu = nmath_malloc(sq_len * sq_len * sizeof(type));\
+    size_t * pivots = nmath_malloc(sq_len * sizeof(size_t));\
+    type * x = NULL;\
+    memcpy(lu, square_mat, sq_len * sq_len * sizeof(type));\
+    if (linalg_lu_noM_##type(lu, pivots, sq_len) != 0) {\
+        x = nmath_malloc(sq_len * sizeof(type));\
+        linalg_solve_noM_##type(x, lu, pivots, b, sq_len);\
+    }\
+    nmath_free(lu);\
+    nmath_free(pivots);\
+    return (x);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* Inverse: solve for all columns of the identity at once, row by row */
+#define REGISTER_ENUM(type) type * linalg_inverse_noM_##type(type * inverse, type * lu, size_t * pivots, size_t sq_len) {\
+    memset(inverse, 0, sq_len * sq_len * sizeof(type));\
+    for (size_t i = 0; i < sq_len; i++) {\
+        inverse[i * sq_len + i] = 1;\
+    }\
+    for (size_t k = 0; k < sq_len; k++) {\
+        if (pivots[k] != k) {\
+            for (size_t j = 0; j < sq_len; j++) {\
+                type temp = inverse[k * sq_len + j];\
+                inverse[k * sq_len + j] = inverse[pivots[k] * sq_len + j];\
+                inverse[pivots[k] * sq_len + j] = temp;\
+            }\
+        }\
+    }\
+    for (size_t i = 1; i < sq_len; i++) {\
+        for (size_t k = 0; k < i; k++) {\
+            type l = lu[i * sq_len + k];\
+            for (size_t j = 0; j < sq_len; j++) {\
+                inverse[i * sq_len + j] -= l * inverse[k * sq_len + j];\
+            }\
+        }\
+    }\
+    for (size_t i = sq_len; i-- > 0;) {\
+        for (size_t k = i + 1; k < sq_len; k++) {\
+            type u = lu[i * sq_len + k];\
+            for (size_t j = 0; j < sq_len; j++) {\
+                inverse[i * sq_len + j] -= u * inverse[k * sq_len + j];\
+            }\
+        }\
+        type diagonal = lu[i * sq_len + i];\
+        for (size_t j = 0; j < sq_len; j++) {\
+            inverse[i * sq_len + j] /= diagonal;\
+        }\
+    }\
+    return (inverse);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_inverse_##type(type * square_mat, size_t sq_len) {\
+    type * lu = nmath_malloc(sq_len * sq_len * sizeof(type));\
+    size_t * pivots = nmath_malloc(sq_len * sizeof(size_t));\
+    type * inverse = NULL;\
+    memcpy(lu, square_mat, sq_len * sq_len * sizeof(type));\
+    if (linalg_lu_noM_##type(lu, pivots, sq_len) != 0) {\
+        inverse = nmath_malloc(sq_len * sq_len * sizeof(type));\
+        linalg_inverse_noM_##type(inverse, lu, pivots, sq_len);\
+    }\
+    nmath_free(lu);\
+    nmath_free(pivots);\
+    return (inverse);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* Symmetric eigen decomposition: Householder tridiagonalization then implicit
+*  QL with Wilkinson shifts, as EISPACK tred2/tql2. V is stored transposed:
+*  rotations and the output eigenvectors are contiguous rows. */
+#define NMATH_EIGEN_V(row, col) square_mat[(col) * sq_len + (row)]
+#define REGISTER_ENUM(type) static void nmath_tridiagonalize_##type(type * square_mat, type * d, type * e, size_t sq_len) {\
+    size_t n = sq_len;\
+    for (size_t j = 0; j < n; j++) {\
+        d[j] = NMATH_EIGEN_V(n - 1, j);\
+    }\
+    for (size_t i = n - 1; i > 0; i--) {\
+        type scale = 0, h = 0;\
+        for (size_t k = 0; k < i; k++) {\
+            scale += fabs(d[k]);\
+        }\
+        if (scale == 0) {\
+            e[i] = d[i - 1];\
+            for (size_t j = 0; j < i; j++) {\
+                d[j] = NMATH_EIGEN_V(i - 1, j);\
+                NMATH_EIGEN_V(i, j) = 0;\
+                NMATH_EIGEN_V(j, i) = 0;\
+            }\
+        } else {\
+            for (size_t k = 0; k < i; k++) {\
+                d[k] /= scale;\
+                h += d[k] * d[k];\
+            }\
+            type f = d[i - 1];\
+            type g = sqrt(h);\
+            if (f > 0) {\
+                g = -g;\
+            }\
+            e[i] = scale * g;\
+            h -= f * g;\
+            d[i - 1] = f - g;\
+            for (size_t j = 0; j < i; j++) {\
+                e[j] = 0;\
+            }\
+            for (size_t j = 0; j < i; j++) {\
+                f = d[j];\
+                NMATH_EIGEN_V(j, i) = f;\
+                g = e[j] + NMATH_EIGEN_V(j, j) * f;\
+                for (size_t k = j + 1; k < i; k++) {\
+                    g += NMATH_EIGEN_V(k, j) * d[k];\
+                    e[k] += NMATH_EIGEN_V(k, j) * f;\
+                }\
+                e[j] = g;\
+            }\
+            f = 0;\
+            for (size_t j = 0; j < i; j++) {\
+                e[j] /= h;\
+                f += e[j] * d[j];\
+            }\
+            type hh = f / (h + h);\
+            for (size_t j = 0; j < i; j++) {\
+                e[j] -= hh * d[j];\
+            }\
+            for (size_t j = 0; j < i; j++) {\
+                f = d[j];\
+                g = e[j];\
+                for (size_t k = j; k < i; k++) {\
+                    NMATH_EIGEN_V(k, j) -= (f * e[k] + g * d[k]);\
+                }\
+                d[j] = NMATH_EIGEN_V(i - 1, j);\
+                NMATH_EIGEN_V(i, j) = 0;\
+            }\
+        }\
+        d[i] = h;\
+    }\
+    for (size_t i = 0; i < (n - 1); i++) {\
+        NMATH_EIGEN_V(n - 1, i) = NMATH_EIGEN_V(i, i);\
+        NMATH_EIGEN_V(i, i) = 1;\
+        type h = d[i + 1];\
+        if (h != 0) {\
+            for (size_t k = 0; k <= i; k++) {\
+                d[k] = NMATH_EIGEN_V(k, i + 1) / h;\
+            }\
+            for (size_t j = 0; j <= i; j++) {\
+                type g = 0;\
+                for (size_t k = 0; k <= i; k++) {\
+                    g += NMATH_EIGEN_V(k, i + 1) * NMATH_EIGEN_V(k, j);\
+                }\
+                for (size_t k = 0; k <= i; k++) {\
+                    NMATH_EIGEN_V(k, j) -= g * d[k];\
+                }\
+            }\
+        }\
+        for (size_t k = 0; k <= i; k++) {\
+            NMATH_EIGEN_V(k, i + 1) = 0;\
+        }\
+    }\
+    for (size_t j = 0; j < n; j++) {\
+        d[j] = NMATH_EIGEN_V(n - 1, j);\
+        NMATH_EIGEN_V(n - 1, j) = 0;\
+    }\
+    NMATH_EIGEN_V(n - 1, n - 1) = 1;\
+    e[0] = 0;\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) static bool nmath_tridiagonal_ql_##type(type * square_mat, type * d, type * e, size_t sq_len) {\
+    size_t n = sq_len;\
+    for (size_t i = 1; i < n; i++) {\
+        e[i - 1] = e[i];\
+    }\
+    e[n - 1] = 0;\
+    type f = 0, tst1 = 0;\
+    for (size_t l = 0; l < n; l++) {\
+        tst1 = fmax(tst1, fabs(d[l]) + fabs(e[l]));\
+        size_t m = l;\
+        while ((m < (n - 1)) && (fabs(e[m]) > (NMATH_EPSILON_##type * tst1))) {\
+            m++;\
+        }\
+        size_t iter = 0;\
+        while ((m > l) && (fabs(e[l]) > (NMATH_EPSILON_##type * tst1))) {\
+            if (++iter > NMATH_ITERATIONS_LIMIT) {\
+                return (false);\
+            }\
+            type g = d[l];\
+            type p = (d[l + 1] - g) / (2 * e[l]);\
+            type r = hypot(p, 1);\
+            if (p < 0) {\
+                r = -r;\
+            }\
+            d[l] = e[l] / (p + r);\
+            d[l + 1] = e[l] * (p + r);\
+            type dl1 = d[l + 1];\
+            type h = g - d[l];\
+            for (size_t i = l + 2; i < n; i++) {\
+                d[i] -= h;\
+            }\
+            f += h;\
+            p = d[m];\
+            type c = 1, c2 = 1, c3 = 1, s = 0, s2 = 0;\
+            type el1 = e[l + 1];\
+            for (size_t i = m; i-- > l;) {\
+                c3 = c2;\
+                c2 = c;\
+                s2 = s;\
+                g = c * e[i];\
+                h = c * p;\
+                r = hypot(p, e[i]);\
+                e[i + 1] = s * r;\
+                s = e[i] / r;\
+                c = p / r;\
+                p = c * d[i] - s * g;\
+                d[i + 1] = h + s * (c * g + s * d[i]);\
+                type * vi = square_mat + i * sq_len;\
+                type * vi1 = square_mat + (i + 1) * sq_len;\
+                for (size_t k = 0; k < n; k++) {\
+                    h = vi1[k];\
+                    vi1[k] = s * vi[k] + c * h;\
+                    vi[k] = c * vi[k] - s * h;\
+                }\
+            }\
+            p = -s * s2 * c3 * el1 * e[l] / dl1;\
+            e[l] = s * p;\
+            d[l] = c * p;\
+        }\
+        d[l] += f;\
+        e[l] = 0;\
+    }\
+    return (true);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+#undef NMATH_EIGEN_V
+
+#define REGISTER_ENUM(type) type * linalg_eigen_symmetric_noM_##type(type * square_mat, type * eigenvalues, type * work, size_t sq_len) {\
+    if (sq_len == 0) {\
+        return (eigenvalues);\
+    }\
+    nmath_tridiagonalize_##type(square_mat, eigenvalues, work, sq_len);\
+    if (!nmath_tridiagonal_ql_##type(square_mat, eigenvalues, work, sq_len)) {\
+        return (NULL);\
+    }\
+    for (size_t i = 0; i < (sq_len - 1); i++) {\
+        size_t k = i;\
+        for (size_t j = i + 1; j < sq_len; j++) {\
+            if (eigenvalues[j] < eigenvalues[k]) {\
+                k = j;\
+            }\
+        }\
+        if (k != i) {\
+            type temp = eigenvalues[i];\
+            eigenvalues[i] = eigenvalues[k];\
+            eigenvalues[k] = temp;\
+            for (size_t j = 0; j < sq_len; j++) {\
+                temp = square_mat[i * sq_len + j];\
+                square_mat[i * sq_len + j] = square_mat[k * sq_len + j];\
+                square_mat[k * sq_len + j] = temp;\
+            }\
+        }\
+    }\
+    return (eigenvalues);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* Index of i in [0, len) according to border, -1 if out of bounds with NMATH_BORDER_ZERO */
+static int64_t nmath_border_index(int64_t i, size_t len, int border) {
+    if ((i >= 0) && (i < (int64_t)len)) {
+        return (i);
+    }
+    switch (border) {
+        case NMATH_BORDER_CLAMP:
+            return ((i < 0) ? 0 : ((int64_t)len - 1));
+        case NMATH_BORDER_WRAP:
+            return (((i % (int64_t)len) + (int64_t)len) % (int64_t)len);
+    }
+    return (-1);
+}
+
+/* out_row[col] += sum of kernel[k] * in_row[col + k - k_len / 2].
+*  Interior columns: one vectorized axpy of the shifted row per kernel tap.
+*  Border columns, and all columns if k_len > col_len: scalar. */
+#define REGISTER_ENUM(type) static void nmath_correlate_row_##type(type * out_row, type * in_row, type * kernel, size_t k_len, size_t col_len, int border) {\
+    size_t center = k_len / 2, begin = 0, end = 0;\
+    if (k_len <= col_len) {\
+        begin = center;\
+        end = col_len - (k_len - 1 - center);\
+        for (size_t k = 0; k < k_len; k++) {\
+            nmath_kernel_axpy_##type(out_row + begin, in_row + begin + k - center, kernel[k], end - begin);\
+        }\
+    }\
+    for (size_t col = 0; col < col_len; col++) {\
+        if (col == begin) {\
+            col = end;\
+            if (col >= col_len) {\
+                break;\
+            }\
+        }\
+        type sum = 0;\
+        for (size_t k = 0; k < k_len; k++) {\
+            int64_t index = nmath_border_index((int64_t)(col + k) - (int64_t)center, col_len, border);\
+            if (index >= 0) {\
+                sum += kernel[k] * in_row[index];\
+            }\
+        }\
+        out_row[col] += sum;\
+    }\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_convolve2D_noM_##type(type * out, type * matrix, type * kernel, size_t row_len, size_t col_len, size_t k_row_len, size_t k_col_len, int border) {\
+    NMATH_PARALLEL_FOR(row_len * col_len * k_row_len * k_col_len)\
+    for (size_t row = 0; row < row_len; row++) {\
+        memset(out + row * col_len, 0, col_len * sizeof(type));\
+        for (size_t k = 0; k < k_row_len; k++) {\
+            int64_t in_row = nmath_border_index((int64_t)(row + k) - (int64_t)(k_row_len / 2), row_len, border);\
+            if (in_row >= 0) {\
+                nmath_correlate_row_##type(out + row * col_len, matrix + in_row * col_len, kernel + k * k_col_len, k_col_len, col_len, border);\
+            }\
+        }\
+    }\
+    return (out);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_convolve2D_##type(type * matrix, type * kernel, size_t row_len, size_t col_len, size_t k_row_len, size_t k_col_len, int border) {\
+    type * out = nmath_malloc(row_len * col_len * sizeof(type));\
+    return (linalg_convolve2D_noM_##type(out, matrix, kernel, row_len, col_len, k_row_len, k_col_len, border));\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* Row pass into buffer, then column pass: each out row is an axpy of
+*  k_row_len buffer rows. k_row_len + k_col_len taps per tile. */
+#define REGISTER_ENUM(type) type * linalg_convolve2D_separable_noM_##type(type * out, type * matrix, type * buffer, type * row_kernel, type * col_kernel, size_t row_len, size_t col_len, size_t k_row_len, size_t k_col_len, int border) {\
+    NMATH_PARALLEL_FOR(row_len * col_len * k_col_len)\
+    for (size_t row = 0; row < row_len; row++) {\
+        memset(buffer + row * col_len, 0, col_len * sizeof(type));\
+        nmath_correlate_row_##type(buffer + row * col_len, matrix + row * col_len, row_kernel, k_col_len, col_len, border);\
+    }\
+    NMATH_PARALLEL_FOR(row_len * col_len * k_row_len)\
+    for (size_t row = 0; row < row_len; row++) {\
+        memset(out + row * col_len, 0, col_len * sizeof(type));\
+        for (size_t k = 0; k < k_row_len; k++) {\
+            int64_t in_row = nmath_border_index((int64_t)(row + k) - (int64_t)(k_row_len / 2), row_len, border);\
+            if (in_row >= 0) {\
+                nmath_kernel_axpy_##type(out + row * col_len, buffer + in_row * col_len, col_kernel[k], col_len);\
+            }\
+        }\
+    }\
+    return (out);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* Running sums: row pass slides the window along each row into buffer.
+*  Column pass: out row = previous out row + entering row - leaving row. */
+#define REGISTER_ENUM(type) type * linalg_box_filter_noM_##type(type * out, type * matrix, type * buffer, size_t row_len, size_t col_len, size_t radius, int border) {\
+    int64_t r = radius;\
+    NMATH_PARALLEL_FOR(row_len * col_len)\
+    for (size_t row = 0; row < row_len; row++) {\
+        type * in_row = matrix + row * col_len, sum = 0;\
+        for (int64_t k = -r; k <= r; k++) {\
+            int64_t index = nmath_border_index(k, col_len, border);\
+            sum += (index >= 0) ? in_row[index] : 0;\
+        }\
+        type * buffer_row = buffer + row * col_len;\
+        buffer_row[0] = sum;\
+        for (int64_t col = 1; col < (int64_t)col_len; col++) {\
+            if ((col > r) && ((col + r) < (int64_t)col_len)) {\
+                sum += in_row[col + r] - in_row[col - r - 1];\
+            } else {\
+                int64_t enter = nmath_border_index(col + r, col_len, border);\
+                int64_t leave = nmath_border_index(col - r - 1, col_len, border);\
+                sum += ((enter >= 0) ? in_row[enter] : 0) - ((leave >= 0) ? in_row[leave] : 0);\
+            }\
+            buffer_row[col] = sum;\
+        }\
+    }\
+    memset(out, 0, col_len * sizeof(type));\
+    for (int64_t k = -r; k <= r; k++) {\
+        int64_t index = nmath_border_index(k, row_len, border);\
+        if (index >= 0) {\
+            nmath_kernel_plus_##type(out, out, buffer + index * col_len, col_len);\
+        }\
+    }\
+    for (int64_t row = 1; row < (int64_t)row_len; row++) {\
+        type * out_row = out + row * col_len;\
+        memcpy(out_row, out_row - col_len, col_len * sizeof(type));\
+        int64_t enter = nmath_border_index(row + r, row_len, border);\
+        int64_t leave = nmath_border_index(row - r - 1, row_len, border);\
+        if (enter >= 0) {\
+            nmath_kernel_plus_##type(out_row, out_row, buffer + enter * col_len, col_len);\
+        }\
+        if (leave >= 0) {\
+            nmath_kernel_minus_##type(out_row, out_row, buffer + leave * col_len, col_len);\
+        }\
+    }\
+    nmath_kernel_mult_scalar_##type(out, out, (type)1 / (type)((2 * r + 1) * (2 * r + 1)), row_len * col_len);\
+    return (out);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* Same neighbour cycles as pathfinding. Out of bounds neighbours are skipped, not clamped. */
+static bool nmath_csr_neighbour(size_t row, size_t col, size_t row_len, size_t col_len, int neighbours, int i, size_t * index) {
+    int64_t x = col, y = row;
+    if (neighbours == NMATH_SQUARE_NEIGHBOURS) {
+        x += q_cycle4_mzpz(i);
+        y += q_cycle4_zmzp(i);
+    } else {
+        x += q_cycle6_mppmzz(i);
+        y += q_cycle6_pmzzmp(i);
+    }
+    if ((x < 0) || (y < 0) || (x >= (int64_t)col_len) || (y >= (int64_t)row_len)) {
+        return (false);
+    }
+    *index = y * col_len + x;
+    return (true);
+}
+
+#define REGISTER_ENUM(type) struct nmath_csr_##type * linalg_csr_grid_##type(type * costmap, size_t row_len, size_t col_len, int neighbours) {\
+    if ((neighbours != NMATH_SQUARE_NEIGHBOURS) && (neighbours != NMATH_HEXAGON_NEIGHBOURS)) {\
+        return (NULL);\
+    }\
+    size_t tile_num = row_len * col_len, index;\
+    struct nmath_csr_##type * csr = nmath_malloc(sizeof(*csr));\
+    csr->row_len = tile_num;\
+    csr->col_len = tile_num;\
+    csr->row_starts = nmath_malloc((tile_num + 1) * sizeof(*csr->row_starts));\
+    csr->nnz = 0;\
+    for (size_t tile = 0; tile < tile_num; tile++) {\
+        csr->row_starts[tile] = csr->nnz;\
+        if (costmap[tile] < NMATH_COSTMAP_MOVEABLEMIN) {\
+            continue;\
+        }\
+        for (int i = 0; i < neighbours; i++) {\
+            if (nmath_csr_neighbour(tile / col_len, tile % col_len, row_len, col_len, neighbours, i, &index)) {\
+                csr->nnz += (costmap[index] >= NMATH_COSTMAP_MOVEABLEMIN);\
+            }\
+        }\
+    }\
+    csr->row_starts[tile_num] = csr->nnz;\
+    csr->col_indices = nmath_malloc(csr->nnz * sizeof(*csr->col_indices));\
+    csr->values = nmath_malloc(csr->nnz * sizeof(*csr->values));\
+    size_t nnz = 0;\
+    for (size_t tile = 0; tile < tile_num; tile++) {\
+        if (costmap[tile] < NMATH_COSTMAP_MOVEABLEMIN) {\
+            continue;\
+        }\
+        for (int i = 0; i < neighbours; i++) {\
+            if (nmath_csr_neighbour(tile / col_len, tile % col_len, row_len, col_len, neighbours, i, &index) && (costmap[index] >= NMATH_COSTMAP_MOVEABLEMIN)) {\
+                csr->col_indices[nnz] = index;\
+                csr->values[nnz++] = 1 / costmap[index];\
+            }\
+        }\
+    }\
+    return (csr);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* Counting sort of the entries by column. Rows of the transpose come out with sorted col_indices. */
+#define REGISTER_ENUM(type) struct nmath_csr_##type * linalg_csr_transpose_##type(struct nmath_csr_##type * csr) {\
+    struct nmath_csr_##type * transpose = nmath_malloc(sizeof(*transpose));\
+    transpose->row_len = csr->col_len;\
+    transpose->col_len = csr->row_len;\
+    transpose->nnz = csr->nnz;\
+    transpose->row_starts = nmath_calloc(csr->col_len + 1, sizeof(*transpose->row_starts));\
+    transpose->col_indices = nmath_malloc(csr->nnz * sizeof(*transpose->col_indices));\
+    transpose->values = nmath_malloc(csr->nnz * sizeof(*transpose->values));\
+    for (size_t i = 0; i < csr->nnz; i++) {\
+        transpose->row_starts[csr->col_indices[i] + 1]++;\
+    }\
+    for (size_t col = 0; col < csr->col_len; col++) {\
+        transpose->row_starts[col + 1] += transpose->row_starts[col];\
+    }\
+    size_t * fill = nmath_malloc(csr->col_len * sizeof(*fill));\
+    memcpy(fill, transpose->row_starts, csr->col_len * sizeof(*fill));\
+    for (size_t row = 0; row < csr->row_len; row++) {\
+        for (size_t i = csr->row_starts[row]; i < csr->row_starts[row + 1]; i++) {\
+            size_t dest = fill[csr->col_indices[i]]++;\
+            transpose->col_indices[dest] = row;\
+            transpose->values[dest] = csr->values[i];\
+        }\
+    }\
+    nmath_free(fill);\
+    return (transpose);\
+}
 TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
-int32_t q_sequence_fgeometric_int32_t(int32_t current, int32_t destination, float geo_factor) {
-    int32_t distance = current - destination;\
-    int32_t sign = (int32_t )copysign(1, distance);\
-    int32_t out = (sign * (int32_t)(distance / geo_factor) < 1) ? sign : (int32_t)(distance / geo_factor);\
-    return (out);\
-
+#define REGISTER_ENUM(type) void linalg_csr_free_##type(struct nmath_csr_##type * csr) {\
+    if (csr == NULL) {\
+        return;\
+    }\
+    nmath_free(csr->row_starts);\
+    nmath_free(csr->col_indices);\
+    nmath_free(csr->values);\
+    nmath_free(csr);\
 }
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
 
-
-// sequence_pingpong: oscillating integer sequence. upper is excluded.
-// modulo: x % 2 = 0,1,2,0,1,2,0...for x++
-// pingpong(x, 2, 0) = 0,1,2,1,0,1,2... for x++
-#define REGISTER_ENUM(type) type q_sequence_pingpong_##type(type current, type upper, type lower) {\
-    type mod_factor = (2 * (upper - lower) - 2);\
-    type term1 = mod_factor - (current % mod_factor);\
-    type term2 = current % mod_factor;\
-    return (fmin(term1, term2) + lower);\
+/* Rows are independent: threaded over rows, no reduction needed. */
+#define REGISTER_ENUM(type) type * linalg_csr_spmv_noM_##type(type * out, struct nmath_csr_##type * csr, type * vec) {\
+    size_t * row_starts = csr->row_starts, * col_indices = csr->col_indices;\
+    type * values = csr->values;\
+    NMATH_PARALLEL_FOR(csr->nnz)\
+    for (size_t row = 0; row < csr->row_len; row++) {\
+        type sum = 0;\
+        for (size_t i = row_starts[row]; i < row_starts[row + 1]; i++) {\
+            sum += values[i] * vec[col_indices[i]];\
+        }\
+        out[row] = sum;\
+    }\
+    return (out);\
 }
-TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
-// Sometimes attributed to John Carmack...
-#define REGISTER_ENUM(type) float q_sqrt_##type(type in_int) {\
-    const float x2 = in_int * 0.5f;\
-    const float threehalfs = 1.5f;\
-    union {\
-        float f;\
-        unsigned long i;\
-    } conv  = { .f = in_int };\
-    conv.i  = 0x5f3759df - (conv.i >> 1);\
-    conv.f  *= (threehalfs - (x2 * conv.f * conv.f));\
-    return conv.f;\
+#define REGISTER_ENUM(type) type * linalg_csr_spmv_##type(struct nmath_csr_##type * csr, type * vec) {\
+    type * out = nmath_malloc(csr->row_len * sizeof(type));\
+    return (linalg_csr_spmv_noM_##type(out, csr, vec));\
 }
-TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
-/********************************* LINALG ************************************/
-
 #define REGISTER_ENUM(type) type linalg_trace_##type(type * square_mat, size_t sq_len) {\
     type trace = 0;\
     for (size_t i = 0; i < sq_len; i++) {\
@@ -270,8 +2289,224 @@ TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) type * linalg_crossProduct_##type(type * vec3D1, type * vec3D2) {\
-    type * product = calloc(3, sizeof(type));\
+/* Batched small matrices: num D x D matrices, D x 1 vectors.
+*  AoS: matrix i at matrices[i * D * D], row-major, vector i at vecs[i * D].
+*  SoA: element k of matrix/vector i at array[k * num + i]: vectorizes over i.
+*  Helpers read element k at array[k * stride], load everything first: out
+*  can be an input. No allocation. */
+#define NMATH_BATCH_LOAD(local, array, stride, len) for (size_t k = 0; k < (len); k++) {\
+    local[k] = (array)[k * (stride)];\
+}
+#define NMATH_BATCH_STORE(array, stride, local, len) for (size_t k = 0; k < (len); k++) {\
+    (array)[k * (stride)] = local[k];\
+}
+
+#define NMATH_BATCH_HELPERS(type, D) \
+static inline void nmath_batch_matvec##D##_##type(type * out, size_t os, type * matrix, size_t ms, type * vec, size_t vs) {\
+    type m[D * D], v[D], o[D];\
+    NMATH_BATCH_LOAD(m, matrix, ms, D * D)\
+    NMATH_BATCH_LOAD(v, vec, vs, D)\
+    for (size_t r = 0; r < D; r++) {\
+        o[r] = 0;\
+        for (size_t c = 0; c < D; c++) {\
+            o[r] += m[r * D + c] * v[c];\
+        }\
+    }\
+    NMATH_BATCH_STORE(out, os, o, D)\
+}\
+static inline void nmath_batch_matmul##D##_##type(type * out, type * matrix1, type * matrix2, size_t stride) {\
+    type a[D * D], b[D * D], o[D * D];\
+    NMATH_BATCH_LOAD(a, matrix1, stride, D * D)\
+    NMATH_BATCH_LOAD(b, matrix2, stride, D * D)\
+    for (size_t r = 0; r < D; r++) {\
+        for (size_t c = 0; c < D; c++) {\
+            o[r * D + c] = 0;\
+            for (size_t k = 0; k < D; k++) {\
+                o[r * D + c] += a[r * D + k] * b[k * D + c];\
+            }\
+        }\
+    }\
+    NMATH_BATCH_STORE(out, stride, o, D * D)\
+}
+
+#define REGISTER_ENUM(type) \
+NMATH_BATCH_HELPERS(type, 2)\
+NMATH_BATCH_HELPERS(type, 3)\
+NMATH_BATCH_HELPERS(type, 4)\
+static inline type nmath_batch_determinant2_##type(type * matrix, size_t stride) {\
+    type m[4];\
+    NMATH_BATCH_LOAD(m, matrix, stride, 4)\
+    return (m[0] * m[3] - m[1] * m[2]);\
+}\
+static inline type nmath_batch_determinant3_##type(type * matrix, size_t stride) {\
+    type m[9];\
+    NMATH_BATCH_LOAD(m, matrix, stride, 9)\
+    return (m[0] * (m[4] * m[8] - m[5] * m[7]) + m[1] * (m[5] * m[6] - m[3] * m[8]) + m[2] * (m[3] * m[7] - m[4] * m[6]));\
+}\
+static inline type nmath_batch_determinant4_##type(type * matrix, size_t stride) {\
+    type m[16];\
+    NMATH_BATCH_LOAD(m, matrix, stride, 16)\
+    type s0 = m[0] * m[5] - m[4] * m[1], s1 = m[0] * m[6] - m[4] * m[2];\
+    type s2 = m[0] * m[7] - m[4] * m[3], s3 = m[1] * m[6] - m[5] * m[2];\
+    type s4 = m[1] * m[7] - m[5] * m[3], s5 = m[2] * m[7] - m[6] * m[3];\
+    type c5 = m[10] * m[15] - m[14] * m[11], c4 = m[9] * m[15] - m[13] * m[11];\
+    type c3 = m[9] * m[14] - m[13] * m[10], c2 = m[8] * m[15] - m[12] * m[11];\
+    type c1 = m[8] * m[14] - m[12] * m[10], c0 = m[8] * m[13] - m[12] * m[9];\
+    return (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);\
+}\
+static inline void nmath_batch_inverse2_##type(type * out, type * matrix, size_t stride) {\
+    type m[4], o[4];\
+    NMATH_BATCH_LOAD(m, matrix, stride, 4)\
+    type determinant = m[0] * m[3] - m[1] * m[2];\
+    type inv = (determinant != 0) ? (1 / determinant) : 0;\
+    o[0] = m[3] * inv;\
+    o[1] = -m[1] * inv;\
+    o[2] = -m[2] * inv;\
+    o[3] = m[0] * inv;\
+    NMATH_BATCH_STORE(out, stride, o, 4)\
+}\
+static inline void nmath_batch_inverse3_##type(type * out, type * matrix, size_t stride) {\
+    type m[9], o[9];\
+    NMATH_BATCH_LOAD(m, matrix, stride, 9)\
+    o[0] = m[4] * m[8] - m[5] * m[7];\
+    o[1] = m[2] * m[7] - m[1] * m[8];\
+    o[2] = m[1] * m[5] - m[2] * m[4];\
+    o[3] = m[5] * m[6] - m[3] * m[8];\
+    o[4] = m[0] * m[8] - m[2] * m[6];\
+    o[5] = m[2] * m[3] - m[0] * m[5];\
+    o[6] = m[3] * m[7] - m[4] * m[6];\
+    o[7] = m[1] * m[6] - m[0] * m[7];\
+    o[8] = m[0] * m[4] - m[1] * m[3];\
+    type determinant = m[0] * o[0] + m[1] * o[3] + m[2] * o[6];\
+    type inv = (determinant != 0) ? (1 / determinant) : 0;\
+    for (size_t k = 0; k < 9; k++) {\
+        o[k] *= inv;\
+    }\
+    NMATH_BATCH_STORE(out, stride, o, 9)\
+}\
+static inline void nmath_batch_inverse4_##type(type * out, type * matrix, size_t stride) {\
+    type m[16], o[16];\
+    NMATH_BATCH_LOAD(m, matrix, stride, 16)\
+    type s0 = m[0] * m[5] - m[4] * m[1], s1 = m[0] * m[6] - m[4] * m[2];\
+    type s2 = m[0] * m[7] - m[4] * m[3], s3 = m[1] * m[6] - m[5] * m[2];\
+    type s4 = m[1] * m[7] - m[5] * m[3], s5 = m[2] * m[7] - m[6] * m[3];\
+    type c5 = m[10] * m[15] - m[14] * m[11], c4 = m[9] * m[15] - m[13] * m[11];\
+    type c3 = m[9] * m[14] - m[13] * m[10], c2 = m[8] * m[15] - m[12] * m[11];\
+    type c1 = m[8] * m[14] - m[12] * m[10], c0 = m[8] * m[13] - m[12] * m[9];\
+    type determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;\
+    type inv = (determinant != 0) ? (1 / determinant) : 0;\
+    o[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * inv;\
+    o[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * inv;\
+    o[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * inv;\
+    o[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * inv;\
+    o[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * inv;\
+    o[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * inv;\
+    o[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * inv;\
+    o[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * inv;\
+    o[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * inv;\
+    o[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * inv;\
+    o[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * inv;\
+    o[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * inv;\
+    o[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * inv;\
+    o[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * inv;\
+    o[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * inv;\
+    o[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * inv;\
+    NMATH_BATCH_STORE(out, stride, o, 16)\
+}\
+static inline void nmath_batch_crossProduct_##type(type * out, type * vec3D1, type * vec3D2, size_t stride) {\
+    type a[3], b[3], o[3];\
+    NMATH_BATCH_LOAD(a, vec3D1, stride, 3)\
+    NMATH_BATCH_LOAD(b, vec3D2, stride, 3)\
+    o[0] = a[1] * b[2] - a[2] * b[1];\
+    o[1] = a[2] * b[0] - a[0] * b[2];\
+    o[2] = a[0] * b[1] - a[1] * b[0];\
+    NMATH_BATCH_STORE(out, stride, o, 3)\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define NMATH_BATCH_FUNCTIONS(type, D) \
+type * linalg_batch_transform##D##_noM_##type(type * out, type * matrix, type * vecs, size_t num) {\
+    for (size_t i = 0; i < num; i++) {\
+        nmath_batch_matvec##D##_##type(out + i * D, 1, matrix, 1, vecs + i * D, 1);\
+    }\
+    return (out);\
+}\
+type * linalg_batch_transform##D##_soa_noM_##type(type * out, type * matrix, type * vecs, size_t num) {\
+    for (size_t i = 0; i < num; i++) {\
+        nmath_batch_matvec##D##_##type(out + i, num, matrix, 1, vecs + i, num);\
+    }\
+    return (out);\
+}\
+type * linalg_batch_matvec##D##_noM_##type(type * out, type * matrices, type * vecs, size_t num) {\
+    for (size_t i = 0; i < num; i++) {\
+        nmath_batch_matvec##D##_##type(out + i * D, 1, matrices + i * D * D, 1, vecs + i * D, 1);\
+    }\
+    return (out);\
+}\
+type * linalg_batch_matvec##D##_soa_noM_##type(type * out, type * matrices, type * vecs, size_t num) {\
+    for (size_t i = 0; i < num; i++) {\
+        nmath_batch_matvec##D##_##type(out + i, num, matrices + i, num, vecs + i, num);\
+    }\
+    return (out);\
+}\
+type * linalg_batch_matmul##D##_noM_##type(type * out, type * matrices1, type * matrices2, size_t num) {\
+    for (size_t i = 0; i < num; i++) {\
+        nmath_batch_matmul##D##_##type(out + i * D * D, matrices1 + i * D * D, matrices2 + i * D * D, 1);\
+    }\
+    return (out);\
+}\
+type * linalg_batch_matmul##D##_soa_noM_##type(type * out, type * matrices1, type * matrices2, size_t num) {\
+    for (size_t i = 0; i < num; i++) {\
+        nmath_batch_matmul##D##_##type(out + i, matrices1 + i, matrices2 + i, num);\
+    }\
+    return (out);\
+}\
+type * linalg_batch_determinant##D##_noM_##type(type * out, type * matrices, size_t num) {\
+    for (size_t i = 0; i < num; i++) {\
+        out[i] = nmath_batch_determinant##D##_##type(matrices + i * D * D, 1);\
+    }\
+    return (out);\
+}\
+type * linalg_batch_determinant##D##_soa_noM_##type(type * out, type * matrices, size_t num) {\
+    for (size_t i = 0; i < num; i++) {\
+        out[i] = nmath_batch_determinant##D##_##type(matrices + i, num);\
+    }\
+    return (out);\
+}\
+type * linalg_batch_inverse##D##_noM_##type(type * out, type * matrices, size_t num) {\
+    for (size_t i = 0; i < num; i++) {\
+        nmath_batch_inverse##D##_##type(out + i * D * D, matrices + i * D * D, 1);\
+    }\
+    return (out);\
+}\
+type * linalg_batch_inverse##D##_soa_noM_##type(type * out, type * matrices, size_t num) {\
+    for (size_t i = 0; i < num; i++) {\
+        nmath_batch_inverse##D##_##type(out + i, matrices + i, num);\
+    }\
+    return (out);\
+}
+
+#define REGISTER_ENUM(type) \
+NMATH_BATCH_FUNCTIONS(type, 2)\
+NMATH_BATCH_FUNCTIONS(type, 3)\
+NMATH_BATCH_FUNCTIONS(type, 4)\
+type * linalg_batch_crossProduct_noM_##type(type * out, type * vecs1, type * vecs2, size_t num) {\
+    for (size_t i = 0; i < num; i++) {\
+        nmath_batch_crossProduct_##type(out + i * 3, vecs1 + i * 3, vecs2 + i * 3, 1);\
+    }\
+    return (out);\
+}\
+type * linalg_batch_crossProduct_soa_noM_##type(type * out, type * vecs1, type * vecs2, size_t num) {\
+    for (size_t i = 0; i < num; i++) {\
+        nmath_batch_crossProduct_##type(out + i, vecs1 + i, vecs2 + i, num);\
+    }\
+    return (out);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_crossProduct_noM_##type(type * product, type * vec3D1, type * vec3D2) {\
     product[0] = vec3D1[1] * vec3D2[2] - vec3D1[2] * vec3D2[1];\
     product[1] = vec3D1[2] * vec3D2[0] - vec3D1[0] * vec3D2[2];\
     product[2] = vec3D1[0] * vec3D2[1] - vec3D1[1] * vec3D2[0];\
@@ -282,11 +2517,8 @@ TEMPLATE_TYPES_FLOAT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) type * linalg_crossProduct_noM_##type(type * product, type * vec3D1, type * vec3D2) {\
-    product[0] = vec3D1[1] * vec3D2[2] - vec3D1[2] * vec3D2[1];\
-    product[1] = vec3D1[2] * vec3D2[0] - vec3D1[0] * vec3D2[2];\
-    product[2] = vec3D1[0] * vec3D2[1] - vec3D1[1] * vec3D2[0];\
-    return(product);\
+#define REGISTER_ENUM(type) type * linalg_crossProduct_##type(type * vec3D1, type * vec3D2) {\
+    return (linalg_crossProduct_noM_##type(nmath_malloc(3 * sizeof(type)), vec3D1, vec3D2));\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
@@ -305,6 +2537,54 @@ TEMPLATE_TYPES_FLOAT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
+#define REGISTER_ENUM(type) type * linalg_matmul_noM_##type(type * out, type * matrix1, type * matrix2, type * buffer, size_t row_len, size_t inner_len, size_t col_len) {\
+    /* Own scratch: sized to the blocks, padded to MR/NR, not to MC/KC/NC. */\
+    size_t mc_max = NMATH_GEMM_MC, kc_max = NMATH_GEMM_KC, nc_max = NMATH_GEMM_NC;\
+    if (buffer == NULL) {\
+        mc_max = (NMATH_MIN(row_len, NMATH_GEMM_MC) + NMATH_GEMM_MR - 1) / NMATH_GEMM_MR * NMATH_GEMM_MR;\
+        kc_max = NMATH_MIN(inner_len, NMATH_GEMM_KC);\
+        nc_max = (NMATH_MIN(col_len, NMATH_GEMM_NC) + NMATH_GEMM_NR(type) - 1) / NMATH_GEMM_NR(type) * NMATH_GEMM_NR(type);\
+    }\
+    type * scratch = (buffer != NULL) ? buffer : nmath_malloc((mc_max * kc_max + kc_max * nc_max) * sizeof(type));\
+    type * packA = scratch;\
+    type * packB = scratch + mc_max * kc_max;\
+    memset(out, 0, row_len * col_len * sizeof(type));\
+    for (size_t jc = 0; jc < col_len; jc += NMATH_GEMM_NC) {\
+        size_t nc = ((col_len - jc) < NMATH_GEMM_NC) ? (col_len - jc) : NMATH_GEMM_NC;\
+        for (size_t pc = 0; pc < inner_len; pc += NMATH_GEMM_KC) {\
+            size_t kc = ((inner_len - pc) < NMATH_GEMM_KC) ? (inner_len - pc) : NMATH_GEMM_KC;\
+            nmath_gemm_packB_##type(packB, matrix2 + pc * col_len + jc, col_len, kc, nc);\
+            for (size_t ic = 0; ic < row_len; ic += NMATH_GEMM_MC) {\
+                size_t mc = ((row_len - ic) < NMATH_GEMM_MC) ? (row_len - ic) : NMATH_GEMM_MC;\
+                nmath_gemm_packA_##type(packA, matrix1 + ic * inner_len + pc, inner_len, mc, kc);\
+                NMATH_PARALLEL_FOR(row_len * col_len)\
+                for (size_t jr = 0; jr < nc; jr += NMATH_GEMM_NR(type)) {\
+                    size_t nr = ((nc - jr) < NMATH_GEMM_NR(type)) ? (nc - jr) : NMATH_GEMM_NR(type);\
+                    for (size_t ir = 0; ir < mc; ir += NMATH_GEMM_MR) {\
+                        size_t mr = ((mc - ir) < NMATH_GEMM_MR) ? (mc - ir) : NMATH_GEMM_MR;\
+                        nmath_gemm_kernel_##type(out + (ic + ir) * col_len + jc + jr, col_len, packA + ir * kc, packB + jr * kc, kc, mr, nr);\
+                    }\
+                }\
+            }\
+        }\
+    }\
+    if (buffer == NULL) {\
+        nmath_free(scratch);\
+    }\
+    return (out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_matmul_##type(type * matrix1, type * matrix2, size_t row_len, size_t inner_len, size_t col_len) {\
+    type * out = nmath_malloc(row_len * col_len * sizeof(type));\
+    return (linalg_matmul_noM_##type(out, matrix1, matrix2, NULL, row_len, inner_len, col_len));\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
 #define REGISTER_ENUM(type) bool linalg_list_isIn_1D_##type(type * list_2D, size_t list_len, type x) {\
     bool found = false;\
     for (size_t i = 0; i < list_len; i++) {\
@@ -350,15 +2630,65 @@ TEMPLATE_TYPES_FLOAT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) type * linalg_uniques_##type(type * array, size_t arr_len) {\
-    type * uniques_list = DARR_INIT(uniques_list, type, arr_len);\
-    for (size_t i = 0; i < arr_len; i++) {\
-        if (!linalg_isIn_##type(uniques_list, array[i], DARR_NUM(uniques_list))) {\
-            DARR_PUT(uniques_list, array[i]);\
+/* Uniques hash set: open addressing, linear probing, load factor <= 1/2.
+*  Slots hold (index + 1) of a tuple in the uniques list, 0 is empty.
+*  Tuples are compared with ==, like linalg_isIn. */
+static size_t nmath_hashset_len(size_t num) {
+    size_t len = 16;
+    while (len < (num * 2)) {
+        len *= 2;
+    }
+    return (len);
+}
+
+static uint64_t nmath_hash_mix(uint64_t hash) {
+    /* splitmix64 finalizer */
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return (hash);
+}
+
+#define REGISTER_ENUM(type) static uint64_t nmath_hash_tuple_##type(type * tuple, size_t dim) {\
+    uint64_t hash = 0, bits;\
+    type value;\
+    for (size_t d = 0; d < dim; d++) {\
+        bits = 0;\
+        value = (tuple[d] == 0) ? 0 : tuple[d]; /* -0.0 == 0.0 */\
+        memcpy(&bits, &value, sizeof(value));\
+        hash = nmath_hash_mix(hash ^ bits);\
+    }\
+    return (hash);\
+}\
+static type * nmath_uniques_ND_##type(type * array, size_t num, size_t dim) {\
+    type * uniques_list = DARR_INIT(uniques_list, type, (num > 0 ? num : 1) * dim);\
+    size_t set_len = nmath_hashset_len(num);\
+    size_t * set = nmath_calloc(set_len, sizeof(*set));\
+    for (size_t i = 0; i < num; i++) {\
+        type * tuple = array + i * dim;\
+        size_t slot = nmath_hash_tuple_##type(tuple, dim) & (set_len - 1);\
+        bool found = false;\
+        while (set[slot] > 0) {\
+            type * unique = uniques_list + (set[slot] - 1) * dim;\
+            size_t d = 0;\
+            while ((d < dim) && (unique[d] == tuple[d])) {\
+                d++;\
+            }\
+            if (d == dim) {\
+                found = true;\
+                break;\
+            }\
+            slot = (slot + 1) & (set_len - 1);\
+        }\
+        if (!found) {\
+            DARR_APPEND_N(uniques_list, tuple, dim);\
+            set[slot] = DARR_NUM(uniques_list) / dim;\
         }\
     }\
-    DARR_LEN(uniques_list) = DARR_NUM(uniques_list);\
-    uniques_list = DARR_REALLOC(uniques_list, (DARR_NUM(uniques_list) < NMATH_MINLEN? NMATH_MINLEN : DARR_NUM(uniques_list)));\
+    nmath_free(set);\
+    DARR_SHRINK(uniques_list);\
     return (uniques_list);\
 }
 TEMPLATE_TYPES_INT
@@ -366,18 +2696,39 @@ TEMPLATE_TYPES_FLOAT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
+#define REGISTER_ENUM(type) type * linalg_uniques_##type(type * array, size_t arr_len) {\
+    return (nmath_uniques_ND_##type(array, arr_len, NMATH_ONE_D));\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_uniques_2D_##type(type * list_2D, size_t list_len) {\
+    return (nmath_uniques_ND_##type(list_2D, list_len, NMATH_TWO_D));\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_uniques_3D_##type(type * list_3D, size_t list_len) {\
+    return (nmath_uniques_ND_##type(list_3D, list_len, NMATH_THREE_D));\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
 #define REGISTER_ENUM(type) bool linalg_isIn_##type(type * array, type to_find, size_t arr_len) {\
-    bool found = false;\
-    for (size_t i = 0; i < arr_len; i++) {\
-        if (array[i] == to_find) {\
-            found = true;\
-            break;\
-        }\
-    }\
-    return (found);\
+    return (nmath_kernel_find_equal_##type(array, to_find, arr_len));\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* bool is 0 or 1 in one byte: use the uint8_t kernels */
+#define REGISTER_ENUM(type) bool linalg_isIn_##type(type * array, type to_find, size_t arr_len) {\
+    return (nmath_kernel_find_equal_uint8_t((uint8_t *)array, to_find, arr_len));\
+}
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
@@ -418,7 +2769,7 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) extern type * linalg_draw_circ_##type(type origin_x, type origin_y, size_t diameter, size_t row_len, size_t col_len){\
-    type * out_mat = calloc(row_len*col_len, sizeof(type));\
+    type * out_mat = nmath_calloc(row_len*col_len, sizeof(type));\
     size_t radius = diameter / 2;\
     size_t row_min = (origin_y - radius - 1) < 0 ? 0 : (origin_y - radius - 1);\
     size_t row_max = (origin_y + radius + 1) > row_len ? row_len : (origin_y + radius + 1);\
@@ -454,7 +2805,7 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) extern type * linalg_draw_rect_##type(type origin_x, type origin_y, size_t width, size_t height, size_t row_len, size_t col_len){\
-    type * out_mat = calloc(row_len*col_len, sizeof(type));\
+    type * out_mat = nmath_calloc(row_len*col_len, sizeof(type));\
     size_t row_min = origin_y < 0 ? 0 : origin_y;\
     size_t row_max = (origin_y + height) > row_len ? row_len : (origin_y + height);\
     size_t col_min = origin_x < 0 ? 0 : origin_x;\
@@ -494,94 +2845,76 @@ TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_smaller_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] < matrix2[i]);\
-    }\
-return (out);\
+    nmath_kernel_smaller_##type(out, matrix1, matrix2, arr_len);\
+    return (out);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_smaller_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] < matrix2[i]);\
-    }\
-return (out);\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_smaller_##type(out, matrix1, matrix2, arr_len);\
+    return (out);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_sseq_noM_##type(type * out, type * matrix1, type tocompare, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] <= tocompare);\
-    }\
-return (out);\
+    nmath_kernel_sseq_##type(out, matrix1, tocompare, arr_len);\
+    return (out);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_sseq_##type(type * matrix1, type tocompare, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] <= tocompare);\
-    }\
-return (out);\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_sseq_##type(out, matrix1, tocompare, arr_len);\
+    return (out);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_sgeq_noM_##type(type * out, type * matrix1, type tocompare, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] >= tocompare);\
-    }\
-return (out);\
+    nmath_kernel_sgeq_##type(out, matrix1, tocompare, arr_len);\
+    return (out);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_sgeq_##type(type * matrix1, type tocompare, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] >= tocompare);\
-    }\
-return (out);\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_sgeq_##type(out, matrix1, tocompare, arr_len);\
+    return (out);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_ssmaller_noM_##type(type * out, type * matrix1, type tocompare, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] < tocompare);\
-    }\
-return (out);\
+    nmath_kernel_ssmaller_##type(out, matrix1, tocompare, arr_len);\
+    return (out);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_ssmaller_##type(type * matrix1, type tocompare, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] < tocompare);\
-    }\
-return (out);\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_ssmaller_##type(out, matrix1, tocompare, arr_len);\
+    return (out);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_sgreater_noM_##type(type * out, type * matrix1, type tocompare, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] > tocompare);\
-    }\
-return (out);\
+    nmath_kernel_sgreater_##type(out, matrix1, tocompare, arr_len);\
+    return (out);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
@@ -589,100 +2922,161 @@ TEMPLATE_TYPES_BOOL
 
 
 #define REGISTER_ENUM(type) type * linalg_sgreater_##type(type * matrix1, type tocompare, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] > tocompare);\
-    }\
-return (out);\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_sgreater_##type(out, matrix1, tocompare, arr_len);\
+    return (out);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_seq_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] <= matrix2[i]);\
-    }\
-return (out);\
+    nmath_kernel_seq_##type(out, matrix1, matrix2, arr_len);\
+    return (out);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_seq_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] <= matrix2[i]);\
-    }\
-return (out);\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_seq_##type(out, matrix1, matrix2, arr_len);\
+    return (out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_greater_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
+    nmath_kernel_greater_##type(out, matrix1, matrix2, arr_len);\
+    return (out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_greater_##type(type * matrix1, type * matrix2, size_t arr_len) {\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_greater_##type(out, matrix1, matrix2, arr_len);\
+    return (out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_geq_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
+    nmath_kernel_geq_##type(out, matrix1, matrix2, arr_len);\
+    return (out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_geq_##type(type * matrix1, type * matrix2, size_t arr_len) {\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_geq_##type(out, matrix1, matrix2, arr_len);\
+    return (out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_equal_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
+    nmath_kernel_equal_##type(out, matrix1, matrix2, arr_len);\
+    return (out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_equal_##type(type * matrix1, type * matrix2, size_t arr_len) {\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_equal_##type(out, matrix1, matrix2, arr_len);\
+    return (out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) bit_array_t * linalg_smaller_bitmask_##type(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len) {\
+    nmath_kernel_smaller_bitmask_##type(mask, matrix1, matrix2, arr_len);\
+    return (mask);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) bit_array_t * linalg_seq_bitmask_##type(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len) {\
+    nmath_kernel_seq_bitmask_##type(mask, matrix1, matrix2, arr_len);\
+    return (mask);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) bit_array_t * linalg_greater_bitmask_##type(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len) {\
+    nmath_kernel_greater_bitmask_##type(mask, matrix1, matrix2, arr_len);\
+    return (mask);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) type * linalg_greater_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] > matrix2[i]);\
-    }\
-return (out);\
+#define REGISTER_ENUM(type) bit_array_t * linalg_geq_bitmask_##type(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len) {\
+    nmath_kernel_geq_bitmask_##type(mask, matrix1, matrix2, arr_len);\
+    return (mask);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) type * linalg_greater_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] > matrix2[i]);\
-    }\
-return (out);\
+#define REGISTER_ENUM(type) bit_array_t * linalg_equal_bitmask_##type(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len) {\
+    nmath_kernel_equal_bitmask_##type(mask, matrix1, matrix2, arr_len);\
+    return (mask);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) type * linalg_geq_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] >= matrix2[i]);\
-    }\
-return (out);\
+#define REGISTER_ENUM(type) bit_array_t * linalg_ssmaller_bitmask_##type(bit_array_t * mask, type * matrix1, type tocompare, size_t arr_len) {\
+    nmath_kernel_ssmaller_bitmask_##type(mask, matrix1, tocompare, arr_len);\
+    return (mask);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) type * linalg_geq_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] >= matrix2[i]);\
-    }\
-return (out);\
+#define REGISTER_ENUM(type) bit_array_t * linalg_sseq_bitmask_##type(bit_array_t * mask, type * matrix1, type tocompare, size_t arr_len) {\
+    nmath_kernel_sseq_bitmask_##type(mask, matrix1, tocompare, arr_len);\
+    return (mask);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) type * linalg_equal_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] == matrix2[i]);\
-    }\
-return (out);\
+#define REGISTER_ENUM(type) bit_array_t * linalg_sgreater_bitmask_##type(bit_array_t * mask, type * matrix1, type tocompare, size_t arr_len) {\
+    nmath_kernel_sgreater_bitmask_##type(mask, matrix1, tocompare, arr_len);\
+    return (mask);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) type * linalg_equal_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] == matrix2[i]);\
-    }\
-return (out);\
+#define REGISTER_ENUM(type) bit_array_t * linalg_sgeq_bitmask_##type(bit_array_t * mask, type * matrix1, type tocompare, size_t arr_len) {\
+    nmath_kernel_sgeq_bitmask_##type(mask, matrix1, tocompare, arr_len);\
+    return (mask);\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
+#define REGISTER_ENUM(type) bit_array_t * linalg_equal_bitmask_##type(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len, type tolerance) {\
+    nmath_kernel_equal_bitmask_##type(mask, matrix1, matrix2, arr_len, tolerance);\
+    return (mask);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
 #define REGISTER_ENUM(type) bool * linalg_equal_noM_##type(bool * out, type * matrix1, type * matrix2, size_t arr_len, type tolerance) {\
     for (size_t i = 0; i < arr_len; i++) {\
         out[i] = (fabs(matrix1[i] - matrix2[i]) < tolerance);\
@@ -693,7 +3087,7 @@ TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) bool * linalg_equal_##type(type * matrix1, type * matrix2, size_t arr_len, type tolerance) {\
-    bool * out = calloc(arr_len, sizeof(type));\
+    bool * out = nmath_calloc(arr_len, sizeof(type));\
     for (size_t i = 0; i < arr_len; i++) {\
         out[i] = (fabs(matrix1[i] - matrix2[i]) < tolerance);\
     }\
@@ -703,35 +3097,65 @@ TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) bool linalg_any_##type(type * arr, size_t arr_len) {\
-    bool equal = false;\
-    for (size_t i = 0; i < arr_len; i++) {\
-        if (arr[i]) {\
-            equal = true;\
-            break;\
-        }\
-    }\
-return (equal);\
+    return (nmath_kernel_find_nequal_##type(arr, 0, arr_len));\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) bool linalg_any_##type(type * arr, size_t arr_len) {\
+    return (nmath_kernel_find_nequal_uint8_t((uint8_t *)arr, 0, arr_len));\
+}
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) bool linalg_all_##type(type * arr, size_t arr_len) {\
-    bool equal = true;\
-    for (size_t i = 0; i < arr_len; i++) {\
-        if (!arr[i]) {\
-            equal = false;\
-            break;\
-        }\
-    }\
-return (equal);\
+    return (!nmath_kernel_find_equal_##type(arr, 0, arr_len));\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) bool linalg_all_##type(type * arr, size_t arr_len) {\
+    return (!nmath_kernel_find_equal_uint8_t((uint8_t *)arr, 0, arr_len));\
+}
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) size_t linalg_count_##type(type * arr, type to_count, size_t arr_len) {\
+    return (nmath_kernel_count_##type(arr, to_count, arr_len));\
 }
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) size_t linalg_count_##type(type * arr, type to_count, size_t arr_len) {\
+    return (nmath_kernel_count_uint8_t((uint8_t *)arr, to_count, arr_len));\
+}
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
+#define REGISTER_ENUM(type) type linalg_sum_##type(type * arr, size_t arr_len) {\
+    return (nmath_kernel_sum_##type(arr, arr_len));\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type linalg_min_##type(type * arr, size_t arr_len) {\
+    return ((arr_len > 0) ? nmath_kernel_min_##type(arr, arr_len) : 0);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type linalg_max_##type(type * arr, size_t arr_len) {\
+    return ((arr_len > 0) ? nmath_kernel_max_##type(arr, arr_len) : 0);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
 #define REGISTER_ENUM(type) type * linalg_and_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
     for (size_t i = 0; i < arr_len; i++) {\
         out[i] = (matrix1[i] && matrix2[i]);\
@@ -744,7 +3168,7 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_and_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
     for (size_t i = 0; i < arr_len; i++) {\
         out[i] = (matrix1[i] && matrix2[i]);\
     }\
@@ -767,7 +3191,7 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_or_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
     for (size_t i = 0; i < arr_len; i++) {\
         out[i] = (matrix1[i] || matrix2[i]);\
     }\
@@ -779,9 +3203,7 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_sub_noM_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            matrix1[i] -= matrix2[i];\
-    }\
+    nmath_kernel_minus_##type(matrix1, matrix1, matrix2, arr_len);\
     return (matrix1);\
 }
 TEMPLATE_TYPES_INT
@@ -790,9 +3212,7 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_plus_noM_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            matrix1[i] += matrix2[i];\
-    }\
+    nmath_kernel_plus_##type(matrix1, matrix1, matrix2, arr_len);\
     return (matrix1);\
 }
 TEMPLATE_TYPES_INT
@@ -801,10 +3221,8 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_plus_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = matrix1[i] + matrix2[i];\
-    }\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_plus_##type(out, matrix1, matrix2, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -813,9 +3231,7 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_plus_scalar_noM_##type(type * out, type * matrix, type value, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = matrix[i] + value;\
-    }\
+    nmath_kernel_plus_scalar_##type(out, matrix, value, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -824,10 +3240,8 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_plus_scalar_##type(type * matrix, type value, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = matrix[i] + value;\
-    }\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_plus_scalar_##type(out, matrix, value, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -836,9 +3250,7 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_minus_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] - matrix2[i]);\
-    }\
+    nmath_kernel_minus_##type(out, matrix1, matrix2, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -847,10 +3259,8 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_minus_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix1[i] - matrix2[i]);\
-    }\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_minus_##type(out, matrix1, matrix2, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -859,9 +3269,7 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_minus_scalar_noM_##type(type * out, type * matrix, type value, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix[i] - value);\
-    }\
+    nmath_kernel_minus_scalar_##type(out, matrix, value, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -870,10 +3278,8 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_minus_scalar_##type(type * matrix, type value, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = (matrix[i] - value);\
-    }\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_minus_scalar_##type(out, matrix, value, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -882,9 +3288,7 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_mult_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = matrix1[i] * matrix2[i];\
-    }\
+    nmath_kernel_mult_##type(out, matrix1, matrix2, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -892,10 +3296,8 @@ TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_mult_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = matrix1[i] * matrix2[i];\
-    }\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_mult_##type(out, matrix1, matrix2, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -903,9 +3305,7 @@ TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_mult_scalar_noM_##type(type * out, type * matrix, type mult, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = matrix[i] * mult;\
-    }\
+    nmath_kernel_mult_scalar_##type(out, matrix, mult, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -913,10 +3313,8 @@ TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_mult_scalar_##type(type * matrix, type mult, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = matrix[i] * mult;\
-    }\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_mult_scalar_##type(out, matrix, mult, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -924,9 +3322,7 @@ TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_div_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = matrix1[i] / matrix2[i];\
-    }\
+    nmath_kernel_div_##type(out, matrix1, matrix2, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -934,10 +3330,8 @@ TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_div_##type(type * matrix1, type * matrix2, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = matrix1[i] / matrix2[i];\
-    }\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_div_##type(out, matrix1, matrix2, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -945,9 +3339,7 @@ TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_div_scalar_noM_##type(type * out, type * matrix, type mult, size_t arr_len) {\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = matrix[i] / mult;\
-    }\
+    nmath_kernel_div_scalar_##type(out, matrix, mult, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -955,10 +3347,25 @@ TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_div_scalar_##type(type * matrix, type mult, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
-    for (size_t i = 0; i < arr_len; i++) {\
-            out[i] = matrix[i] / mult;\
-    }\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_div_scalar_##type(out, matrix, mult, arr_len);\
+    return (out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_mask_noM_##type(type * out, type * matrix, type * mask, size_t arr_len) {\
+    nmath_kernel_mask_##type(out, matrix, mask, arr_len);\
+    return (out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_mask_##type(type * matrix, type * mask, size_t arr_len) {\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    nmath_kernel_mask_##type(out, matrix, mask, arr_len);\
     return (out);\
 }
 TEMPLATE_TYPES_INT
@@ -971,21 +3378,107 @@ TEMPLATE_TYPES_FLOAT
     }\
     return (out);\
 }
-TEMPLATE_TYPES_INT
-TEMPLATE_TYPES_FLOAT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_mask_##type(type * matrix, type * mask, size_t arr_len) {\
-    type * out = calloc(arr_len, sizeof(type));\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
     for (size_t i = 0; i < arr_len; i++) {\
         out[i] = matrix[i] && (mask[i] > 0);\
     }\
     return (out);\
 }
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+/* Fused pipeline: each op reads the previous op's output chunk, still in L1.
+*  Op 0 reads matrix, later ops work in place in out. */
+#define REGISTER_ENUM(type) type * linalg_fused_noM_##type(type * out, type * matrix, struct nmath_fused_op_##type * ops, size_t op_num, size_t arr_len) {\
+    NMATH_PARALLEL_FOR(arr_len)\
+    for (size_t start = 0; start < arr_len; start += NMATH_FUSED_CHUNK_LEN(type)) {\
+        size_t len = ((arr_len - start) < NMATH_FUSED_CHUNK_LEN(type)) ? (arr_len - start) : NMATH_FUSED_CHUNK_LEN(type);\
+        type * chunk = out + start;\
+        type * src = matrix + start;\
+        if ((op_num == 0) && (chunk != src)) {\
+            memcpy(chunk, src, len * sizeof(type));\
+        }\
+        for (size_t o = 0; o < op_num; o++) {\
+            type * operand = (ops[o].operand != NULL) ? (ops[o].operand + start) : NULL;\
+            type scalar = ops[o].scalar;\
+            switch (ops[o].op) {\
+                case NMATH_FUSED_PLUS:\
+                    nmath_kernel_plus_##type(chunk, src, operand, len);\
+                    break;\
+                case NMATH_FUSED_MINUS:\
+                    nmath_kernel_minus_##type(chunk, src, operand, len);\
+                    break;\
+                case NMATH_FUSED_MULT:\
+                    nmath_kernel_mult_##type(chunk, src, operand, len);\
+                    break;\
+                case NMATH_FUSED_DIV:\
+                    nmath_kernel_div_##type(chunk, src, operand, len);\
+                    break;\
+                case NMATH_FUSED_MASK:\
+                    nmath_kernel_mask_##type(chunk, src, operand, len);\
+                    break;\
+                case NMATH_FUSED_SMALLER:\
+                    nmath_kernel_smaller_##type(chunk, src, operand, len);\
+                    break;\
+                case NMATH_FUSED_SEQ:\
+                    nmath_kernel_seq_##type(chunk, src, operand, len);\
+                    break;\
+                case NMATH_FUSED_GREATER:\
+                    nmath_kernel_greater_##type(chunk, src, operand, len);\
+                    break;\
+                case NMATH_FUSED_GEQ:\
+                    nmath_kernel_geq_##type(chunk, src, operand, len);\
+                    break;\
+                case NMATH_FUSED_EQUAL:\
+                    nmath_kernel_equal_##type(chunk, src, operand, len);\
+                    break;\
+                case NMATH_FUSED_PLUS_SCALAR:\
+                    nmath_kernel_plus_scalar_##type(chunk, src, scalar, len);\
+                    break;\
+                case NMATH_FUSED_MINUS_SCALAR:\
+                    nmath_kernel_minus_scalar_##type(chunk, src, scalar, len);\
+                    break;\
+                case NMATH_FUSED_MULT_SCALAR:\
+                    nmath_kernel_mult_scalar_##type(chunk, src, scalar, len);\
+                    break;\
+                case NMATH_FUSED_DIV_SCALAR:\
+                    nmath_kernel_div_scalar_##type(chunk, src, scalar, len);\
+                    break;\
+                case NMATH_FUSED_SSMALLER:\
+                    nmath_kernel_ssmaller_##type(chunk, src, scalar, len);\
+                    break;\
+                case NMATH_FUSED_SSEQ:\
+                    nmath_kernel_sseq_##type(chunk, src, scalar, len);\
+                    break;\
+                case NMATH_FUSED_SGREATER:\
+                    nmath_kernel_sgreater_##type(chunk, src, scalar, len);\
+                    break;\
+                case NMATH_FUSED_SGEQ:\
+                    nmath_kernel_sgeq_##type(chunk, src, scalar, len);\
+                    break;\
+                default:\
+                    assert(false);\
+                    break;\
+            }\
+            src = chunk;\
+        }\
+    }\
+    return (out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_fused_##type(type * matrix, struct nmath_fused_op_##type * ops, size_t op_num, size_t arr_len) {\
+    type * out = nmath_calloc(arr_len, sizeof(type));\
+    return (linalg_fused_noM_##type(out, matrix, ops, op_num, arr_len));\
+}
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
-TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_list2matrix_noM_##type(type * out, type * list, size_t row_len, size_t col_len, size_t list_len) {\
@@ -999,7 +3492,7 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * linalg_list2matrix_##type(type * list, size_t row_len, size_t col_len, size_t list_len) {\
-    type * out = calloc(row_len * col_len, sizeof(type));\
+    type * out = nmath_calloc(row_len * col_len, sizeof(type));\
     for (size_t elem = 0; elem < list_len; elem++) {\
         out[list[2 * elem + 1] * col_len + list[2 * elem + 0]] = 1;\
     }\
@@ -1014,8 +3507,8 @@ TEMPLATE_TYPES_BOOL
     for (size_t col = 0; col < col_len; col++) {\
         for (size_t row = 0; row < row_len; row++) {\
             if (matrix[row * col_len + col] > 0) {\
-                DARR_PUT(list, col);\
-                DARR_PUT(list, row);\
+                type point[NMATH_TWO_D] = {col, row};\
+                DARR_APPEND_N(list, point, NMATH_TWO_D);\
             }\
         }\
     }\
@@ -1030,12 +3523,12 @@ TEMPLATE_TYPES_BOOL
     for (size_t col = 0; col < col_len; col++) {\
         for (size_t row = 0; row < row_len; row++) {\
             if (matrix[row * col_len + col] > 0) {\
-                DARR_PUT(list, col);\
-                DARR_PUT(list, row);\
+                type point[NMATH_TWO_D] = {col, row};\
+                DARR_APPEND_N(list, point, NMATH_TWO_D);\
             }\
         }\
     }\
-    list = DARR_REALLOC(list, (DARR_NUM(list) < NMATH_MINLEN? NMATH_MINLEN :DARR_NUM(list)));\
+    DARR_SHRINK(list);\
     return (list);\
 }
 TEMPLATE_TYPES_INT
@@ -1103,25 +3596,301 @@ TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
-/******************************* PATHFINDING ***********************************/
+/******************************** SORTING *************************************/
+/* Integers and bool: LSD radix sort, one pass per byte, skipping passes
+*  where all keys share the same byte. Signed keys get their sign bit
+*  flipped so that unsigned byte order matches signed order.
+*  Floats: introsort. Median of 3 pivot, Hoare partition, heapsort when
+*  depth exceeds 2 * log2(n), insertion sort below NMATH_SORT_INSERTION. */
+#define NMATH_SORT_INSERTION 16
+#define NMATH_SORT_RADIX 256
+
+#define REGISTER_ENUM(type) static uint64_t nmath_radix_key_##type(type value) {\
+    uint64_t key = (uint64_t)value;\
+    if ((type)-1 < (type)0) {\
+        key ^= (1ULL << (sizeof(type) * CHAR_BIT - 1));\
+    }\
+    return (key & (UINT64_MAX >> (64 - sizeof(type) * CHAR_BIT)));\
+}\
+static void nmath_radixsort_##type(type * array, type * buffer, size_t * indices, size_t * ibuffer, size_t arr_len) {\
+    size_t counts[NMATH_SORT_RADIX];\
+    type * src = array, * dst = buffer, * temp;\
+    size_t * isrc = indices, * idst = ibuffer, * itemp;\
+    if (arr_len < 2) {\
+        return;\
+    }\
+    for (size_t shift = 0; shift < (sizeof(type) * CHAR_BIT); shift += CHAR_BIT) {\
+        memset(counts, 0, sizeof(counts));\
+        for (size_t i = 0; i < arr_len; i++) {\
+            counts[(nmath_radix_key_##type(src[i]) >> shift) & (NMATH_SORT_RADIX - 1)]++;\
+        }\
+        if (counts[(nmath_radix_key_##type(src[0]) >> shift) & (NMATH_SORT_RADIX - 1)] == arr_len) {\
+            continue;\
+        }\
+        size_t sum = 0, count;\
+        for (size_t digit = 0; digit < NMATH_SORT_RADIX; digit++) {\
+            count = counts[digit];\
+            counts[digit] = sum;\
+            sum += count;\
+        }\
+        for (size_t i = 0; i < arr_len; i++) {\
+            size_t pos = counts[(nmath_radix_key_##type(src[i]) >> shift) & (NMATH_SORT_RADIX - 1)]++;\
+            dst[pos] = src[i];\
+            if (isrc != NULL) {\
+                idst[pos] = isrc[i];\
+            }\
+        }\
+        temp = src, src = dst, dst = temp;\
+        itemp = isrc, isrc = idst, idst = itemp;\
+    }\
+    if (src != array) {\
+        memcpy(array, src, sizeof(*array) * arr_len);\
+        if (indices != NULL) {\
+            memcpy(indices, isrc, sizeof(*indices) * arr_len);\
+        }\
+    }\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+/* NMATH_INTROSORT: defines static introsort name for elem_t arrays,
+*  ordered by the strict weak ordering LESS(a, b). */
+#define NMATH_INTROSORT(name, elem_t, LESS) \
+static void name##_insertion(elem_t * arr, size_t len) {\
+    for (size_t i = 1; i < len; i++) {\
+        elem_t elem = arr[i];\
+        size_t j = i;\
+        while ((j > 0) && LESS(elem, arr[j - 1])) {\
+            arr[j] = arr[j - 1];\
+            j--;\
+        }\
+        arr[j] = elem;\
+    }\
+}\
+static void name##_siftdown(elem_t * arr, size_t root, size_t len) {\
+    elem_t elem = arr[root];\
+    size_t child;\
+    while ((child = 2 * root + 1) < len) {\
+        if (((child + 1) < len) && LESS(arr[child], arr[child + 1])) {\
+            child++;\
+        }\
+        if (!LESS(elem, arr[child])) {\
+            break;\
+        }\
+        arr[root] = arr[child];\
+        root = child;\
+    }\
+    arr[root] = elem;\
+}\
+static void name##_heapsort(elem_t * arr, size_t len) {\
+    elem_t elem;\
+    for (size_t i = len / 2; i > 0; i--) {\
+        name##_siftdown(arr, i - 1, len);\
+    }\
+    for (size_t i = len - 1; i > 0; i--) {\
+        elem = arr[0], arr[0] = arr[i], arr[i] = elem;\
+        name##_siftdown(arr, 0, i);\
+    }\
+}\
+static void name##_loop(elem_t * arr, size_t len, size_t depth) {\
+    elem_t pivot, elem;\
+    while (len > NMATH_SORT_INSERTION) {\
+        if (depth-- == 0) {\
+            name##_heapsort(arr, len);\
+            return;\
+        }\
+        size_t mid = (len - 1) / 2;\
+        if (LESS(arr[mid], arr[0])) {\
+            elem = arr[mid], arr[mid] = arr[0], arr[0] = elem;\
+        }\
+        if (LESS(arr[len - 1], arr[mid])) {\
+            elem = arr[mid], arr[mid] = arr[len - 1], arr[len - 1] = elem;\
+            if (LESS(arr[mid], arr[0])) {\
+                elem = arr[mid], arr[mid] = arr[0], arr[0] = elem;\
+            }\
+        }\
+        pivot = arr[mid];\
+        size_t i = 0, j = len - 1;\
+        while (true) {\
+            while (LESS(arr[i], pivot)) {\
+                i++;\
+            }\
+            while (LESS(pivot, arr[j])) {\
+                j--;\
+            }\
+            if (i >= j) {\
+                break;\
+            }\
+            elem = arr[i], arr[i] = arr[j], arr[j] = elem;\
+            i++, j--;\
+        }\
+        /* recurse on the smaller side, loop on the larger one */\
+        if ((j + 1) < (len - j - 1)) {\
+            name##_loop(arr, j + 1, depth);\
+            arr += j + 1;\
+            len -= j + 1;\
+        } else {\
+            name##_loop(arr + j + 1, len - j - 1, depth);\
+            len = j + 1;\
+        }\
+    }\
+    name##_insertion(arr, len);\
+}\
+static void name(elem_t * arr, size_t len) {\
+    size_t depth = 0;\
+    for (size_t i = len; i > 1; i >>= 1) {\
+        depth += 2;\
+    }\
+    name##_loop(arr, len, depth);\
+}
+
+#define NMATH_SORT_LESS(a, b) ((a) < (b))
+#define NMATH_ARGSORT_LESS(a, b) (((a).value < (b).value) || (((a).value == (b).value) && ((a).index < (b).index)))
+
+#define REGISTER_ENUM(type) struct nmath_argsort_##type {\
+    type value;\
+    size_t index;\
+};\
+NMATH_INTROSORT(nmath_introsort_##type, type, NMATH_SORT_LESS)\
+NMATH_INTROSORT(nmath_argintrosort_##type, struct nmath_argsort_##type, NMATH_ARGSORT_LESS)
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_sort_noM_##type(type * array, type * buffer, size_t arr_len) {\
+    nmath_radixsort_##type(array, buffer, NULL, NULL, arr_len);\
+    return (array);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_sort_noM_##type(type * array, type * buffer, size_t arr_len) {\
+    nmath_introsort_##type(array, arr_len);\
+    return (array);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_sort_##type(type * array, size_t arr_len) {\
+    type * sorted = nmath_calloc(arr_len, sizeof(*sorted));\
+    type * buffer = nmath_calloc(arr_len, sizeof(*buffer));\
+    memcpy(sorted, array, sizeof(*sorted) * arr_len);\
+    linalg_sort_noM_##type(sorted, buffer, arr_len);\
+    nmath_free(buffer);\
+    return (sorted);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) type * linalg_sort_##type(type * array, size_t arr_len) {\
+    type * sorted = nmath_calloc(arr_len, sizeof(*sorted));\
+    memcpy(sorted, array, sizeof(*sorted) * arr_len);\
+    nmath_introsort_##type(sorted, arr_len);\
+    return (sorted);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) type nmath_Direction_Compute_##type(type x_0, type y_0, type x_1, type y_1) { \
-    /* Movement direction for 1 tile steps. on a square grid*/ \
-    type direction = 0; \
-    type deltax = x_1 - x_0; \
-    type deltay = y_1 - y_0; \
-    if (deltax > 0) { \
-        direction = NMATH_DIRECTION_RIGHT; \
-    } else if (deltax < 0) { \
-        direction = NMATH_DIRECTION_LEFT; \
-    } else if (deltay > 0) { \
-        direction = NMATH_DIRECTION_UP; \
-    } else if (deltay < 0) { \
-        direction = NMATH_DIRECTION_DOWN; \
-    } \
-    return (direction); \
+#define REGISTER_ENUM(type) size_t * linalg_argsort_##type(type * array, size_t arr_len) {\
+    size_t * indices = nmath_calloc(arr_len, sizeof(*indices));\
+    size_t * ibuffer = nmath_calloc(arr_len, sizeof(*ibuffer));\
+    type * keys = nmath_calloc(arr_len, sizeof(*keys));\
+    type * buffer = nmath_calloc(arr_len, sizeof(*buffer));\
+    memcpy(keys, array, sizeof(*keys) * arr_len);\
+    for (size_t i = 0; i < arr_len; i++) {\
+        indices[i] = i;\
+    }\
+    nmath_radixsort_##type(keys, buffer, indices, ibuffer, arr_len);\
+    nmath_free(ibuffer);\
+    nmath_free(keys);\
+    nmath_free(buffer);\
+    return (indices);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) size_t * linalg_argsort_##type(type * array, size_t arr_len) {\
+    size_t * indices = nmath_calloc(arr_len, sizeof(*indices));\
+    struct nmath_argsort_##type * pairs = nmath_calloc(arr_len, sizeof(*pairs));\
+    for (size_t i = 0; i < arr_len; i++) {\
+        pairs[i].value = array[i];\
+        pairs[i].index = i;\
+    }\
+    nmath_argintrosort_##type(pairs, arr_len);\
+    for (size_t i = 0; i < arr_len; i++) {\
+        indices[i] = pairs[i].index;\
+    }\
+    nmath_free(pairs);\
+    return (indices);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) size_t linalg_searchsorted_##type(type * sorted, size_t arr_len, type value) {\
+    size_t low = 0, high = arr_len, mid;\
+    while (low < high) {\
+        mid = low + (high - low) / 2;\
+        if (sorted[mid] < value) {\
+            low = mid + 1;\
+        } else {\
+            high = mid;\
+        }\
+    }\
+    return (low);\
 }
 TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+/******************************* PATHFINDING ***********************************/
+
+/* Padded grid: costmap copied with a border of blocked tiles, 1 tile wide.
+*  Every tile has all its neighbours in memory: Moveto, unitGradient and
+*  Astar visit them by linear index offsets, without clamping. Clamping made
+*  out of bounds neighbours alias the current tile.
+*  Tile (x, y) is at NMATH_PADDED_INDEX(x, y, col_len). */
+#define NMATH_PADDED_LEN(len) ((len) + 2)
+#define NMATH_PADDED_INDEX(x, y, col_len) (((size_t)(y) + 1) * NMATH_PADDED_LEN(col_len) + ((size_t)(x) + 1))
+
+/* Neighbours in q_cycle4_mzpz/zmzp (square) or q_cycle6_mppmzz/pmzzmp
+*  (hexagon) order. offset: unpadded grid, only for in bounds neighbours. */
+struct nmath_neighbours {
+    int dx[NMATH_HEXAGON_NEIGHBOURS];
+    int dy[NMATH_HEXAGON_NEIGHBOURS];
+    ptrdiff_t padded[NMATH_HEXAGON_NEIGHBOURS];
+    ptrdiff_t offset[NMATH_HEXAGON_NEIGHBOURS];
+};
+
+static void nmath_neighbours_init(struct nmath_neighbours * neighbours, size_t col_len, int neighbour_num) {
+    for (int i = 0; i < neighbour_num; i++) {
+        neighbours->dx[i] = (neighbour_num == NMATH_SQUARE_NEIGHBOURS) ? q_cycle4_mzpz(i) : q_cycle6_mppmzz(i);
+        neighbours->dy[i] = (neighbour_num == NMATH_SQUARE_NEIGHBOURS) ? q_cycle4_zmzp(i) : q_cycle6_pmzzmp(i);
+        neighbours->padded[i] = neighbours->dy[i] * (ptrdiff_t)NMATH_PADDED_LEN(col_len) + neighbours->dx[i];
+        neighbours->offset[i] = neighbours->dy[i] * (ptrdiff_t)col_len + neighbours->dx[i];
+    }
+}
+
+#define REGISTER_ENUM(type) static type * nmath_pad_##type(type * matrix, size_t row_len, size_t col_len, type border) {\
+    size_t padded_col_len = NMATH_PADDED_LEN(col_len);\
+    type * padded = nmath_malloc(NMATH_PADDED_LEN(row_len) * padded_col_len * sizeof(*padded));\
+    for (size_t col = 0; col < padded_col_len; col++) {\
+        padded[col] = border;\
+        padded[(row_len + 1) * padded_col_len + col] = border;\
+    }\
+    for (size_t row = 0; row < row_len; row++) {\
+        type * padded_row = padded + (row + 1) * padded_col_len;\
+        padded_row[0] = border;\
+        memcpy(padded_row + 1, matrix + row * col_len, col_len * sizeof(*padded));\
+        padded_row[col_len + 1] = border;\
+    }\
+    return (padded);\
+}
+TEMPLATE_TYPES_SINT
+TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 
@@ -1162,7 +3931,7 @@ TEMPLATE_TYPES_SINT
             pushpulltomap = DARR_INIT(pushpulltomap, type, row_len * col_len * NMATH_TWO_D);\
             break;\
         case (NMATH_POINTS_MODE_MATRIX):\
-            pushpulltomap = calloc(row_len * col_len, sizeof(*pushpulltomap));\
+            pushpulltomap = nmath_calloc(row_len * col_len, sizeof(*pushpulltomap));\
             for (size_t row = 0; row < row_len; row++) {\
                 for (size_t col = 0; col < col_len; col++) {\
                     pushpulltomap[(row * col_len + col)] = NMATH_PUSHPULLMAP_BLOCKED;\
@@ -1179,8 +3948,7 @@ TEMPLATE_TYPES_SINT
                 pushpullto_tile.y = nmath_inbounds_##type((distance * q_cycle4_zmzp(sq_neighbor)) + start.y, 0, row_len - 1);\
                 switch (mode_output) {\
                     case NMATH_POINTS_MODE_LIST:\
-                        DARR_PUT(pushpulltomap, pushpullto_tile.x);\
-                        DARR_PUT(pushpulltomap, pushpullto_tile.y);\
+                        DARR_APPEND_N(pushpulltomap, (type *)&pushpullto_tile, NMATH_TWO_D);\
                         break;\
                     case NMATH_POINTS_MODE_MATRIX:\
                         pushpulltomap[pushpullto_tile.y * col_len + pushpullto_tile.x] = distance;\
@@ -1195,6 +3963,8 @@ TEMPLATE_TYPES_SINT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * pathfinding_Map_unitGradient_noM_##type(type * unitgradientmap, type * in_costmap, size_t row_len, size_t col_len, struct nmath_point_##type * in_targets, size_t unit_num) {\
+    NMATH_HISTOGRAM_START;\
+    NMATH_STATS_BEGIN;\
     for (type  col = 0; col < col_len; col++) {\
         for (type  row = 0; row < row_len; row++) {\
             if (in_costmap[row * col_len + col] < NMATH_PUSHPULLMAP_BLOCKED) {\
@@ -1204,6 +3974,9 @@ TEMPLATE_TYPES_SINT
             }\
         }\
     }\
+    type * padded = nmath_pad_##type(in_costmap, row_len, col_len, 0);\
+    struct nmath_neighbours neighbours;\
+    nmath_neighbours_init(&neighbours, col_len, NMATH_SQUARE_NEIGHBOURS);\
     struct nmath_node_##type * open = DARR_INIT(open, struct nmath_node_##type, row_len * col_len);\
     struct nmath_node_##type * closed = DARR_INIT(closed, struct nmath_node_##type, row_len * col_len);\
     struct nmath_node_##type current, neighbor;\
@@ -1213,42 +3986,57 @@ TEMPLATE_TYPES_SINT
         current.y = in_targets[i].y;\
         current.distance = 1;\
         DARR_PUT(open, current);\
+        NMATH_STATS_ADD(pushes, 1);\
     }\
     while (DARR_NUM(open) > 0) {\
         current = DARR_POP(open);\
+        NMATH_STATS_ADD(pops, 1);\
         DARR_PUT(closed, current);\
+        size_t current_index = current.y * col_len + current.x;\
+        size_t current_padded = NMATH_PADDED_INDEX(current.x, current.y, col_len);\
         for (type  sq_neighbor = 0; sq_neighbor < NMATH_SQUARE_NEIGHBOURS; sq_neighbor++) {\
-            neighbor.x = nmath_inbounds_##type(q_cycle4_mzpz(sq_neighbor) + current.x, 0, col_len - 1);\
-            neighbor.y = nmath_inbounds_##type(q_cycle4_zmzp(sq_neighbor) + current.y, 0, row_len - 1);\
-            neighbor.distance = unitgradientmap[current.y * col_len + current.x] + 1;\
-            if (in_costmap[neighbor.y * col_len + neighbor.x] >= NMATH_COSTMAP_MOVEABLEMIN) {\
-                if (neighbor.distance < unitgradientmap[neighbor.y * col_len + neighbor.x]) {\
-                    unitgradientmap[neighbor.y * col_len + neighbor.x] = neighbor.distance;\
+            neighbor.x = current.x + neighbours.dx[sq_neighbor];\
+            neighbor.y = current.y + neighbours.dy[sq_neighbor];\
+            neighbor.distance = unitgradientmap[current_index] + 1;\
+            if (padded[current_padded + neighbours.padded[sq_neighbor]] >= NMATH_COSTMAP_MOVEABLEMIN) {\
+                size_t neighbor_index = current_index + neighbours.offset[sq_neighbor];\
+                if (neighbor.distance < unitgradientmap[neighbor_index]) {\
+                    unitgradientmap[neighbor_index] = neighbor.distance;\
                 }\
                 bool neighbor_inclosed = false;\
                 for (int32_t k = 0; k < DARR_NUM(closed); k++) {\
+                    NMATH_STATS_ADD(closed_scans, 1);\
                     if ((neighbor.x == closed[k].x) && (neighbor.y == closed[k].y)) {\
                         neighbor_inclosed = true;\
                         if (neighbor.distance < closed[k].distance) {\
                             neighbor_inclosed = false;\
                             DARR_DEL(closed, k);\
+                            NMATH_STATS_ADD(reexpansions, 1);\
                         }\
                         break;\
                     }\
                 }\
                 if (!neighbor_inclosed) {\
                     DARR_PUT(open, neighbor);\
+                    NMATH_STATS_ADD(pushes, 1);\
                 }\
             }\
         }\
     }\
+    nmath_free(padded);\
+    DARR_FREE(open);\
+    DARR_FREE(closed);\
+    NMATH_STATS_END;\
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_UNITGRADIENT_NOM);\
     return (unitgradientmap);\
 }
 TEMPLATE_TYPES_SINT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * pathfinding_Map_unitGradient_##type(type * in_costmap, size_t row_len, size_t col_len, struct nmath_point_##type * in_targets, size_t unit_num) {\
-    type * unitgradientmap = calloc(row_len * col_len, sizeof(type));\
+    NMATH_HISTOGRAM_START;\
+    NMATH_STATS_BEGIN;\
+    type * unitgradientmap = nmath_calloc(row_len * col_len, sizeof(type));\
     for (type  col = 0; col < col_len; col++) {\
         for (type  row = 0; row < row_len; row++) {\
             if (in_costmap[row * col_len + col] < NMATH_PUSHPULLMAP_BLOCKED) {\
@@ -1258,6 +4046,9 @@ TEMPLATE_TYPES_SINT
             }\
         }\
     }\
+    type * padded = nmath_pad_##type(in_costmap, row_len, col_len, 0);\
+    struct nmath_neighbours neighbours;\
+    nmath_neighbours_init(&neighbours, col_len, NMATH_SQUARE_NEIGHBOURS);\
     struct nmath_node_##type * open = DARR_INIT(open, struct nmath_node_##type, row_len * col_len);\
     struct nmath_node_##type * closed = DARR_INIT(closed, struct nmath_node_##type, row_len * col_len);\
     struct nmath_node_##type current, neighbor;\
@@ -1267,35 +4058,48 @@ TEMPLATE_TYPES_SINT
         current.y = in_targets[i].y;\
         current.distance = 1;\
         DARR_PUT(open, current);\
+        NMATH_STATS_ADD(pushes, 1);\
     }\
     while (DARR_NUM(open) > 0) {\
         current = DARR_POP(open);\
+        NMATH_STATS_ADD(pops, 1);\
         DARR_PUT(closed, current);\
+        size_t current_index = current.y * col_len + current.x;\
+        size_t current_padded = NMATH_PADDED_INDEX(current.x, current.y, col_len);\
         for (type  sq_neighbor = 0; sq_neighbor < NMATH_SQUARE_NEIGHBOURS; sq_neighbor++) {\
-            neighbor.x = nmath_inbounds_##type(q_cycle4_mzpz(sq_neighbor) + current.x, 0, col_len - 1);\
-            neighbor.y = nmath_inbounds_##type(q_cycle4_zmzp(sq_neighbor) + current.y, 0, row_len - 1);\
-            neighbor.distance = unitgradientmap[current.y * col_len + current.x] + 1;\
-            if (in_costmap[neighbor.y * col_len + neighbor.x] >= NMATH_COSTMAP_MOVEABLEMIN) {\
-                if (neighbor.distance < unitgradientmap[neighbor.y * col_len + neighbor.x]) {\
-                    unitgradientmap[neighbor.y * col_len + neighbor.x] = neighbor.distance;\
+            neighbor.x = current.x + neighbours.dx[sq_neighbor];\
+            neighbor.y = current.y + neighbours.dy[sq_neighbor];\
+            neighbor.distance = unitgradientmap[current_index] + 1;\
+            if (padded[current_padded + neighbours.padded[sq_neighbor]] >= NMATH_COSTMAP_MOVEABLEMIN) {\
+                size_t neighbor_index = current_index + neighbours.offset[sq_neighbor];\
+                if (neighbor.distance < unitgradientmap[neighbor_index]) {\
+                    unitgradientmap[neighbor_index] = neighbor.distance;\
                 }\
                 bool neighbor_inclosed = false;\
                 for (int32_t k = 0; k < DARR_NUM(closed); k++) {\
+                    NMATH_STATS_ADD(closed_scans, 1);\
                     if ((neighbor.x == closed[k].x) && (neighbor.y == closed[k].y)) {\
                         neighbor_inclosed = true;\
                         if (neighbor.distance < closed[k].distance) {\
                             neighbor_inclosed = false;\
                             DARR_DEL(closed, k);\
+                            NMATH_STATS_ADD(reexpansions, 1);\
                         }\
                         break;\
                     }\
                 }\
                 if (!neighbor_inclosed) {\
                     DARR_PUT(open, neighbor);\
+                    NMATH_STATS_ADD(pushes, 1);\
                 }\
             }\
         }\
     }\
+    nmath_free(padded);\
+    DARR_FREE(open);\
+    DARR_FREE(closed);\
+    NMATH_STATS_END;\
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_UNITGRADIENT);\
     return (unitgradientmap);\
 }
 TEMPLATE_TYPES_SINT
@@ -1374,22 +4178,6 @@ TEMPLATE_TYPES_SINT
 TEMPLATE_TYPES_SINT
 #undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) type linalg_distance_manhattan_point_##type(struct nmath_point_##type start, struct nmath_point_##type end) {\
-    /* Does not include endpoints */ \
-    type  distance = abs(start.x - end.x) + abs(start.y - end.y);\
-    return (distance);\
-}
-TEMPLATE_TYPES_SINT
-#undef REGISTER_ENUM
-
-#define REGISTER_ENUM(type) type linalg_distance_manhattan_##type(type x_0, type y_0, type x_1, type y_1) {\
-    /* Does not include endpoints */ \
-    type distance = abs(x_0 -  x_1) + abs(y_0 - y_1);\
-    return (distance);\
-}
-TEMPLATE_TYPES_SINT
-#undef REGISTER_ENUM
-
 #define REGISTER_ENUM(type) type distance_euclidian_##type(struct nmath_point_##type start, struct nmath_point_##type end) {\
     type term_x = (start.x - end.x) > type##_MAX / (start.x - end.x) ? type##_MAX : (start.x - end.x) * (start.x - end.x);\
     type term_y = (start.y - end.y) > type##_MAX / (start.y - end.y) ? type##_MAX : (start.y - end.y) * (start.y - end.y);\
@@ -1410,16 +4198,18 @@ TEMPLATE_TYPES_SINT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type  * pathfinding_Map_Attackfrom_noM_##type(type * attackfrommap, type * in_movemap, size_t row_len, size_t col_len, struct nmath_point_##type in_target, int8_t range[2]) {\
+    NMATH_HISTOGRAM_START;\
+    NMATH_STATS_BEGIN;\
     struct nmath_point_##type perimeter_nmath_point_##type, delta;\
-    for (uint8_t row = 0; row < row_len; row++) {\
-        for (uint8_t col = 0; col < col_len; col++) {\
+    for (size_t row = 0; row < row_len; row++) {\
+        for (size_t col = 0; col < col_len; col++) {\
             attackfrommap[(row * col_len + col)] = NMATH_ATTACKFROM_BLOCKED;\
         }\
     }\
     for (type i_range = range[0]; i_range <= range[1]; i_range++) {\
         for (type  sq_neighbor = 0; sq_neighbor < (i_range * NMATH_SQUARE_NEIGHBOURS); sq_neighbor++) {\
-            delta.x = nmath_inbounds_##type(i_range * q_cycle4_mzpz(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_pmmp(sq_neighbor), -in_target.x, col_len - in_target.x);\
-            delta.y = nmath_inbounds_##type(i_range * q_cycle4_zmzp(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_ppmm(sq_neighbor), -in_target.y, row_len - in_target.y);\
+            delta.x = nmath_inbounds_##type(i_range * q_cycle4_mzpz(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_pmmp(sq_neighbor), -in_target.x, col_len - 1 - in_target.x);\
+            delta.y = nmath_inbounds_##type(i_range * q_cycle4_zmzp(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_ppmm(sq_neighbor), -in_target.y, row_len - 1 - in_target.y);\
             perimeter_nmath_point_##type.x = in_target.x + delta.x;\
             perimeter_nmath_point_##type.y = in_target.y + delta.y;\
             if (in_movemap[perimeter_nmath_point_##type.y * col_len + perimeter_nmath_point_##type.x] >= NMATH_MOVEMAP_MOVEABLEMIN) {\
@@ -1427,22 +4217,28 @@ TEMPLATE_TYPES_SINT
                 }\
             }\
         }\
+    NMATH_STATS_END;\
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_ATTACKFROM_NOM);\
     return (attackfrommap);\
 }
 TEMPLATE_TYPES_SINT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type  * pathfinding_Map_Attackfrom_##type(type  * in_movemap, size_t row_len, size_t col_len, struct nmath_point_##type in_target, int8_t range[2], uint8_t mode_output) {\
+    NMATH_HISTOGRAM_START;\
+    NMATH_STATS_BEGIN;\
     struct nmath_point_##type perimeter_nmath_point_##type, delta;\
     type  * attackfrommap = NULL;\
+    bit_array_t * inlist = NULL;\
     switch (mode_output) {\
         case (NMATH_POINTS_MODE_LIST):\
             attackfrommap = DARR_INIT(attackfrommap, type, row_len * col_len * NMATH_TWO_D);\
+            inlist = nmath_calloc(NMATH_BIT_ARRAY_SIZE_CEIL(row_len * col_len), sizeof(*inlist));\
             break;\
         case (NMATH_POINTS_MODE_MATRIX):\
-            attackfrommap = calloc(row_len * col_len, sizeof(type));\
-            for (uint8_t row = 0; row < row_len; row++) {\
-                for (uint8_t col = 0; col < col_len; col++) {\
+            attackfrommap = nmath_calloc(row_len * col_len, sizeof(type));\
+            for (size_t row = 0; row < row_len; row++) {\
+                for (size_t col = 0; col < col_len; col++) {\
                     attackfrommap[(row * col_len + col)] = NMATH_ATTACKFROM_BLOCKED;\
                 }\
             }\
@@ -1450,16 +4246,16 @@ TEMPLATE_TYPES_SINT
     }\
     for (type i_range = range[0]; i_range <= range[1]; i_range++) {\
         for (type  sq_neighbor = 0; sq_neighbor < (i_range * NMATH_SQUARE_NEIGHBOURS); sq_neighbor++) {\
-            delta.x = nmath_inbounds_##type(i_range * q_cycle4_mzpz(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_pmmp(sq_neighbor), -in_target.x, col_len - in_target.x);\
-            delta.y = nmath_inbounds_##type(i_range * q_cycle4_zmzp(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_ppmm(sq_neighbor), -in_target.y, row_len - in_target.y);\
+            delta.x = nmath_inbounds_##type(i_range * q_cycle4_mzpz(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_pmmp(sq_neighbor), -in_target.x, col_len - 1 - in_target.x);\
+            delta.y = nmath_inbounds_##type(i_range * q_cycle4_zmzp(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_ppmm(sq_neighbor), -in_target.y, row_len - 1 - in_target.y);\
             perimeter_nmath_point_##type.x = in_target.x + delta.x;\
             perimeter_nmath_point_##type.y = in_target.y + delta.y;\
             if (in_movemap[perimeter_nmath_point_##type.y * col_len + perimeter_nmath_point_##type.x] >= NMATH_MOVEMAP_MOVEABLEMIN) {\
                 switch (mode_output) {\
                     case NMATH_POINTS_MODE_LIST:\
-                        if (!linalg_list_isIn_2D_##type(attackfrommap, DARR_NUM(attackfrommap) / NMATH_TWO_D, perimeter_nmath_point_##type.x, perimeter_nmath_point_##type.y)) {\
-                            DARR_PUT(attackfrommap, perimeter_nmath_point_##type.x);\
-                            DARR_PUT(attackfrommap, perimeter_nmath_point_##type.y);\
+                        if (!NMATH_BIT_ARRAY_GET(inlist, perimeter_nmath_point_##type.y * col_len + perimeter_nmath_point_##type.x)) {\
+                            NMATH_BIT_ARRAY_SET(inlist, perimeter_nmath_point_##type.y * col_len + perimeter_nmath_point_##type.x);\
+                            DARR_APPEND_N(attackfrommap, (type *)&perimeter_nmath_point_##type, NMATH_TWO_D);\
                         }\
                         break;\
                     case NMATH_POINTS_MODE_MATRIX:\
@@ -1469,19 +4265,24 @@ TEMPLATE_TYPES_SINT
             }\
         }\
     }\
+    nmath_free(inlist);\
+    NMATH_STATS_END;\
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_ATTACKFROM);\
     return (attackfrommap);\
 }
 TEMPLATE_TYPES_SINT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * pathfinding_Map_Attackto_noM_##type(type * attackmap, type * move_matrix, size_t row_len, size_t col_len, type  move, int8_t range[2], uint8_t mode_movetile) {\
+    NMATH_HISTOGRAM_START;\
+    NMATH_STATS_BEGIN;\
     type *move_list = NULL;\
     type  subrangey_min, subrangey_max;\
     struct nmath_point_##type temp_nmath_point_##type;\
     move_list = linalg_matrix2list_##type(move_matrix, row_len, col_len);\
     size_t list_len = DARR_NUM(move_list) / NMATH_TWO_D;\
-    for (uint8_t row = 0; row < row_len; row++) {\
-        for (uint8_t col = 0; col < col_len; col++) {\
+    for (size_t row = 0; row < row_len; row++) {\
+        for (size_t col = 0; col < col_len; col++) {\
             attackmap[(row * col_len + col)] = NMATH_ATTACKMAP_BLOCKED;\
         }\
     }\
@@ -1514,6 +4315,9 @@ TEMPLATE_TYPES_SINT
             }\
         }\
     }\
+    DARR_FREE(move_list);\
+    NMATH_STATS_END;\
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_ATTACKTO_NOM);\
     return (attackmap);\
 }
 TEMPLATE_TYPES_INT
@@ -1521,7 +4325,10 @@ TEMPLATE_TYPES_INT
 
 
 #define REGISTER_ENUM(type) type * pathfinding_Map_Attackto_##type(type * move_matrix, size_t row_len, size_t col_len, type  move, int8_t range[2], uint8_t mode_output, uint8_t mode_movetile) {\
+    NMATH_HISTOGRAM_START;\
+    NMATH_STATS_BEGIN;\
     type * attackmap = NULL, *move_list = NULL;\
+    bit_array_t * inlist = NULL;\
     type  subrangey_min, subrangey_max;\
     struct nmath_point_##type temp_nmath_point_##type;\
     move_list = linalg_matrix2list_##type(move_matrix, row_len, col_len);\
@@ -1529,11 +4336,12 @@ TEMPLATE_TYPES_INT
     switch (mode_output) {\
         case (NMATH_POINTS_MODE_LIST):\
             attackmap = DARR_INIT(attackmap, type, row_len * col_len * NMATH_TWO_D);\
+            inlist = nmath_calloc(NMATH_BIT_ARRAY_SIZE_CEIL(row_len * col_len), sizeof(*inlist));\
             break;\
         case (NMATH_POINTS_MODE_MATRIX):\
-                attackmap = calloc(row_len * col_len, sizeof(type));\
-            for (uint8_t row = 0; row < row_len; row++) {\
-                for (uint8_t col = 0; col < col_len; col++) {\
+                attackmap = nmath_calloc(row_len * col_len, sizeof(type));\
+            for (size_t row = 0; row < row_len; row++) {\
+                for (size_t col = 0; col < col_len; col++) {\
                     attackmap[(row * col_len + col)] = NMATH_ATTACKMAP_BLOCKED;\
                 }\
             }\
@@ -1564,9 +4372,9 @@ TEMPLATE_TYPES_INT
                     if (add_nmath_point_##type) {\
                         switch (mode_output) {\
                             case NMATH_POINTS_MODE_LIST:\
-                                if (!linalg_list_isIn_2D_##type(attackmap, DARR_NUM(attackmap) / NMATH_TWO_D, temp_nmath_point_##type.x, temp_nmath_point_##type.y)) {\
-                                    DARR_PUT(attackmap, temp_nmath_point_##type.x);\
-                                    DARR_PUT(attackmap, temp_nmath_point_##type.y);\
+                                if (!NMATH_BIT_ARRAY_GET(inlist, temp_nmath_point_##type.y * col_len + temp_nmath_point_##type.x)) {\
+                                    NMATH_BIT_ARRAY_SET(inlist, temp_nmath_point_##type.y * col_len + temp_nmath_point_##type.x);\
+                                    DARR_APPEND_N(attackmap, (type *)&temp_nmath_point_##type, NMATH_TWO_D);\
                                 }\
                                 break;\
                             case NMATH_POINTS_MODE_MATRIX:\
@@ -1578,34 +4386,45 @@ TEMPLATE_TYPES_INT
             }\
         }\
     }\
-    free(move_list);\
+    DARR_FREE(move_list);\
+    nmath_free(inlist);\
+    NMATH_STATS_END;\
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_ATTACKTO);\
     return (attackmap);\
 }
 TEMPLATE_TYPES_INT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type  * pathfinding_Map_Moveto_Hex_##type(type  * cost_matrix, size_t depth_len, size_t col_len, struct nmath_hexpoint_##type start, type move, uint8_t mode_output) {\
+    NMATH_HISTOGRAM_START;\
+    NMATH_STATS_BEGIN;\
     type  * move_matrix = NULL;\
+    bit_array_t * inlist = NULL;\
     switch (mode_output) {\
         case (NMATH_POINTS_MODE_LIST):\
             move_matrix = DARR_INIT(move_matrix, type, depth_len * col_len * NMATH_TWO_D);\
+            inlist = nmath_calloc(NMATH_BIT_ARRAY_SIZE_CEIL(depth_len * col_len), sizeof(*inlist));\
             break;\
         case (NMATH_POINTS_MODE_MATRIX):\
-            move_matrix = calloc(depth_len * col_len, sizeof(type));\
-            for (uint8_t depth = 0; depth < depth_len; depth++) {\
-                for (uint8_t col = 0; col < col_len; col++) {\
+            move_matrix = nmath_calloc(depth_len * col_len, sizeof(type));\
+            for (size_t depth = 0; depth < depth_len; depth++) {\
+                for (size_t col = 0; col < col_len; col++) {\
                     move_matrix[(depth * col_len + col)] = NMATH_MOVEMAP_BLOCKED;\
                 }\
             }\
             break;\
     }\
+    type * padded = nmath_pad_##type(cost_matrix, depth_len, col_len, 0);\
+    struct nmath_neighbours neighbours;\
+    nmath_neighbours_init(&neighbours, col_len, NMATH_HEXAGON_NEIGHBOURS);\
     struct nmath_hexnode_##type * open = DARR_INIT(open, struct nmath_hexnode_##type, depth_len * col_len);\
     struct nmath_hexnode_##type * closed = DARR_INIT(closed, struct nmath_hexnode_##type, depth_len * col_len);\
     struct nmath_hexnode_##type current = {start.x, start.y, start.z, 0}, neighbor = {0};\
     DARR_PUT(open, current);\
-    bool found;\
+    NMATH_STATS_ADD(pushes, 1);\
     while (DARR_NUM(open) > 0) {\
         current = DARR_POP(open);\
+        NMATH_STATS_ADD(pops, 1);\
         DARR_PUT(closed, current);\
         switch (mode_output) {\
             case NMATH_POINTS_MODE_MATRIX:\
@@ -1614,81 +4433,108 @@ TEMPLATE_TYPES_INT
                 }\
                 break;\
             case NMATH_POINTS_MODE_LIST:\
-                found = linalg_list_isIn_2D_##type(move_matrix, DARR_NUM(move_matrix) / NMATH_TWO_D, current.x, current.z);\
-                if (!found) {\
-                    DARR_PUT(move_matrix, current.x);\
-                    DARR_PUT(move_matrix, current.z);\
+                if (!NMATH_BIT_ARRAY_GET(inlist, current.z * col_len + current.x)) {\
+                    NMATH_BIT_ARRAY_SET(inlist, current.z * col_len + current.x);\
+                    type point[NMATH_TWO_D] = {current.x, current.z};\
+                    DARR_APPEND_N(move_matrix, point, NMATH_TWO_D);\
                 }\
                 break;\
         }\
+        size_t current_padded = NMATH_PADDED_INDEX(current.x, current.z, col_len);\
         for (type hex_neighbor = 0; hex_neighbor < NMATH_HEXAGON_NEIGHBOURS; hex_neighbor++) {\
-            neighbor.x = nmath_inbounds_##type(current.x + q_cycle6_mppmzz(hex_neighbor), 0, col_len - 1);\
-            neighbor.z = nmath_inbounds_##type(current.z + q_cycle6_pmzzmp(hex_neighbor), 0, depth_len - 1);\
+            neighbor.x = current.x + neighbours.dx[hex_neighbor];\
+            neighbor.z = current.z + neighbours.dy[hex_neighbor];\
             if (cost_matrix[current.z * col_len + current.x] >= 0) {\
                 neighbor.distance = current.distance + cost_matrix[current.z * col_len + current.x];\
-                if ((neighbor.distance <= move) && (cost_matrix[neighbor.z * col_len + neighbor.x] >= NMATH_COSTMAP_MOVEABLEMIN)) {\
+                if ((neighbor.distance <= move) && (padded[current_padded + neighbours.padded[hex_neighbor]] >= NMATH_COSTMAP_MOVEABLEMIN)) {\
                     bool neighbor_inclosed = false;\
                     for (int32_t k = 0; k < DARR_NUM(closed); k++) {\
+                        NMATH_STATS_ADD(closed_scans, 1);\
                         if ((neighbor.x == closed[k].x) && (neighbor.y == closed[k].y)  && (neighbor.z == closed[k].z)) {\
                             neighbor_inclosed = true;\
                             if (neighbor.distance < closed[k].distance) {\
                                 neighbor_inclosed = false;\
                                 DARR_DEL(closed, k);\
+                                NMATH_STATS_ADD(reexpansions, 1);\
                             }\
                             break;\
                         }\
                     }\
                     if (!neighbor_inclosed) {\
                         DARR_PUT(open, neighbor);\
+                        NMATH_STATS_ADD(pushes, 1);\
                     }\
                 }\
             }\
         }\
     }\
+    nmath_free(inlist);\
+    nmath_free(padded);\
+    DARR_FREE(open);\
+    DARR_FREE(closed);\
+    NMATH_STATS_END;\
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_MOVETO_HEX);\
     return (move_matrix);\
 }
 TEMPLATE_TYPES_SINT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * pathfinding_Map_Moveto_noM_##type(type * move_matrix, type * cost_matrix, size_t row_len, size_t col_len, struct nmath_point_##type start, type move) {\
+    NMATH_HISTOGRAM_START;\
+    NMATH_STATS_BEGIN;\
     for (size_t row = 0; row < row_len; row++) {\
         for (size_t col = 0; col < col_len; col++) {\
             move_matrix[(row * col_len + col)] = NMATH_MOVEMAP_BLOCKED;\
         }\
     }\
+    type * padded = nmath_pad_##type(cost_matrix, row_len, col_len, NMATH_ZERO_##type);\
+    struct nmath_neighbours neighbours;\
+    nmath_neighbours_init(&neighbours, col_len, NMATH_SQUARE_NEIGHBOURS);\
     struct nmath_node_##type * open = DARR_INIT(open, struct nmath_node_##type, row_len * col_len * 2);\
     struct nmath_node_##type * closed = DARR_INIT(closed, struct nmath_node_##type, row_len * col_len * 2);\
     struct nmath_node_##type current = {start.x, start.y, NMATH_ZERO_##type}, neighbor;\
     DARR_PUT(open, current);\
+    NMATH_STATS_ADD(pushes, 1);\
     bool neighbor_inclosed;\
     while (DARR_NUM(open) > 0) {\
         current = DARR_POP(open);\
+        NMATH_STATS_ADD(pops, 1);\
         DARR_PUT(closed, current);\
         if ((move_matrix[current.y * col_len + current.x] == NMATH_MOVEMAP_BLOCKED) || (move_matrix[current.y * col_len + current.x] > (current.distance + NMATH_ONE_##type))) {\
             move_matrix[current.y * col_len + current.x] = current.distance + NMATH_ONE_##type;\
         }\
+        size_t current_padded = NMATH_PADDED_INDEX(current.x, current.y, col_len);\
         for (int8_t i = 0; i < NMATH_SQUARE_NEIGHBOURS; i++) {\
-            neighbor.x = nmath_inbounds_##type(current.x + q_cycle4_mzpz(i), 0, col_len - 1);\
-            neighbor.y = nmath_inbounds_##type(current.y + q_cycle4_zmzp(i), 0, row_len - 1);\
-            neighbor.distance = current.distance + cost_matrix[neighbor.y * col_len + neighbor.x];\
-            if ((neighbor.distance <= move) && (cost_matrix[neighbor.y * col_len + neighbor.x] >= NMATH_ONE_##type)) {\
+            type neighbor_cost = padded[current_padded + neighbours.padded[i]];\
+            neighbor.x = current.x + neighbours.dx[i];\
+            neighbor.y = current.y + neighbours.dy[i];\
+            neighbor.distance = current.distance + neighbor_cost;\
+            if ((neighbor.distance <= move) && (neighbor_cost >= NMATH_ONE_##type)) {\
                 neighbor_inclosed = false;\
                 for (int32_t k = 0; k < DARR_NUM(closed); k++) {\
+                    NMATH_STATS_ADD(closed_scans, 1);\
                     if ((neighbor.x == closed[k].x) && (neighbor.y == closed[k].y)) {\
                         neighbor_inclosed = true;\
                         if (neighbor.distance < closed[k].distance) {\
                             neighbor_inclosed = false;\
                             DARR_DEL(closed, k);\
+                            NMATH_STATS_ADD(reexpansions, 1);\
                         }\
                         break;\
                     }\
                 }\
                 if (!neighbor_inclosed) {\
                     DARR_PUT(open, neighbor);\
+                    NMATH_STATS_ADD(pushes, 1);\
                 }\
             }\
         }\
     }\
+    nmath_free(padded);\
+    DARR_FREE(open);\
+    DARR_FREE(closed);\
+    NMATH_STATS_END;\
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_MOVETO_NOM);\
     return (move_matrix);\
 }
 TEMPLATE_TYPES_SINT
@@ -1696,13 +4542,17 @@ TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * pathfinding_Map_Moveto_##type(type * cost_matrix, size_t row_len, size_t col_len, struct nmath_point_##type start, type move, uint8_t mode_output) {\
+    NMATH_HISTOGRAM_START;\
+    NMATH_STATS_BEGIN;\
     type * move_matrix = NULL;\
+    bit_array_t * inlist = NULL;\
     switch (mode_output) {\
         case (NMATH_POINTS_MODE_LIST):\
             move_matrix = DARR_INIT(move_matrix, type, row_len * col_len * NMATH_TWO_D);\
+            inlist = nmath_calloc(NMATH_BIT_ARRAY_SIZE_CEIL(row_len * col_len), sizeof(*inlist));\
             break;\
         case (NMATH_POINTS_MODE_MATRIX):\
-            move_matrix = calloc(row_len * col_len, sizeof(*move_matrix));\
+            move_matrix = nmath_calloc(row_len * col_len, sizeof(*move_matrix));\
             for (size_t row = 0; row < row_len; row++) {\
                 for (size_t col = 0; col < col_len; col++) {\
                     move_matrix[(row * col_len + col)] = NMATH_MOVEMAP_BLOCKED;\
@@ -1710,13 +4560,18 @@ TEMPLATE_TYPES_FLOAT
             }\
             break;\
     }\
+    type * padded = nmath_pad_##type(cost_matrix, row_len, col_len, NMATH_ZERO_##type);\
+    struct nmath_neighbours neighbours;\
+    nmath_neighbours_init(&neighbours, col_len, NMATH_SQUARE_NEIGHBOURS);\
     struct nmath_node_##type * open = DARR_INIT(open, struct nmath_node_##type, row_len * col_len * 2);\
     struct nmath_node_##type * closed = DARR_INIT(closed, struct nmath_node_##type, row_len * col_len * 2);\
     struct nmath_node_##type current = {start.x, start.y, NMATH_ZERO_##type}, neighbor;\
     DARR_PUT(open, current);\
-    bool found, neighbor_inclosed;\
+    NMATH_STATS_ADD(pushes, 1);\
+    bool neighbor_inclosed;\
     while (DARR_NUM(open) > 0) {\
         current = DARR_POP(open);\
+        NMATH_STATS_ADD(pops, 1);\
         DARR_PUT(closed, current);\
         switch (mode_output) {\
             case NMATH_POINTS_MODE_MATRIX:\
@@ -1725,35 +4580,46 @@ TEMPLATE_TYPES_FLOAT
                 }\
                 break;\
             case NMATH_POINTS_MODE_LIST:\
-                found = linalg_list_isIn_2D_##type(move_matrix, DARR_NUM(move_matrix) / NMATH_TWO_D, current.x, current.y);\
-                if (!found) {\
-                    DARR_PUT(move_matrix, current.x);\
-                    DARR_PUT(move_matrix, current.y);\
+                if (!NMATH_BIT_ARRAY_GET(inlist, current.y * col_len + current.x)) {\
+                    NMATH_BIT_ARRAY_SET(inlist, current.y * col_len + current.x);\
+                    type point[NMATH_TWO_D] = {(type)current.x, (type)current.y};\
+                    DARR_APPEND_N(move_matrix, point, NMATH_TWO_D);\
                 }\
                 break;\
         }\
+        size_t current_padded = NMATH_PADDED_INDEX(current.x, current.y, col_len);\
         for (int8_t i = 0; i < NMATH_SQUARE_NEIGHBOURS; i++) {\
-            neighbor.x = nmath_inbounds_##type(current.x + q_cycle4_mzpz(i), 0, col_len - 1);\
-            neighbor.y = nmath_inbounds_##type(current.y + q_cycle4_zmzp(i), 0, row_len - 1);\
-            neighbor.distance = current.distance + cost_matrix[neighbor.y * col_len + neighbor.x];\
-            if ((neighbor.distance <= (type)move) && (cost_matrix[neighbor.y * col_len + neighbor.x] >= NMATH_ONE_##type)) {\
+            type neighbor_cost = padded[current_padded + neighbours.padded[i]];\
+            neighbor.x = current.x + neighbours.dx[i];\
+            neighbor.y = current.y + neighbours.dy[i];\
+            neighbor.distance = current.distance + neighbor_cost;\
+            if ((neighbor.distance <= (type)move) && (neighbor_cost >= NMATH_ONE_##type)) {\
                 neighbor_inclosed = false;\
                 for (int32_t k = 0; k < DARR_NUM(closed); k++) {\
+                    NMATH_STATS_ADD(closed_scans, 1);\
                     if ((neighbor.x == closed[k].x) && (neighbor.y == closed[k].y)) {\
                         neighbor_inclosed = true;\
                         if (neighbor.distance < closed[k].distance) {\
                             neighbor_inclosed = false;\
                             DARR_DEL(closed, k);\
+                            NMATH_STATS_ADD(reexpansions, 1);\
                         }\
                         break;\
                     }\
                 }\
                 if (!neighbor_inclosed) {\
                     DARR_PUT(open, neighbor);\
+                    NMATH_STATS_ADD(pushes, 1);\
                 }\
             }\
         }\
     }\
+    nmath_free(inlist);\
+    nmath_free(padded);\
+    DARR_FREE(open);\
+    DARR_FREE(closed);\
+    NMATH_STATS_END;\
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_MOVETO);\
     return (move_matrix);\
 }
 TEMPLATE_TYPES_SINT
@@ -1761,22 +4627,25 @@ TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * pathfinding_Map_Visible_noM_##type(type * sightmap, type * block_matrix, size_t row_len, size_t col_len, struct nmath_point_##type start, type sight) {\
+    NMATH_HISTOGRAM_START;\
+    NMATH_STATS_BEGIN;\
      struct nmath_point_##type perimeter_nmath_point_##type = {0, 0}, delta = {0, 0}, interpolated = {0, 0};\
     bool visible;\
-    for (uint8_t row = 0; row < row_len; row++) {\
-        for (uint8_t col = 0; col < col_len; col++) {\
+    for (size_t row = 0; row < row_len; row++) {\
+        for (size_t col = 0; col < col_len; col++) {\
             sightmap[(row * col_len + col)] = NMATH_SIGHTMAP_BLOCKED;\
         }\
     }\
     sightmap[start.y * col_len + start.x] = NMATH_SIGHTMAP_OBSERVER;\
     for (type  distance = 1; distance <= sight; distance++) {\
         for (type  sq_neighbor = 0; sq_neighbor < (distance * NMATH_SQUARE_NEIGHBOURS); sq_neighbor++) {\
-            delta.x = nmath_inbounds_##type(distance * q_cycle4_mzpz(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_pmmp(sq_neighbor), -start.x, col_len - start.x);\
-            delta.y = nmath_inbounds_##type(distance * q_cycle4_zmzp(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_ppmm(sq_neighbor), -start.y, row_len - start.y);\
+            delta.x = nmath_inbounds_##type(distance * q_cycle4_mzpz(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_pmmp(sq_neighbor), -start.x, col_len - 1 - start.x);\
+            delta.y = nmath_inbounds_##type(distance * q_cycle4_zmzp(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_ppmm(sq_neighbor), -start.y, row_len - 1 - start.y);\
             perimeter_nmath_point_##type.x = start.x + delta.x;\
             perimeter_nmath_point_##type.y = start.y + delta.y;\
             visible = true;\
             for (int32_t interp_dist = 1; interp_dist < distance; interp_dist++) {\
+                NMATH_STATS_ADD(sight_checks, 1);\
                 interpolated.x = start.x + (delta.x == 0 ? 0 : (int32_t)lround(interp_dist * delta.x * (1.0f / distance)));\
                 interpolated.y = start.y + (delta.y == 0 ? 0 : (int32_t)lround(interp_dist * delta.y * (1.0f / distance)));\
                 if ((interpolated.x != start.x) || (interpolated.y != start.y)) {\
@@ -1798,12 +4667,16 @@ TEMPLATE_TYPES_FLOAT
             }\
         }\
     }\
+    NMATH_STATS_END;\
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_VISIBLE_NOM);\
     return (sightmap);\
 }
 TEMPLATE_TYPES_SINT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * pathfinding_Map_Visible_##type(type  * block_matrix, size_t row_len, size_t col_len, struct nmath_point_##type start, type  sight, uint8_t mode_output) {\
+    NMATH_HISTOGRAM_START;\
+    NMATH_STATS_BEGIN;\
     type  * sightmap = NULL;\
     struct nmath_point_##type perimeter_nmath_point_##type = {0, 0}, delta = {0, 0}, interpolated = {0, 0};\
     bool visible;\
@@ -1812,9 +4685,9 @@ TEMPLATE_TYPES_SINT
             sightmap = DARR_INIT(sightmap, type, row_len * col_len * NMATH_TWO_D);\
             break;\
         case (NMATH_POINTS_MODE_MATRIX):\
-            sightmap = calloc(row_len * col_len, sizeof(type));\
-            for (uint8_t row = 0; row < row_len; row++) {\
-                for (uint8_t col = 0; col < col_len; col++) {\
+            sightmap = nmath_calloc(row_len * col_len, sizeof(type));\
+            for (size_t row = 0; row < row_len; row++) {\
+                for (size_t col = 0; col < col_len; col++) {\
                     sightmap[(row * col_len + col)] = NMATH_SIGHTMAP_BLOCKED;\
                 }\
             }\
@@ -1823,12 +4696,13 @@ TEMPLATE_TYPES_SINT
     sightmap[start.y * col_len + start.x] = NMATH_SIGHTMAP_OBSERVER;\
     for (type  distance = 1; distance <= sight; distance++) {\
         for (type  sq_neighbor = 0; sq_neighbor < (distance * NMATH_SQUARE_NEIGHBOURS); sq_neighbor++) {\
-            delta.x = nmath_inbounds_##type(distance * q_cycle4_mzpz(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_pmmp(sq_neighbor), -start.x, col_len - start.x);\
-            delta.y = nmath_inbounds_##type(distance * q_cycle4_zmzp(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_ppmm(sq_neighbor), -start.y, row_len - start.y);\
+            delta.x = nmath_inbounds_##type(distance * q_cycle4_mzpz(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_pmmp(sq_neighbor), -start.x, col_len - 1 - start.x);\
+            delta.y = nmath_inbounds_##type(distance * q_cycle4_zmzp(sq_neighbor) + (sq_neighbor / NMATH_SQUARE_NEIGHBOURS) * q_cycle4_ppmm(sq_neighbor), -start.y, row_len - 1 - start.y);\
             perimeter_nmath_point_##type.x = start.x + delta.x;\
             perimeter_nmath_point_##type.y = start.y + delta.y;\
             visible = true;\
             for (int32_t interp_dist = 1; interp_dist < distance; interp_dist++) {\
+                NMATH_STATS_ADD(sight_checks, 1);\
                 interpolated.x = start.x + (delta.x == 0 ? 0 : (int32_t)lround(interp_dist * delta.x * (1.0f / distance)));\
                 interpolated.y = start.y + (delta.y == 0 ? 0 : (int32_t)lround(interp_dist * delta.y * (1.0f / distance)));\
                 if ((interpolated.x != start.x) || (interpolated.y != start.y)) {\
@@ -1854,12 +4728,16 @@ TEMPLATE_TYPES_SINT
             }\
         }\
     }\
+    NMATH_STATS_END;\
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_VISIBLE);\
     return (sightmap);\
 }
 TEMPLATE_TYPES_SINT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) type * pathfinding_Map_Visible_Hex_##type(type  * block_matrix, size_t depth_len, size_t col_len, struct nmath_hexpoint_##type start, type sight, uint8_t mode_output) {\
+    NMATH_HISTOGRAM_START;\
+    NMATH_STATS_BEGIN;\
     type  * sightmap = NULL;\
     struct nmath_hexpoint_##type perimeter_nmath_point_##type = {0, 0, 0}, delta = {0, 0, 0}, interpolated = {0, 0, 0};\
     bool visible;\
@@ -1868,9 +4746,9 @@ TEMPLATE_TYPES_SINT
             sightmap = DARR_INIT(sightmap, type, depth_len * col_len * NMATH_TWO_D);\
             break;\
         case (NMATH_POINTS_MODE_MATRIX):\
-            sightmap = calloc(depth_len * col_len, sizeof(type));\
-            for (uint8_t depth = 0; depth < depth_len; depth++) {\
-                for (uint8_t col = 0; col < col_len; col++) {\
+            sightmap = nmath_calloc(depth_len * col_len, sizeof(type));\
+            for (size_t depth = 0; depth < depth_len; depth++) {\
+                for (size_t col = 0; col < col_len; col++) {\
                     sightmap[(depth * col_len + col)] = NMATH_SIGHTMAP_BLOCKED;\
                 }\
             }\
@@ -1879,12 +4757,13 @@ TEMPLATE_TYPES_SINT
     sightmap[start.z * col_len + start.x] = NMATH_SIGHTMAP_OBSERVER;\
     for (type  distance = 1; distance <= sight; distance++) {\
         for (type  perimeter_tile = 0; perimeter_tile < (distance * NMATH_HEXAGON_NEIGHBOURS); perimeter_tile++) {/*iterates perimeter tiles at \distance */\
-            delta.x = nmath_inbounds_##type(distance * q_cycle6_mppmzz(perimeter_tile) + perimeter_tile / NMATH_HEXAGON_NEIGHBOURS * q_cycle6_pmzzmp(perimeter_tile), -start.x, col_len - start.x);\
-            delta.z = nmath_inbounds_##type(distance * q_cycle6_pmzzmp(perimeter_tile) + perimeter_tile / NMATH_HEXAGON_NEIGHBOURS * q_cycle6_zzmppm(perimeter_tile), -start.z, depth_len - start.z);\
+            delta.x = nmath_inbounds_##type(distance * q_cycle6_mppmzz(perimeter_tile) + perimeter_tile / NMATH_HEXAGON_NEIGHBOURS * q_cycle6_pmzzmp(perimeter_tile), -start.x, col_len - 1 - start.x);\
+            delta.z = nmath_inbounds_##type(distance * q_cycle6_pmzzmp(perimeter_tile) + perimeter_tile / NMATH_HEXAGON_NEIGHBOURS * q_cycle6_zzmppm(perimeter_tile), -start.z, depth_len - 1 - start.z);\
             perimeter_nmath_point_##type.x = start.x + delta.x;\
             perimeter_nmath_point_##type.z = start.z + delta.z;\
             visible = true;\
             for (int32_t interp_dist = 1; interp_dist < distance; interp_dist++) {\
+                NMATH_STATS_ADD(sight_checks, 1);\
                 interpolated.x = start.x + (delta.x == 0 ? 0 : (int32_t)lround(interp_dist * delta.x * (1.0f / distance)));\
                 interpolated.z = start.z + (delta.z == 0 ? 0 : (int32_t)lround(interp_dist * delta.z * (1.0f / distance)));\
                 if ((interpolated.x != start.x) || (interpolated.z != start.z)) {\
@@ -1906,6 +4785,8 @@ TEMPLATE_TYPES_SINT
             }\
         }\
     }\
+    NMATH_STATS_END;\
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_VISIBLE_HEX);\
     return (sightmap);\
 }
 TEMPLATE_TYPES_SINT
@@ -1941,8 +4822,8 @@ int32_t * came_from2path_list(int32_t * path_list, int32_t * came_from, size_t r
     struct nmath_point_int32_t current = {x_end, y_end};
     DARR_NUM(path_list) = 0;
     for (size_t i = 0; i < NMATH_ITERATIONS_LIMIT; i++) {
-        DARR_PUT(path_list, current.x);
-        DARR_PUT(path_list, current.y);
+        int32_t point[NMATH_TWO_D] = {current.x, current.y};
+        DARR_APPEND_N(path_list, point, NMATH_TWO_D);
         if ((current.x == x_start) && (current.y == y_start)) {
             break;
         }
@@ -1967,123 +4848,159 @@ int32_t * came_from2path_list(int32_t * path_list, int32_t * came_from, size_t r
 int32_t * pathfinding_Astar_List_int32_t(int32_t * path_list, int32_t * costmap, size_t row_len, size_t col_len, struct nmath_point_int32_t start, struct nmath_point_int32_t end) {
     /* Assumes square grid, path_list is a DARR */
     /* [1]: http://www.redblobgames.com/pathfinding/a-star/introduction.html */
-
-    int32_t * cost_tomove = calloc(row_len * col_len, sizeof(*cost_tomove));
-    int32_t * came_from = calloc(row_len * col_len, sizeof(*came_from));
+    NMATH_HISTOGRAM_START;
+    NMATH_STATS_BEGIN;
+    int32_t * cost_tomove = nmath_calloc(row_len * col_len, sizeof(*cost_tomove));
+    int32_t * came_from = nmath_calloc(row_len * col_len, sizeof(*came_from));
     assert((start.x != end.x) || (start.y != end.y));
     assert(costmap[start.y * col_len + start.x] >= NMATH_MOVEMAP_MOVEABLEMIN);
     assert(costmap[end.y * col_len + end.x] >= NMATH_MOVEMAP_MOVEABLEMIN);
+    int32_t * padded = nmath_pad_int32_t(costmap, row_len, col_len, 0);
+    struct nmath_neighbours neighbours;
+    nmath_neighbours_init(&neighbours, col_len, NMATH_SQUARE_NEIGHBOURS);
     // frontier points queue, by priority
     // lowest (movcost + distance) is top of queue.
     struct nmath_nodeq_int32_t * frontier_queue = DARR_INIT(frontier_queue, struct nmath_nodeq_int32_t, row_len * col_len);
 
-    int32_t * out = DARR_INIT(out, int32_t, row_len * col_len * NMATH_TWO_D);
     struct nmath_nodeq_int32_t current = {.x = start.x, .y = start.y, .cost = 0};
     struct nmath_nodeq_int32_t neighbor;
     DARR_PUT(frontier_queue, current);
+    NMATH_STATS_ADD(pushes, 1);
     while (DARR_NUM(frontier_queue) > 0) {
         current = DARR_POP(frontier_queue);
+        NMATH_STATS_ADD(pops, 1);
 
         if ((current.x == end.x) && (current.y == end.y)) {
             break;
         }
         /* visit all square neighbors */
+        size_t current_index = current.y * col_len + current.x;
+        size_t current_padded = NMATH_PADDED_INDEX(current.x, current.y, col_len);
         for (int32_t sq_neighbor = 0; sq_neighbor < NMATH_SQUARE_NEIGHBOURS; sq_neighbor++) {
-            neighbor.x = nmath_inbounds_int32_t(q_cycle4_mzpz(sq_neighbor) + current.x, 0, col_len - 1);
-            neighbor.y = nmath_inbounds_int32_t(q_cycle4_zmzp(sq_neighbor) + current.y, 0, row_len - 1);
-            neighbor.cost = current.cost + costmap[neighbor.y * col_len + neighbor.x];
-
-            /* add neighbor to frontier if: not visited, lower cost, not blocked */
-            if (((cost_tomove[neighbor.y * col_len + neighbor.x] == 0) || neighbor.cost <  cost_tomove[neighbor.y * col_len + neighbor.x]) && (costmap[neighbor.y * col_len + neighbor.x] >= NMATH_MOVEMAP_MOVEABLEMIN)) {
+            int32_t neighbor_cost = padded[current_padded + neighbours.padded[sq_neighbor]];
+            size_t neighbor_index = current_index + neighbours.offset[sq_neighbor];
+            neighbor.x = current.x + neighbours.dx[sq_neighbor];
+            neighbor.y = current.y + neighbours.dy[sq_neighbor];
+            neighbor.cost = current.cost + neighbor_cost;
+
+            /* add neighbor to frontier if: not blocked, not visited, lower cost */
+            if ((neighbor_cost >= NMATH_MOVEMAP_MOVEABLEMIN) && ((cost_tomove[neighbor_index] == 0) || neighbor.cost <  cost_tomove[neighbor_index])) {
                 // distance is heuristic for closeness to goal
                 size_t distance = linalg_distance_manhattan_int32_t(end.x, end.y, neighbor.x, neighbor.y);
-                cost_tomove[neighbor.y * col_len + neighbor.x] = neighbor.cost;
+                NMATH_STATS_ADD(reexpansions, (cost_tomove[neighbor_index] != 0));
+                cost_tomove[neighbor_index] = neighbor.cost;
                 // Djikstra algo only has cost in this step
                 neighbor.priority = neighbor.cost + distance; // Core of Astar
 
                 /* Find index to insert neighbor into queue, low is top */
                 if (DARR_NUM(frontier_queue) == 0) {
                     DARR_PUT(frontier_queue, neighbor);
+                    NMATH_STATS_ADD(pushes, 1);
                 } else {
                     size_t index = DARR_NUM(frontier_queue);
-                    while ((neighbor.priority > frontier_queue[index - 1].priority) && (index > 0)) {
+                    while ((index > 0) && (neighbor.priority > frontier_queue[index - 1].priority)) {
+                        NMATH_STATS_ADD(queue_scans, 1);
                         index--;
                     }
                     DARR_INSERT(frontier_queue, neighbor, index);
+                    NMATH_STATS_ADD(pushes, 1);
                 }
-                came_from[neighbor.y * col_len + neighbor.x] =  nmath_Direction_Compute_int32_t(current.x, current.y, neighbor.x, neighbor.y);
+                came_from[neighbor_index] =  nmath_Direction_Compute_int32_t(current.x, current.y, neighbor.x, neighbor.y);
             }
         }
     }
     path_list = came_from2path_list(path_list, came_from, row_len, col_len, start.x, start.y, end.x, end.y);
-    free(came_from);
-    free(cost_tomove);
+    DARR_FREE(frontier_queue);
+    nmath_free(padded);
+    nmath_free(came_from);
+    nmath_free(cost_tomove);
+    NMATH_STATS_END;
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_ASTAR_LIST);
     return (path_list);
 }
 
 int32_t * pathfinding_Astar_Map_int32_t(int32_t * path_map, int32_t * costmap, size_t row_len, size_t col_len, struct nmath_point_int32_t start, struct nmath_point_int32_t end) {
     /* Assumes square grid */
     /* [1]: http://www.redblobgames.com/pathfinding/a-star/introduction.html */
+    NMATH_HISTOGRAM_START;
+    NMATH_STATS_BEGIN;
     int32_t * cost_tomove = path_map;
-    int32_t * came_from = calloc(row_len * col_len, sizeof(*came_from));
+    int32_t * came_from = nmath_calloc(row_len * col_len, sizeof(*came_from));
     assert((start.x != end.x) || (start.y != end.y));
     assert(costmap[start.y * col_len + start.x] >= NMATH_MOVEMAP_MOVEABLEMIN);
     assert(costmap[end.y * col_len + end.x] >= NMATH_MOVEMAP_MOVEABLEMIN);
 
+    int32_t * padded = nmath_pad_int32_t(costmap, row_len, col_len, 0);
+    struct nmath_neighbours neighbours;
+    nmath_neighbours_init(&neighbours, col_len, NMATH_SQUARE_NEIGHBOURS);
     // frontier points queue, by priority
     // lowest (movcost + distance) is top of queue.
     struct nmath_nodeq_int32_t * frontier_queue = DARR_INIT(frontier_queue, struct nmath_nodeq_int32_t, row_len * col_len);
     struct nmath_nodeq_int32_t current = {.x = start.x, .y = start.y, .cost = 0};
     struct nmath_nodeq_int32_t neighbor;
     DARR_PUT(frontier_queue, current);
+    NMATH_STATS_ADD(pushes, 1);
     while (DARR_NUM(frontier_queue) > 0) {
         current = DARR_POP(frontier_queue);
+        NMATH_STATS_ADD(pops, 1);
         if ((current.x == end.x) && (current.y == end.y)) {
             break;
         }
         /* visit all square neighbors */
+        size_t current_index = current.y * col_len + current.x;
+        size_t current_padded = NMATH_PADDED_INDEX(current.x, current.y, col_len);
         for (int32_t sq_neighbor = 0; sq_neighbor < NMATH_SQUARE_NEIGHBOURS; sq_neighbor++) {
-            neighbor.x = nmath_inbounds_int32_t(q_cycle4_mzpz(sq_neighbor) + current.x, 0, col_len - 1);
-            neighbor.y = nmath_inbounds_int32_t(q_cycle4_zmzp(sq_neighbor) + current.y, 0, row_len - 1);
-            neighbor.cost = current.cost + costmap[neighbor.y * col_len + neighbor.x];
-
-            /* add neighbor to frontier if: not visited, lower cost, not blocked */
-            if (((cost_tomove[neighbor.y * col_len + neighbor.x] == 0) || neighbor.cost <  cost_tomove[neighbor.y * col_len + neighbor.x]) && (costmap[neighbor.y * col_len + neighbor.x] >= NMATH_MOVEMAP_MOVEABLEMIN)) {
+            int32_t neighbor_cost = padded[current_padded + neighbours.padded[sq_neighbor]];
+            size_t neighbor_index = current_index + neighbours.offset[sq_neighbor];
+            neighbor.x = current.x + neighbours.dx[sq_neighbor];
+            neighbor.y = current.y + neighbours.dy[sq_neighbor];
+            neighbor.cost = current.cost + neighbor_cost;
+
+            /* add neighbor to frontier if: not blocked, not visited, lower cost */
+            if ((neighbor_cost >= NMATH_MOVEMAP_MOVEABLEMIN) && ((cost_tomove[neighbor_index] == 0) || neighbor.cost <  cost_tomove[neighbor_index])) {
                 // distance is heuristic for closeness to goal
                 size_t distance = linalg_distance_manhattan_int32_t(end.x, end.y, neighbor.x, neighbor.y);
-                cost_tomove[neighbor.y * col_len + neighbor.x] = neighbor.cost;
+                NMATH_STATS_ADD(reexpansions, (cost_tomove[neighbor_index] != 0));
+                cost_tomove[neighbor_index] = neighbor.cost;
                 // Djikstra algo only has cost in this step
                 neighbor.priority = neighbor.cost + distance; // Core of Astar
 
                 /* Find index to insert neighbor into queue, low is top */
-                size_t index = 0;
                 if (DARR_NUM(frontier_queue) == 0) {
                     DARR_PUT(frontier_queue, neighbor);
+                    NMATH_STATS_ADD(pushes, 1);
                 } else {
-                    index = DARR_NUM(frontier_queue) - 1;
-                    while ((neighbor.priority > frontier_queue[index].priority) && (index > 0)) {
+                    size_t index = DARR_NUM(frontier_queue);
+                    while ((index > 0) && (neighbor.priority > frontier_queue[index - 1].priority)) {
+                        NMATH_STATS_ADD(queue_scans, 1);
                         index--;
                     }
-                    DARR_INSERT(frontier_queue, neighbor, index + 1);
+                    DARR_INSERT(frontier_queue, neighbor, index);
+                    NMATH_STATS_ADD(pushes, 1);
                 }
-                came_from[neighbor.y * col_len + neighbor.x] =  nmath_Direction_Compute_int32_t(current.x, current.y, neighbor.x, neighbor.y);
+                came_from[neighbor_index] =  nmath_Direction_Compute_int32_t(current.x, current.y, neighbor.x, neighbor.y);
             }
         }
     }
     path_map = memset(path_map, 0, row_len * col_len * sizeof(*path_map));
     path_map = came_from2path_map(path_map, came_from, row_len, col_len, start.x, start.y, end.x, end.y);
-    free(came_from);
+    DARR_FREE(frontier_queue);
+    nmath_free(padded);
+    nmath_free(came_from);
+    NMATH_STATS_END;
+    NMATH_HISTOGRAM_END(NMATH_HISTOGRAM_ASTAR_MAP);
     return (path_map);
 }
 
 #define REGISTER_ENUM(type) type * pathfinding_Path_step2position_##type(type  * step_list, size_t list_len, struct nmath_point_##type start) {\
-    type  * path_position = DARR_INIT(path_position, type, ((list_len + 1) * 2));\
-    DARR_PUT(path_position, start.x);\
-    DARR_PUT(path_position, start.y);\
+    type  * path_position = DARR_INIT(path_position, type, ((list_len + 1) * NMATH_TWO_D));\
+    path_position[0] = start.x;\
+    path_position[1] = start.y;\
     for (type  i = 0; i < list_len; i++) {\
-        DARR_PUT(path_position, (path_position[i * NMATH_TWO_D + 0] + step_list[i * NMATH_TWO_D + 0]));\
-        DARR_PUT(path_position, (path_position[i * NMATH_TWO_D + 1] + step_list[i * NMATH_TWO_D + 1]));\
+        path_position[(i + 1) * NMATH_TWO_D + 0] = path_position[i * NMATH_TWO_D + 0] + step_list[i * NMATH_TWO_D + 0];\
+        path_position[(i + 1) * NMATH_TWO_D + 1] = path_position[i * NMATH_TWO_D + 1] + step_list[i * NMATH_TWO_D + 1];\
     }\
+    DARR_NUM(path_position) = (list_len + 1) * NMATH_TWO_D;\
     return (path_position);\
 }
 TEMPLATE_TYPES_SINT
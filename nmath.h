@@ -9,6 +9,7 @@
 #include <assert.h>
 #include <limits.h>
 #include <math.h>
+#include <float.h>
 
 /******************************* NOURS_MATH v0.3 *****************************/
 /* Math library I made during the development of my game, Codename:Firesaga
@@ -19,6 +20,189 @@
 * + Utility module DARR for dynamic arrays
 */
 
+/********************************* MEMORY ************************************/
+// NMATH_ALIGNMENT: alignment in bytes of DARR data and of every matrix
+// allocated by linalg and pathfinding functions, for aligned SIMD loads.
+//   -> 0: plain malloc/calloc/realloc, no alignment guarantee.
+//   -> else: power of 2, multiple of sizeof(void *). 64 is a cache line.
+// Must be the same for nmath.c and ALL files including nmath.h: the DARR
+// header size depends on it. Aligned memory is freed with nmath_free/DARR_FREE.
+#ifndef NMATH_ALIGNMENT
+#define NMATH_ALIGNMENT 0
+#endif
+
+#if (NMATH_ALIGNMENT & (NMATH_ALIGNMENT - 1)) != 0
+#error "NMATH_ALIGNMENT must be a power of 2"
+#endif
+
+extern void * nmath_malloc(size_t bytesize);
+extern void * nmath_calloc(size_t num, size_t bytesize);
+extern void * nmath_realloc(void * ptr, size_t bytesize);
+extern void nmath_free(void * ptr);
+
+// nmath_set_allocator: every nmath function, DARR and DTAB allocate through
+// these. NULL members: stdlib function. NULL calloc_fn: malloc_fn + memset.
+// With a custom allocator, free nmath memory with nmath_free/DARR_FREE only.
+// With NMATH_ALIGNMENT > 0, custom allocators must return aligned memory.
+struct nmath_allocator {
+    void * (*malloc_fn)(size_t bytesize);
+    void * (*calloc_fn)(size_t num, size_t bytesize);
+    void * (*realloc_fn)(void * ptr, size_t bytesize);
+    void (*free_fn)(void * ptr);
+};
+extern void nmath_set_allocator(struct nmath_allocator allocator);
+extern struct nmath_allocator nmath_get_allocator(void);
+
+// Compile with -DNMATH_ALLOC_DEBUG, for nmath.c and ALL files including
+// nmath.h, to count allocation calls and bytes per calling function, and
+// report leaks to stderr at exit. Memory freed with plain free is a leak.
+struct nmath_alloc_count {
+    size_t calls;      // nmath_malloc, nmath_calloc, nmath_realloc calls
+    size_t bytes;      // total bytes requested
+    size_t live_num;   // allocations not freed yet
+    size_t live_bytes; // bytes not freed yet
+};
+// func: calling function name, NULL for all. Always 0 without NMATH_ALLOC_DEBUG.
+extern struct nmath_alloc_count nmath_alloc_count(const char * func);
+extern void nmath_alloc_report(FILE * out);
+
+#ifdef NMATH_ALLOC_DEBUG
+extern void * nmath_malloc_debug(size_t bytesize, const char * func);
+extern void * nmath_calloc_debug(size_t num, size_t bytesize, const char * func);
+extern void * nmath_realloc_debug(void * ptr, size_t bytesize, const char * func);
+extern void nmath_free_debug(void * ptr);
+#define nmath_malloc(bytesize) nmath_malloc_debug((bytesize), __func__)
+#define nmath_calloc(num, bytesize) nmath_calloc_debug((num), (bytesize), __func__)
+#define nmath_realloc(ptr, bytesize) nmath_realloc_debug((ptr), (bytesize), __func__)
+#define nmath_free(ptr) nmath_free_debug(ptr)
+#endif
+
+/********************************* THREADS ***********************************/
+// Compile nmath.c with -fopenmp for multithreaded matmul, fused pipelines,
+// element-wise and reduction kernels. Arrays with fewer than
+// NMATH_PARALLEL_THRESHOLD elements stay single-threaded: game-sized maps
+// are faster without thread startup. Split in NMATH_PARALLEL_CHUNK_LEN chunks.
+// Without OpenMP: single-threaded, nmath_get_threads returns 1.
+#ifndef NMATH_PARALLEL_THRESHOLD
+#define NMATH_PARALLEL_THRESHOLD (1 << 16)
+#endif
+// Multiple of 64: chunks of bit_array_t masks start on word boundaries.
+#ifndef NMATH_PARALLEL_CHUNK_LEN
+#define NMATH_PARALLEL_CHUNK_LEN (1 << 14)
+#endif
+
+#if (NMATH_PARALLEL_CHUNK_LEN % 64) != 0
+#error "NMATH_PARALLEL_CHUNK_LEN must be a multiple of 64"
+#endif
+
+// threads: 0 for the OpenMP default, usually one per core.
+extern void nmath_set_threads(int threads);
+extern int nmath_get_threads(void);
+
+/****************************** SIMD DISPATCH ********************************/
+// Element-wise, comparison, bitmask, reduction, axpy and GEMM micro-kernels of
+// linalg functions are compiled for every SIMD level, one picked at runtime
+// from CPU features, detected once. x86-64 gcc/clang: SSE2, AVX2 + FMA and
+// AVX-512 (F, VL, BW, DQ) + FMA.
+// Other CPUs: compiler vector extensions (NEON on ARM), named "vector".
+// tcc, or nmath.c compiled with -DNMATH_NO_SIMD: scalar only.
+// Environment variable NMATH_SIMD=scalar (or sse2, avx2) caps the level.
+// Not dispatched: NMATH_BIT_ARRAY_* bitboard macros, one word per call, inlined
+// in caller code. Bit arrays from linalg_*_bitmask come from dispatched kernels.
+enum NMATH_SIMD_LEVELS {
+    NMATH_SIMD_SCALAR    = 0,
+    NMATH_SIMD_SSE2      = 1,
+    NMATH_SIMD_AVX2      = 2,
+    NMATH_SIMD_AVX512    = 3,
+    NMATH_SIMD_LEVEL_NUM = 4,
+};
+
+// level: highest level used, NMATH_SIMD_SCALAR to force scalar kernels.
+// Capped by nmath_detect_simd. Negative: back to nmath_detect_simd.
+extern void nmath_set_simd(int level);
+extern int nmath_get_simd(void);    // level used by kernels
+extern int nmath_detect_simd(void); // best level of CPU and build
+extern const char * nmath_simd_name(int level);
+
+/********************************** STATS ************************************/
+// Compile with -DNMATH_STATS for pathfinding counters, for nmath.c and files
+// including nmath.h. Needs C11 _Thread_local. Compiled out by default:
+// counters are then always 0.
+// Moveto, Visible, Attackto, Attackfrom, unitGradient and Astar functions
+// reset the counters when called, nested calls included in the outer call.
+// Counters are per thread: nmath_get_stats returns those of the last call
+// made on the calling thread.
+struct nmath_stats {
+    size_t pushes;       // nodes pushed on open lists and A* frontier
+    size_t pops;         // nodes popped from open lists and A* frontier
+    size_t reexpansions; // visited nodes reopened with a lower distance/cost
+    size_t closed_scans; // closed list nodes compared
+    size_t queue_scans;  // A* frontier nodes compared for sorted insertion
+    size_t sight_checks; // tiles checked for line of sight by Visible
+    size_t darr_grows;   // DARR reallocations
+    size_t allocs;       // nmath_malloc, nmath_calloc, nmath_realloc calls
+    uint64_t ns;         // wall time of the call
+};
+extern struct nmath_stats nmath_get_stats(void);
+extern uint64_t nmath_get_ns(void); // monotonic clock [ns]
+
+#ifdef NMATH_STATS
+extern _Thread_local struct nmath_stats nmath_stats;
+#define NMATH_STATS_ADD(counter, num) do {nmath_stats.counter += (num);} while (0)
+#else
+#define NMATH_STATS_ADD(counter, num) do {} while (0)
+#endif
+
+/******************************** HISTOGRAMS *********************************/
+// Compile nmath.c with -DNMATH_HISTOGRAMS for latency histograms of
+// pathfinding functions, all types merged. Needs gcc or clang (C11
+// _Thread_local, __atomic). Compiled out by default.
+// Each thread records in its own histograms, without locks, timed with
+// nmath_get_ns. Getters and dumps merge the histograms of every thread.
+// Log-linear buckets: 2^NMATH_HISTOGRAM_SUB_BITS per power of 2, exact
+// below that. Relative error of percentiles is 1/2^NMATH_HISTOGRAM_SUB_BITS.
+#define NMATH_HISTOGRAM_SUB_BITS 5
+#define NMATH_HISTOGRAM_SUB_LEN (1 << NMATH_HISTOGRAM_SUB_BITS)
+#define NMATH_HISTOGRAM_BUCKETS ((64 - NMATH_HISTOGRAM_SUB_BITS + 1) * NMATH_HISTOGRAM_SUB_LEN)
+
+enum NMATH_HISTOGRAM_FUNCTIONS {
+    NMATH_HISTOGRAM_MOVETO_NOM = 0,
+    NMATH_HISTOGRAM_MOVETO = 1,
+    NMATH_HISTOGRAM_MOVETO_HEX = 2,
+    NMATH_HISTOGRAM_VISIBLE_NOM = 3,
+    NMATH_HISTOGRAM_VISIBLE = 4,
+    NMATH_HISTOGRAM_VISIBLE_HEX = 5,
+    NMATH_HISTOGRAM_ATTACKTO_NOM = 6,
+    NMATH_HISTOGRAM_ATTACKTO = 7,
+    NMATH_HISTOGRAM_ATTACKFROM_NOM = 8,
+    NMATH_HISTOGRAM_ATTACKFROM = 9,
+    NMATH_HISTOGRAM_UNITGRADIENT_NOM = 10,
+    NMATH_HISTOGRAM_UNITGRADIENT = 11,
+    NMATH_HISTOGRAM_ASTAR_LIST = 12,
+    NMATH_HISTOGRAM_ASTAR_MAP = 13,
+    NMATH_HISTOGRAM_NUM = 14,
+};
+
+struct nmath_latency {
+    const char * name; // function name, without type
+    uint64_t count;    // recorded calls
+    uint64_t min;      // [ns]
+    uint64_t max;      // [ns]
+    uint64_t p50;      // [ns]
+    uint64_t p99;      // [ns]
+    uint64_t p999;     // [ns]
+};
+// histogram: NMATH_HISTOGRAM_FUNCTIONS. Always 0 without NMATH_HISTOGRAMS.
+extern struct nmath_latency nmath_histogram_get(int histogram);
+// buckets: NMATH_HISTOGRAM_BUCKETS counts, merged over threads, for export.
+extern void nmath_histogram_buckets(int histogram, uint64_t * buckets);
+extern uint64_t nmath_histogram_bucket_ns(size_t bucket); // lowest value
+extern void nmath_histogram_record(int histogram, uint64_t ns);
+// dump: one line per function with recorded calls: count min p50 p99 p999 max
+extern void nmath_histogram_dump(FILE * out);
+// reset: not while other threads call instrumented functions.
+extern void nmath_histogram_reset(void);
+
 #ifndef DARR
 #define DARR
 
@@ -29,6 +213,8 @@
 /********************** DARR: DYNAMIC ARRAYS FOR C99 v1.0 ******************/
 // A DARR is an array with two additional elements:
 //   -> allocated length (len) at [-2] and number of active element (num) at [-1]
+// In aligned mode (NMATH_ALIGNMENT > 0), the header is padded to
+// NMATH_ALIGNMENT bytes so that element [0] is aligned. len and num stay at [-2], [-1].
 
 #define DARR_GROWTH_FACTOR 2
 #define DARR_LEN_INDEX 2
@@ -37,16 +223,23 @@
 #define DARR_LEN(darr) (*((size_t *)darr - DARR_LEN_INDEX)) // allocated length
 #define DARR_NUM(darr) (*((size_t *)darr - DARR_NUM_INDEX)) // number of active elements
 
+// DARR_HEADER_BYTESIZE: bytes before element [0], len and num included.
+#define DARR_HEADER_BYTESIZE ((NMATH_ALIGNMENT > (sizeof(size_t) * DARR_LEN_INDEX)) ? NMATH_ALIGNMENT : (sizeof(size_t) * DARR_LEN_INDEX))
+
+// DARR_BASE: DARR internal. Pointer returned by the allocator.
+#define DARR_BASE(darr) ((void *)((unsigned char *)darr - DARR_HEADER_BYTESIZE))
+
 // DARR_INIT: a DARR is an array with  size_t num at -1 and size_t len at -2,
-#define DARR_INIT(darr, type, len) (type*)(((size_t* )malloc(sizeof(size_t)*DARR_LEN_INDEX + sizeof(type)*(len))) + DARR_LEN_INDEX);\
+#define DARR_INIT(darr, type, len) (type*)((unsigned char *)nmath_malloc(DARR_HEADER_BYTESIZE + sizeof(type)*(len)) + DARR_HEADER_BYTESIZE);\
     DARR_LEN(darr) = len;\
     DARR_NUM(darr) = 0;
 
 // DARR_REALLOC: DARR internal. Not to be called directly by users.
-#define DARR_REALLOC(darr, len) (void *)((size_t* )realloc(((size_t* )darr - DARR_LEN_INDEX), (sizeof(size_t)*DARR_LEN_INDEX + (sizeof(*darr))*(len))) + DARR_LEN_INDEX)
+#define DARR_REALLOC(darr, len) (void *)((unsigned char *)nmath_realloc(DARR_BASE(darr), (DARR_HEADER_BYTESIZE + (sizeof(*darr))*(len))) + DARR_HEADER_BYTESIZE)
 
 // DARR_GROW: increase array length by multiplying DARR_GROWTH_FACTOR
 #define DARR_GROW(darr) do {\
+    NMATH_STATS_ADD(darr_grows, 1);\
     DARR_LEN(darr)*=DARR_GROWTH_FACTOR;\
     darr = DARR_REALLOC(darr, DARR_LEN(darr));\
 } while(0)
@@ -58,6 +251,29 @@ DARR_GROW(darr);\
 darr[DARR_NUM(darr)++] = elem;\
 } while(0)
 
+// DARR_RESERVE: make room for at least len elements, with at most one realloc
+#define DARR_RESERVE(darr, len) do {if ((len) > DARR_LEN(darr)) {\
+    NMATH_STATS_ADD(darr_grows, 1);\
+    DARR_LEN(darr) = (len);\
+    darr = DARR_REALLOC(darr, DARR_LEN(darr));\
+}\
+} while(0)
+
+// DARR_APPEND_N: copy n elements from src on top of darr: one growth check, one memcpy
+#define DARR_APPEND_N(darr, src, n) do {if ((DARR_NUM(darr) + (n)) > (DARR_LEN(darr))) {\
+    size_t darr_grown_len = DARR_LEN(darr) * DARR_GROWTH_FACTOR;\
+    DARR_RESERVE(darr, ((DARR_NUM(darr) + (n)) < darr_grown_len ? darr_grown_len : (DARR_NUM(darr) + (n))));\
+}\
+memcpy((darr + DARR_NUM(darr)), (src), sizeof(*darr) * (n));\
+DARR_NUM(darr) += (n);\
+} while(0)
+
+// DARR_SHRINK: reallocate darr to fit its DARR_NUM active elements, at least 1
+#define DARR_SHRINK(darr) do {\
+    DARR_LEN(darr) = (DARR_NUM(darr) > 0) ? DARR_NUM(darr) : 1;\
+    darr = DARR_REALLOC(darr, DARR_LEN(darr));\
+} while(0)
+
 // DARR_INSERT: Put elem at inde, moving other elements over
 #define DARR_INSERT(darr, elem, index) do {if ((++DARR_NUM(darr)) >= (DARR_LEN(darr))) {\
 DARR_GROW(darr);\
@@ -84,7 +300,7 @@ darr[index] = elem;\
 } while(0)
 
 // DARR_FREE: free whole darr
-#define DARR_FREE(darr) do {free((((size_t* )darr) - DARR_LEN_INDEX));} while(0)
+#define DARR_FREE(darr) do {nmath_free(DARR_BASE(darr));} while(0)
 
 #endif /* DARR */
 
@@ -130,21 +346,21 @@ which becomes
 dtab_ptr = dtab_ptr = malloc(sizeof(*dtab_ptr));
 ...
 */
-#define DTAB_INIT(dtab_ptr, type) dtab_ptr = malloc(sizeof(*dtab_ptr));\
+#define DTAB_INIT(dtab_ptr, type) dtab_ptr = nmath_malloc(sizeof(*dtab_ptr));\
 dtab_ptr->len = DTAB_LEN_INIT;\
 dtab_ptr->num = DTAB_NUM_INIT;\
-dtab_ptr->values = calloc(DTAB_LEN_INIT, sizeof(type));\
-dtab_ptr->keys = malloc(sizeof(*dtab_ptr->keys) * (DTAB_LEN_INIT));\
+dtab_ptr->values = nmath_calloc(DTAB_LEN_INIT, sizeof(type));\
+dtab_ptr->keys = nmath_malloc(sizeof(*dtab_ptr->keys) * (DTAB_LEN_INIT));\
 dtab_ptr->keys[DTAB_NULL] = DTAB_NULL;\
 dtab_ptr->bytesize = sizeof(type);
 
 #define DTAB_GROW(dtab_ptr) do {\
     dtab_ptr->len*=DTAB_GROWTH_FACTOR;\
-    dtab_ptr->keys = realloc(dtab_ptr->keys, dtab_ptr->len * sizeof(uint64_t));\
-    dtab_ptr->values = realloc(dtab_ptr->values, dtab_ptr->len * dtab_ptr->bytesize);} while(0)
-#define DTAB_FREE(dtab_ptr) do {free(dtab_ptr->keys) ;\
-free(dtab_ptr->values);\
-free(dtab_ptr); } while(0)
+    dtab_ptr->keys = nmath_realloc(dtab_ptr->keys, dtab_ptr->len * sizeof(uint64_t));\
+    dtab_ptr->values = nmath_realloc(dtab_ptr->values, dtab_ptr->len * dtab_ptr->bytesize);} while(0)
+#define DTAB_FREE(dtab_ptr) do {nmath_free(dtab_ptr->keys) ;\
+nmath_free(dtab_ptr->values);\
+nmath_free(dtab_ptr); } while(0)
 
 /* DTAB macros
 Might be faster to put hash in variable and call functions directly?
@@ -172,11 +388,13 @@ S for stringify, H for hash */
 // bit_array_t * arr = calloc(NMATH_BIT_ARRAY_SIZE(bits), sizeof(bit_array_t));
 // bit_array_t * arr = malloc(bits / CHAR_BIT);
 // bits should be a multiple of sizeof(bit_array_t)
+// bit_array_t * arr = calloc(NMATH_BIT_ARRAY_SIZE_CEIL(bits), sizeof(bit_array_t)); // any bits
 
 typedef uint64_t bit_array_t; // for convenience
 
 #define NMATH_BIT_ARRAY_BITSPER (sizeof(bit_array_t) * CHAR_BIT)
 #define NMATH_BIT_ARRAY_SIZE(bits) ((bits) / NMATH_BIT_ARRAY_BITSPER)
+#define NMATH_BIT_ARRAY_SIZE_CEIL(bits) (((bits) + NMATH_BIT_ARRAY_BITSPER - 1) / NMATH_BIT_ARRAY_BITSPER)
 #define NMATH_BIT_ARRAY_BYTESIZE(bits) ((bits) / CHAR_BIT)
 
 #define NMATH_BIT_ARRAY_SET(arr, ind) (arr[(ind)/(NMATH_BIT_ARRAY_BITSPER)] |= (1ULL << ((ind)%(NMATH_BIT_ARRAY_BITSPER))))
@@ -270,6 +488,39 @@ enum NMATH_MODE_PATHS {
     NMATH_PATH_POSITION = 1,  // i.e. absolute path
 };
 
+enum NMATH_FUSED_OPS {
+    // out[i] = out[i] op operand[i]
+    NMATH_FUSED_PLUS = 0,
+    NMATH_FUSED_MINUS = 1,
+    NMATH_FUSED_MULT = 2,
+    NMATH_FUSED_DIV = 3,
+    NMATH_FUSED_MASK = 4,
+    NMATH_FUSED_SMALLER = 5,
+    NMATH_FUSED_SEQ = 6,
+    NMATH_FUSED_GREATER = 7,
+    NMATH_FUSED_GEQ = 8,
+    NMATH_FUSED_EQUAL = 9,
+    // out[i] = out[i] op scalar
+    NMATH_FUSED_PLUS_SCALAR = 10,
+    NMATH_FUSED_MINUS_SCALAR = 11,
+    NMATH_FUSED_MULT_SCALAR = 12,
+    NMATH_FUSED_DIV_SCALAR = 13,
+    NMATH_FUSED_SSMALLER = 14,
+    NMATH_FUSED_SSEQ = 15,
+    NMATH_FUSED_SGREATER = 16,
+    NMATH_FUSED_SGEQ = 17,
+};
+
+enum NMATH_BORDERS {
+    // value of out of bounds tiles for convolutions
+    NMATH_BORDER_ZERO = 0,
+    NMATH_BORDER_CLAMP = 1, // nearest tile
+    NMATH_BORDER_WRAP = 2,  // periodic map
+};
+
+#define NMATH_FUSED_CHUNK_BYTESIZE 4096 // fraction of L1
+#define NMATH_FUSED_CHUNK_LEN(type) (NMATH_FUSED_CHUNK_BYTESIZE / sizeof(type))
+
 #define uint64_t_MAX UINT64_MAX
 #define uint_fast64_t_MAX UINT64_MAX
 #define uint32_t_MAX UINT32_MAX
@@ -287,6 +538,9 @@ enum NMATH_MODE_PATHS {
 #define int8_t_MAX INT8_MAX
 #define int_fast8_t_MAX INT8_MAX
 
+#define NMATH_EPSILON_float FLT_EPSILON
+#define NMATH_EPSILON_double DBL_EPSILON
+
 #ifndef TEMPLATE_TYPES_UINT
 #define TEMPLATE_TYPES_UINT REGISTER_ENUM(uint8_t) \
 REGISTER_ENUM(uint16_t) \
@@ -469,15 +723,58 @@ type distance;\
 TEMPLATE_TYPES_INT
 #undef REGISTER_ENUM
 
-/******************************** UTILITIES **********************************/
+/* Compressed Sparse Row matrix.
+Row r: col_indices and values in [row_starts[r], row_starts[r + 1]) */
+#define REGISTER_ENUM(type) struct nmath_csr_##type {\
+size_t row_len;\
+size_t col_len;\
+size_t nnz;\
+size_t * row_starts;\
+size_t * col_indices;\
+type * values;\
+};
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) extern type nmath_Direction_Compute_##type(type x_0, type y_0, type x_1, type y_1);
+/* op: NMATH_FUSED_OPS. operand: arr_len elements, for array ops */
+#define REGISTER_ENUM(type) struct nmath_fused_op_##type {\
+int op;\
+type * operand;\
+type scalar;\
+};
 TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
-
-#define REGISTER_ENUM(type) extern type nmath_inbounds_##type(type pos, type boundmin, type boundmax);
-
+/******************************** UTILITIES **********************************/
+// Helpers called for every neighbour of pathfinding loops: static inline,
+// inlined in nmath.c and in every file including nmath.h, without LTO.
+
+#define REGISTER_ENUM(type) static inline type nmath_Direction_Compute_##type(type x_0, type y_0, type x_1, type y_1) { \
+    /* Movement direction for 1 tile steps. on a square grid*/ \
+    type direction = 0; \
+    type deltax = x_1 - x_0; \
+    type deltay = y_1 - y_0; \
+    if (deltax > 0) { \
+        direction = NMATH_DIRECTION_RIGHT; \
+    } else if (deltax < 0) { \
+        direction = NMATH_DIRECTION_LEFT; \
+    } else if (deltay > 0) { \
+        direction = NMATH_DIRECTION_UP; \
+    } else if (deltay < 0) { \
+        direction = NMATH_DIRECTION_DOWN; \
+    } \
+    return (direction); \
+}
+TEMPLATE_TYPES_INT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) static inline type nmath_inbounds_##type(type pos, type boundmin, type boundmax) {\
+    type out = 0;\
+    out = pos < boundmin ? boundmin : pos;\
+    out = out > boundmax ? boundmax : out;\
+    return (out);\
+}
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
@@ -787,6 +1084,40 @@ TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
+/******************************** SORTING *************************************/
+// Ascending order. Integers, bool: LSD radix sort. Floats: introsort.
+// NaN positions are unspecified.
+
+// sort: returns a sorted copy of array.
+#define REGISTER_ENUM(type) extern type * linalg_sort_##type(type * array, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+// sort_noM: sorts array in place. buffer: arr_len elements of scratch for
+// the radix sort, unused by floats (can be NULL).
+#define REGISTER_ENUM(type) extern type * linalg_sort_noM_##type(type * array, type * buffer, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+// argsort: indices that sort array. Stable: equal elements keep their order.
+#define REGISTER_ENUM(type) extern size_t * linalg_argsort_##type(type * array, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+// searchsorted: first index i of sorted array such that sorted[i] >= value.
+//      -> arr_len if all elements are smaller than value.
+#define REGISTER_ENUM(type) extern size_t linalg_searchsorted_##type(type * sorted, size_t arr_len, type value);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
 /********************************* LINALG ************************************/
 // linalg uses unraveled arrays as n-dimensional matrices
 // linalg design: let caller take care of memory. -> NO MEMORY CREATION FOR EACH AND EVERY linalg FUNCTION CALLS.
@@ -794,11 +1125,109 @@ TEMPLATE_TYPES_BOOL
 #define linalg_index_arr2D(row, col, col_len) (row * col_len + col)
 #define linalg_index_arr3D(row, col, depth, row_len, col_len) (row * col_len * depth_len + col * depth_len + depth)
 
+// lu_noM: in-place LU decomposition with partial pivoting, P * A = L * U.
+//      lu: sq_len x sq_len, A on input. L below the diagonal (unit diagonal
+//      implied), U on and above it on output.
+//      pivots: sq_len elements. Row k was swapped with row pivots[k].
+//      -> sign of the row permutation, 0 if singular.
+#define NMATH_LU_BLOCK 32
+#define REGISTER_ENUM(type) extern int linalg_lu_noM_##type(type * lu, size_t * pivots, size_t sq_len);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+// eigen_symmetric_noM: eigen decomposition of symmetric square_mat, in place.
+//      Householder tridiagonalization, then implicit QL.
+//      square_mat: sq_len x sq_len. Row i is the unit eigenvector of
+//      eigenvalues[i] on output. eigenvalues ascending, sq_len elements.
+//      work: sq_len elements of scratch.
+//      -> eigenvalues, NULL if QL did not converge.
+// Diagonalization: square_mat = V^T * diag(eigenvalues) * V, V on output.
+#define REGISTER_ENUM(type) extern type * linalg_eigen_symmetric_noM_##type(type * square_mat, type * eigenvalues, type * work, size_t sq_len);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+// convolve2D: out[row, col] = sum of kernel[i, j] * matrix[row + i - k_row_len / 2, col + j - k_col_len / 2]
+//      kernel: k_row_len x k_col_len. Not flipped: same as convolution for
+//      symmetric kernels. border: NMATH_BORDERS. out cannot be matrix.
+#define REGISTER_ENUM(type) extern type * linalg_convolve2D_noM_##type(type * out, type * matrix, type * kernel, size_t row_len, size_t col_len, size_t k_row_len, size_t k_col_len, int border);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern type * linalg_convolve2D_##type(type * matrix, type * kernel, size_t row_len, size_t col_len, size_t k_row_len, size_t k_col_len, int border);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+// convolve2D_separable_noM: convolve2D with kernel[i, j] = col_kernel[i] * row_kernel[j].
+//      row_kernel: k_col_len elements, along rows. col_kernel: k_row_len
+//      elements, along columns. buffer: row_len x col_len scratch.
+#define REGISTER_ENUM(type) extern type * linalg_convolve2D_separable_noM_##type(type * out, type * matrix, type * buffer, type * row_kernel, type * col_kernel, size_t row_len, size_t col_len, size_t k_row_len, size_t k_col_len, int border);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+// box_filter_noM: mean over the (2 * radius + 1)^2 window, with running sums:
+//      cost independent of radius. buffer: row_len x col_len scratch.
+#define REGISTER_ENUM(type) extern type * linalg_box_filter_noM_##type(type * out, type * matrix, type * buffer, size_t row_len, size_t col_len, size_t radius, int border);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+// csr_grid: tile adjacency graph of a row_len x col_len costmap.
+//      neighbours: NMATH_SQUARE_NEIGHBOURS or NMATH_HEXAGON_NEIGHBOURS.
+//      One row per tile. Edge from moveable tile to each moveable neighbour,
+//      value 1 / cost of the neighbour. Blocked tiles have empty rows.
+//      -> NULL for other neighbours.
+#define REGISTER_ENUM(type) extern struct nmath_csr_##type * linalg_csr_grid_##type(type * costmap, size_t row_len, size_t col_len, int neighbours);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern struct nmath_csr_##type * linalg_csr_transpose_##type(struct nmath_csr_##type * csr);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern void linalg_csr_free_##type(struct nmath_csr_##type * csr);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+// csr_spmv: out = csr * vec. vec: col_len elements, out: row_len elements.
+#define REGISTER_ENUM(type) extern type * linalg_csr_spmv_noM_##type(type * out, struct nmath_csr_##type * csr, type * vec);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern type * linalg_csr_spmv_##type(struct nmath_csr_##type * csr, type * vec);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+// determinant: floats with LU, integers with exact Bareiss elimination.
 #define REGISTER_ENUM(type) extern type linalg_determinant_##type(type * square_mat, size_t sq_len);
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
+// determinant_noM: buffer: sq_len x sq_len scratch, pivots: sq_len scratch.
+#define REGISTER_ENUM(type) extern type linalg_determinant_noM_##type(type * square_mat, type * buffer, size_t * pivots, size_t sq_len);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+// solve_noM: x such that A * x = b, with lu and pivots from lu_noM.
+//      Factor once, solve many times. x can be b.
+#define REGISTER_ENUM(type) extern type * linalg_solve_noM_##type(type * x, type * lu, size_t * pivots, type * b, size_t sq_len);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+// solve: -> NULL if square_mat is singular.
+#define REGISTER_ENUM(type) extern type * linalg_solve_##type(type * square_mat, type * b, size_t sq_len);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+// inverse_noM: inverse of A, with lu and pivots from lu_noM.
+#define REGISTER_ENUM(type) extern type * linalg_inverse_noM_##type(type * inverse, type * lu, size_t * pivots, size_t sq_len);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+// inverse: -> NULL if square_mat is singular.
+#define REGISTER_ENUM(type) extern type * linalg_inverse_##type(type * square_mat, size_t sq_len);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
 #define REGISTER_ENUM(type) extern type linalg_trace_##type(type * square_mat, size_t sq_len);
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
@@ -809,6 +1238,28 @@ TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
+// matmul: matrix product, out = matrix1 * matrix2.
+//      matrix1: row_len x inner_len, matrix2: inner_len x col_len,
+//      out: row_len x col_len. out can't be matrix1 or matrix2.
+// Cache blocking: MC x KC blocks of matrix1, KC x NC blocks of matrix2.
+#define NMATH_GEMM_MC 64
+#define NMATH_GEMM_KC 256
+#define NMATH_GEMM_NC 1024
+// matmul_noM buffer: NMATH_MATMUL_BUFFER_LEN elements of packing scratch.
+//      NULL: allocated and freed by matmul_noM, sized to the matrices.
+#define NMATH_MATMUL_BUFFER_LEN (NMATH_GEMM_MC * NMATH_GEMM_KC + NMATH_GEMM_KC * NMATH_GEMM_NC)
+#define REGISTER_ENUM(type) extern type * linalg_matmul_noM_##type(type * out, type * matrix1, type * matrix2, type * buffer, size_t row_len, size_t inner_len, size_t col_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern type * linalg_matmul_##type(type * matrix1, type * matrix2, size_t row_len, size_t inner_len, size_t col_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+// Deprecated: one allocation per product. Use linalg_crossProduct_noM, or
+// linalg_batch_crossProduct_noM for many vectors.
 #define REGISTER_ENUM(type) extern type * linalg_crossProduct_##type(type * vec3D1, type * vec3D2);
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
@@ -819,12 +1270,50 @@ TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
+// batch: num small D x D matrices (D = 2, 3, 4) and D x 1 vectors, in caller
+// memory, unrolled. No allocation, out can be an input.
+//   AoS: matrix i at matrices[i * D * D], row-major, vector i at vecs[i * D].
+//   soa: element k of matrix/vector i at array[k * num + i], for SIMD over i.
+// transform: one matrix for all vecs, i.e. points. matvec: one matrix per vec.
+// inverse: singular matrices give zero matrices.
+#define NMATH_BATCH_DECLARE(type, D) \
+extern type * linalg_batch_transform##D##_noM_##type(type * out, type * matrix, type * vecs, size_t num);\
+extern type * linalg_batch_transform##D##_soa_noM_##type(type * out, type * matrix, type * vecs, size_t num);\
+extern type * linalg_batch_matvec##D##_noM_##type(type * out, type * matrices, type * vecs, size_t num);\
+extern type * linalg_batch_matvec##D##_soa_noM_##type(type * out, type * matrices, type * vecs, size_t num);\
+extern type * linalg_batch_matmul##D##_noM_##type(type * out, type * matrices1, type * matrices2, size_t num);\
+extern type * linalg_batch_matmul##D##_soa_noM_##type(type * out, type * matrices1, type * matrices2, size_t num);\
+extern type * linalg_batch_determinant##D##_noM_##type(type * out, type * matrices, size_t num);\
+extern type * linalg_batch_determinant##D##_soa_noM_##type(type * out, type * matrices, size_t num);\
+extern type * linalg_batch_inverse##D##_noM_##type(type * out, type * matrices, size_t num);\
+extern type * linalg_batch_inverse##D##_soa_noM_##type(type * out, type * matrices, size_t num);
+
+#define REGISTER_ENUM(type) \
+NMATH_BATCH_DECLARE(type, 2)\
+NMATH_BATCH_DECLARE(type, 3)\
+NMATH_BATCH_DECLARE(type, 4)\
+extern type * linalg_batch_crossProduct_noM_##type(type * out, type * vecs1, type * vecs2, size_t num);\
+extern type * linalg_batch_crossProduct_soa_noM_##type(type * out, type * vecs1, type * vecs2, size_t num);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
 #define REGISTER_ENUM(type) extern type * linalg_uniques_##type(type * array, size_t arr_len);
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
+// uniques_2D/3D: unique points of a list, in order of first appearance. list_len in points.
+#define REGISTER_ENUM(type) extern type * linalg_uniques_2D_##type(type * list_2D, size_t list_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern type * linalg_uniques_3D_##type(type * list_3D, size_t list_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
 #define REGISTER_ENUM(type) extern bool linalg_isIn_##type(type * array, type to_find, size_t arr_len);
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
@@ -887,7 +1376,7 @@ TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
 // s for scalar
-#define REGISTER_ENUM(type) extern type * linalg_seq_noM_h##type(type * out, type * matrix1, type * matrix2, size_t arr_len);
+#define REGISTER_ENUM(type) extern type * linalg_seq_noM_##type(type * out, type * matrix1, type * matrix2, size_t arr_len);
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
@@ -948,6 +1437,57 @@ TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
+// bitmask: bit i of mask is set if the comparison is true for element i.
+// mask: NMATH_BIT_ARRAY_SIZE_CEIL(arr_len) elements. Unused trailing bits are cleared.
+#define REGISTER_ENUM(type) extern bit_array_t * linalg_smaller_bitmask_##type(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern bit_array_t * linalg_seq_bitmask_##type(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern bit_array_t * linalg_greater_bitmask_##type(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern bit_array_t * linalg_geq_bitmask_##type(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern bit_array_t * linalg_equal_bitmask_##type(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern bit_array_t * linalg_ssmaller_bitmask_##type(bit_array_t * mask, type * matrix1, type tocompare, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern bit_array_t * linalg_sseq_bitmask_##type(bit_array_t * mask, type * matrix1, type tocompare, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern bit_array_t * linalg_sgreater_bitmask_##type(bit_array_t * mask, type * matrix1, type tocompare, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern bit_array_t * linalg_sgeq_bitmask_##type(bit_array_t * mask, type * matrix1, type tocompare, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern bit_array_t * linalg_equal_bitmask_##type(bit_array_t * mask, type * matrix1, type * matrix2, size_t arr_len, type tolerance);
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
 #define REGISTER_ENUM(type) extern bool * linalg_equal_noM_##type(bool * out, type * matrix1, type * matrix2, size_t arr_len, type tolerance);
 TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
@@ -966,6 +1506,28 @@ TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
 #undef REGISTER_ENUM
 
+#define REGISTER_ENUM(type) extern size_t linalg_count_##type(type * matrix1, type to_count, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+TEMPLATE_TYPES_BOOL
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern type linalg_sum_##type(type * matrix1, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* linalg_min/linalg_max: 0 if arr_len is 0 */
+#define REGISTER_ENUM(type) extern type linalg_min_##type(type * matrix1, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern type linalg_max_##type(type * matrix1, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
 #define REGISTER_ENUM(type) extern type * linalg_draw_circ_noM_##type(type * out_mat, type origin_x, type origin_y, size_t radius, size_t row_len, size_t col_len);
 TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_BOOL
@@ -1105,6 +1667,21 @@ TEMPLATE_TYPES_INT
 TEMPLATE_TYPES_FLOAT
 #undef REGISTER_ENUM
 
+// fused: applies ops[0] to ops[op_num - 1] to matrix in one pass, chunk by
+// chunk: no intermediate matrices. ex: (a * mask + b) >= k
+//      {NMATH_FUSED_MULT, mask}, {NMATH_FUSED_PLUS, b}, {NMATH_FUSED_SGEQ, NULL, k}
+// Comparisons and mask give 0 or 1, like linalg_geq, linalg_mask.
+// Float NMATH_FUSED_EQUAL is exact. out can be matrix.
+#define REGISTER_ENUM(type) extern type * linalg_fused_noM_##type(type * out, type * matrix, struct nmath_fused_op_##type * ops, size_t op_num, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) extern type * linalg_fused_##type(type * matrix, struct nmath_fused_op_##type * ops, size_t op_num, size_t arr_len);
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
 #define REGISTER_ENUM(type) extern type * linalg_matrix2list_##type(type * matrix, size_t row_len, size_t col_len);
 TEMPLATE_TYPES_INT
 #undef REGISTER_ENUM
@@ -1123,12 +1700,21 @@ TEMPLATE_TYPES_BOOL
 TEMPLATE_TYPES_INT
 #undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) extern type linalg_distance_manhattan_point_##type(struct nmath_point_##type start, struct nmath_point_##type end);
-TEMPLATE_TYPES_INT
+/* static inline: A* heuristic, see UTILITIES */
+#define REGISTER_ENUM(type) static inline type linalg_distance_manhattan_point_##type(struct nmath_point_##type start, struct nmath_point_##type end) {\
+    /* Does not include endpoints */ \
+    type  distance = abs(start.x - end.x) + abs(start.y - end.y);\
+    return (distance);\
+}
+TEMPLATE_TYPES_SINT
 #undef REGISTER_ENUM
 
-#define REGISTER_ENUM(type) extern type linalg_distance_manhattan_##type(type x_0, type y_0, type x_1, type y_1);
-TEMPLATE_TYPES_INT
+#define REGISTER_ENUM(type) static inline type linalg_distance_manhattan_##type(type x_0, type y_0, type x_1, type y_1) {\
+    /* Does not include endpoints */ \
+    type distance = abs(x_0 -  x_1) + abs(y_0 - y_1);\
+    return (distance);\
+}
+TEMPLATE_TYPES_SINT
 #undef REGISTER_ENUM
 
 #define REGISTER_ENUM(type) extern type linalg_distance_euclidian_##type(struct nmath_point_##type start, struct nmath_point_##type end);
@@ -1231,4 +1817,12 @@ TEMPLATE_TYPES_SINT
 TEMPLATE_TYPES_SINT
 #undef REGISTER_ENUM
 
+/************************* SINGLE TRANSLATION UNIT ***************************/
+// #define NMATH_IMPLEMENTATION in ONE file before including nmath.h: nmath.c
+// is compiled in that file, do not link nmath.o. The whole library can then
+// inline into the caller, without LTO. Other files include nmath.h as usual.
+#ifdef NMATH_IMPLEMENTATION
+#include "nmath.c"
+#endif
+
 #endif /* NOURSMATH_H */
\ No newline at end of file
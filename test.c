@@ -175,6 +175,8 @@ enum {
 enum ENUM_TEST_PATHFINDING {
     ROW_LEN_TEST_PATHFINDING = 21,
     COL_LEN_TEST_PATHFINDING = 25,
+    ROW_LEN_TEST_BORDERS = 5,
+    COL_LEN_TEST_BORDERS = 8,
 };
 
 void orders_indices_uint32_t() {
@@ -216,6 +218,7 @@ void orders_indices_uint32_t() {
     lok(temp_uniques[1] == 10);
     lok(temp_uniques[2] == 4);
     lok(temp_uniques[3] == 6);
+    DARR_FREE(temp_uniques);
 }
 
 #define REGISTER_ENUM(type) void lina_d_##type() {\
@@ -2406,33 +2409,33 @@ void linalg_float() {
     out1 = linalg_equal_float(tempssq1, tempssq2, LINALG_SQUARE * LINALG_SQUARE, 1.0f);
     out2 = linalg_equal_bool(out1, tempssq6, LINALG_SQUARE * LINALG_SQUARE);
     lok(linalg_all_bool(out2, LINALG_SQUARE * LINALG_SQUARE));
-    free(out1);
-    free(out2);
+    nmath_free(out1);
+    nmath_free(out2);
     out1 = linalg_equal_float(tempssq1, tempssq2, LINALG_SQUARE * LINALG_SQUARE, 0.2f);
     out2 = linalg_equal_bool(out1, tempssq6, LINALG_SQUARE * LINALG_SQUARE);
     lok(linalg_all_bool(out2, LINALG_SQUARE * LINALG_SQUARE));
-    free(out1);
-    free(out2);
+    nmath_free(out1);
+    nmath_free(out2);
     out1 = linalg_equal_float(tempssq1, tempssq2, LINALG_SQUARE * LINALG_SQUARE, 0.02f);
     out2 = linalg_equal_bool(out1, tempssq3, LINALG_SQUARE * LINALG_SQUARE);
     lok(linalg_all_bool(out2, LINALG_SQUARE * LINALG_SQUARE));
-    free(out1);
-    free(out2);
+    nmath_free(out1);
+    nmath_free(out2);
     out1 = linalg_equal_float(tempssq1, tempssq2, LINALG_SQUARE * LINALG_SQUARE, 0.002f);
     out2 = linalg_equal_bool(out1, tempssq4, LINALG_SQUARE * LINALG_SQUARE);
     lok(linalg_all_bool(out2, LINALG_SQUARE * LINALG_SQUARE));
-    free(out1);
-    free(out2);
+    nmath_free(out1);
+    nmath_free(out2);
     out1 = linalg_equal_float(tempssq1, tempssq2, LINALG_SQUARE * LINALG_SQUARE, 0.0002f);
     out2 = linalg_equal_bool(out1, tempssq5, LINALG_SQUARE * LINALG_SQUARE);
     lok(linalg_all_bool(out2, LINALG_SQUARE * LINALG_SQUARE));
-    free(out1);
-    free(out2);
+    nmath_free(out1);
+    nmath_free(out2);
     out1 = linalg_equal_float(tempssq1, tempssq2, LINALG_SQUARE * LINALG_SQUARE, 0.00001f);
     out2 = linalg_equal_bool(out1, tempssq7, LINALG_SQUARE * LINALG_SQUARE);
     lok(linalg_all_bool(out2, LINALG_SQUARE * LINALG_SQUARE));
-    free(out1);
-    free(out2);
+    nmath_free(out1);
+    nmath_free(out2);
 }
 
 void linalg_double() {
@@ -2487,33 +2490,33 @@ void linalg_double() {
     lok(out2);
     linalg_all_bool(out1, (size_t)(LINALG_SQUARE * LINALG_SQUARE));
 
-    free(out1);
-    free(out2);
+    nmath_free(out1);
+    nmath_free(out2);
     out1 = linalg_equal_double(tempssq1, tempssq2, LINALG_SQUARE * LINALG_SQUARE, 0.2f);
     out2 = linalg_equal_bool(out1, tempssq6, LINALG_SQUARE * LINALG_SQUARE);
     lok(linalg_all_bool(out2, LINALG_SQUARE * LINALG_SQUARE));
-    free(out1);
-    free(out2);
+    nmath_free(out1);
+    nmath_free(out2);
     out1 = linalg_equal_double(tempssq1, tempssq2, LINALG_SQUARE * LINALG_SQUARE, 0.02f);
     out2 = linalg_equal_bool(out1, tempssq3, LINALG_SQUARE * LINALG_SQUARE);
     lok(linalg_all_bool(out2, LINALG_SQUARE * LINALG_SQUARE));
-    free(out1);
-    free(out2);
+    nmath_free(out1);
+    nmath_free(out2);
     out1 = linalg_equal_double(tempssq1, tempssq2, LINALG_SQUARE * LINALG_SQUARE, 0.002f);
     out2 = linalg_equal_bool(out1, tempssq4, LINALG_SQUARE * LINALG_SQUARE);
     lok(linalg_all_bool(out2, LINALG_SQUARE * LINALG_SQUARE));
-    free(out1);
-    free(out2);
+    nmath_free(out1);
+    nmath_free(out2);
     out1 = linalg_equal_double(tempssq1, tempssq2, LINALG_SQUARE * LINALG_SQUARE, 0.0002f);
     out2 = linalg_equal_bool(out1, tempssq5, LINALG_SQUARE * LINALG_SQUARE);
     lok(linalg_all_bool(out2, LINALG_SQUARE * LINALG_SQUARE));
-    free(out1);
-    free(out2);
+    nmath_free(out1);
+    nmath_free(out2);
     out1 = linalg_equal_double(tempssq1, tempssq2, LINALG_SQUARE * LINALG_SQUARE, 0.00001f);
     out2 = linalg_equal_bool(out1, tempssq7, LINALG_SQUARE * LINALG_SQUARE);
     lok(linalg_all_bool(out2, LINALG_SQUARE * LINALG_SQUARE));
-    free(out1);
-    free(out2);
+    nmath_free(out1);
+    nmath_free(out2);
 }
 
 
@@ -3059,6 +3062,135 @@ void test_pathfinding_Astar() {
     // dupprintf(globalf, "\n end\n");
 }
 
+void test_pathfinding_borders() {
+    /* Starts and goals on border and corner tiles of a non-square map */
+    size_t arr_len = ROW_LEN_TEST_BORDERS * COL_LEN_TEST_BORDERS;
+    int32_t costmap[ROW_LEN_TEST_BORDERS * COL_LEN_TEST_BORDERS] = {
+        1, 1, 1, 1, 1, 1, 1, 1,
+        1, 0, 0, 2, 1, 1, 0, 1,
+        1, 1, 1, 0, 1, 2, 0, 1,
+        1, 2, 1, 1, 1, 1, 0, 1,
+        1, 1, 1, 1, 0, 1, 1, 1,
+    };
+    struct nmath_point_int32_t starts[4] = {{0, 0}, {7, 4}, {7, 0}, {3, 4}};
+    int32_t temp_movemaps[4][ROW_LEN_TEST_BORDERS * COL_LEN_TEST_BORDERS] = {
+        {
+            1, 2, 3, 4, 5, 0, 0, 0,
+            2, 0, 0, 0, 0, 0, 0, 0,
+            3, 4, 5, 0, 0, 0, 0, 0,
+            4, 0, 0, 0, 0, 0, 0, 0,
+            5, 0, 0, 0, 0, 0, 0, 0,
+        },
+        {
+            0, 0, 0, 0, 0, 0, 0, 5,
+            0, 0, 0, 0, 0, 0, 0, 4,
+            0, 0, 0, 0, 0, 0, 0, 3,
+            0, 0, 0, 0, 5, 4, 0, 2,
+            0, 0, 0, 0, 0, 3, 2, 1,
+        },
+        {
+            0, 0, 0, 5, 4, 3, 2, 1,
+            0, 0, 0, 0, 5, 4, 0, 2,
+            0, 0, 0, 0, 0, 0, 0, 3,
+            0, 0, 0, 0, 0, 0, 0, 4,
+            0, 0, 0, 0, 0, 0, 0, 5,
+        },
+        {
+            0, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 0, 0, 5, 0, 0, 0,
+            0, 5, 4, 0, 4, 0, 0, 0,
+            5, 5, 3, 2, 3, 4, 0, 0,
+            4, 3, 2, 1, 0, 5, 0, 0,
+        },
+    };
+    for (size_t i = 0; i < 4; i++) {
+        int32_t * movemap = pathfinding_Map_Moveto_int32_t(costmap, ROW_LEN_TEST_BORDERS, COL_LEN_TEST_BORDERS, starts[i], 4, NMATH_POINTS_MODE_MATRIX);
+        int32_t * movelist = pathfinding_Map_Moveto_int32_t(costmap, ROW_LEN_TEST_BORDERS, COL_LEN_TEST_BORDERS, starts[i], 4, NMATH_POINTS_MODE_LIST);
+        lok(memcmp(movemap, temp_movemaps[i], arr_len * sizeof(*movemap)) == 0);
+        lok((DARR_NUM(movelist) / NMATH_TWO_D) == (arr_len - linalg_count_int32_t(movemap, 0, arr_len)));
+        for (size_t j = 0; j < DARR_NUM(movelist) / NMATH_TWO_D; j++) {
+            lok(movemap[movelist[j * NMATH_TWO_D + 1] * COL_LEN_TEST_BORDERS + movelist[j * NMATH_TWO_D + 0]] > 0);
+        }
+        nmath_free(movemap);
+        DARR_FREE(movelist);
+    }
+
+    /* Hex Moveto on the left and right edges */
+    struct nmath_hexpoint_int32_t hexstarts[2] = {{0, -2, 2}, {7, -9, 2}};
+    int32_t temp_hexmovemaps[2][ROW_LEN_TEST_BORDERS * COL_LEN_TEST_BORDERS] = {
+        {
+            3, 3, 4, 0, 0, 0, 0, 0,
+            2, 0, 0, 4, 0, 0, 0, 0,
+            1, 2, 3, 0, 0, 0, 0, 0,
+            2, 3, 4, 0, 0, 0, 0, 0,
+            3, 4, 0, 0, 0, 0, 0, 0,
+        },
+        {
+            0, 0, 0, 0, 0, 0, 4, 3,
+            0, 0, 0, 0, 0, 0, 0, 2,
+            0, 0, 0, 0, 0, 0, 0, 1,
+            0, 0, 0, 0, 0, 0, 0, 2,
+            0, 0, 0, 0, 0, 4, 3, 3,
+        },
+    };
+    for (size_t i = 0; i < 2; i++) {
+        int32_t * hexmovemap = pathfinding_Map_Moveto_Hex_int32_t(costmap, ROW_LEN_TEST_BORDERS, COL_LEN_TEST_BORDERS, hexstarts[i], 3, NMATH_POINTS_MODE_MATRIX);
+        int32_t * hexmovelist = pathfinding_Map_Moveto_Hex_int32_t(costmap, ROW_LEN_TEST_BORDERS, COL_LEN_TEST_BORDERS, hexstarts[i], 3, NMATH_POINTS_MODE_LIST);
+        lok(memcmp(hexmovemap, temp_hexmovemaps[i], arr_len * sizeof(*hexmovemap)) == 0);
+        lok((DARR_NUM(hexmovelist) / NMATH_TWO_D) == (arr_len - linalg_count_int32_t(hexmovemap, 0, arr_len)));
+        for (size_t j = 0; j < DARR_NUM(hexmovelist) / NMATH_TWO_D; j++) {
+            lok(hexmovemap[hexmovelist[j * NMATH_TWO_D + 1] * COL_LEN_TEST_BORDERS + hexmovelist[j * NMATH_TWO_D + 0]] > 0);
+        }
+        nmath_free(hexmovemap);
+        DARR_FREE(hexmovelist);
+    }
+
+    /* Astar_Map and Astar_List: same path, corner to corner and edge to edge */
+    struct nmath_point_int32_t ends[3][2] = {{{0, 0}, {7, 4}}, {{7, 0}, {0, 4}}, {{0, 2}, {7, 2}}};
+    int32_t temp_paths[3][ROW_LEN_TEST_BORDERS * COL_LEN_TEST_BORDERS] = {
+        {
+            1, 0, 0, 0, 0, 0, 0, 0,
+            1, 0, 0, 0, 0, 0, 0, 0,
+            1, 1, 1, 0, 0, 0, 0, 0,
+            0, 0, 1, 1, 1, 1, 0, 0,
+            0, 0, 0, 0, 0, 1, 1, 1,
+        },
+        {
+            0, 0, 0, 0, 0, 1, 1, 1,
+            0, 0, 0, 0, 1, 1, 0, 0,
+            0, 0, 0, 0, 1, 0, 0, 0,
+            0, 0, 0, 1, 1, 0, 0, 0,
+            1, 1, 1, 1, 0, 0, 0, 0,
+        },
+        {
+            1, 1, 1, 1, 1, 1, 1, 1,
+            1, 0, 0, 0, 0, 0, 0, 1,
+            1, 0, 0, 0, 0, 0, 0, 1,
+            0, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 0, 0, 0,
+        },
+    };
+    for (size_t i = 0; i < 3; i++) {
+        struct nmath_point_int32_t start = ends[i][0], end = ends[i][1];
+        int32_t * path_list = DARR_INIT(path_list, int32_t, 32);
+        path_list = pathfinding_Astar_List_int32_t(path_list, costmap, ROW_LEN_TEST_BORDERS, COL_LEN_TEST_BORDERS, start, end);
+        int32_t * path_map = calloc(arr_len, sizeof(*path_map));
+        path_map = pathfinding_Astar_Map_int32_t(path_map, costmap, ROW_LEN_TEST_BORDERS, COL_LEN_TEST_BORDERS, start, end);
+        size_t list_len = DARR_NUM(path_list) / NMATH_TWO_D;
+        lok((path_list[0] == end.x) && (path_list[1] == end.y));
+        lok((path_list[(list_len - 1) * NMATH_TWO_D + 0] == start.x) && (path_list[(list_len - 1) * NMATH_TWO_D + 1] == start.y));
+        for (size_t j = 1; j < list_len; j++) {
+            lok(linalg_distance_manhattan_int32_t(path_list[(j - 1) * NMATH_TWO_D + 0], path_list[(j - 1) * NMATH_TWO_D + 1], path_list[j * NMATH_TWO_D + 0], path_list[j * NMATH_TWO_D + 1]) == 1);
+        }
+        int32_t * path_matrix = linalg_list2matrix_int32_t(path_list, ROW_LEN_TEST_BORDERS, COL_LEN_TEST_BORDERS, list_len);
+        lok(memcmp(path_matrix, temp_paths[i], arr_len * sizeof(*path_matrix)) == 0);
+        lok(memcmp(path_map, temp_paths[i], arr_len * sizeof(*path_map)) == 0);
+        nmath_free(path_matrix);
+        DARR_FREE(path_list);
+        free(path_map);
+    }
+}
+
 #define REGISTER_ENUM(type) void test_pathfinding_##type() {\
     /* dupprintf(globalf,"\ntest_pathfinding\n"); */ \
     struct nmath_point_##type start = {10, 6};\
@@ -4298,6 +4430,1250 @@ void test_bit_array() {
     }
 }
 
+void test_darr() {
+    int32_t * darr = DARR_INIT(darr, int32_t, 2);
+    DARR_RESERVE(darr, 16);
+    lok(DARR_LEN(darr) == 16);
+    lok(DARR_NUM(darr) == 0);
+    DARR_RESERVE(darr, 8);
+    lok(DARR_LEN(darr) == 16);
+    int32_t src[40];
+    for (int32_t i = 0; i < 40; i++) {
+        src[i] = i;
+    }
+    DARR_APPEND_N(darr, src, 16);
+    lok(DARR_NUM(darr) == 16);
+    lok(DARR_LEN(darr) == 16);
+    DARR_APPEND_N(darr, src, 40);
+    lok(DARR_NUM(darr) == 56);
+    lok(DARR_LEN(darr) >= 56);
+    for (int32_t i = 0; i < 16; i++) {
+        lok(darr[i] == i);
+    }
+    for (int32_t i = 0; i < 40; i++) {
+        lok(darr[16 + i] == i);
+    }
+    DARR_PUT(darr, 100);
+    lok(darr[56] == 100);
+    DARR_SHRINK(darr);
+    lok(DARR_LEN(darr) == 57);
+    lok(DARR_NUM(darr) == 57);
+    lok(darr[56] == 100);
+    DARR_NUM(darr) = 0;
+    DARR_SHRINK(darr);
+    lok(DARR_LEN(darr) == 1);
+    DARR_PUT(darr, 3);
+    DARR_PUT(darr, 4);
+    lok(darr[0] == 3);
+    lok(darr[1] == 4);
+    DARR_FREE(darr);
+
+    int32_t step_list[6] = {1, 0, 0, 1, -1, 0};
+    struct nmath_point_int32_t start = {2, 3};
+    int32_t * position = pathfinding_Path_step2position_int32_t(step_list, 3, start);
+    lok(DARR_NUM(position) == 8);
+    lok((position[0] == 2) && (position[1] == 3));
+    lok((position[2] == 3) && (position[3] == 3));
+    lok((position[4] == 3) && (position[5] == 4));
+    lok((position[6] == 2) && (position[7] == 4));
+    DARR_FREE(position);
+}
+
+void test_uniques() {
+    int32_t list_2D[16] = {
+        1, 2, 3, 4, 1, 2, 2, 1,
+        3, 4, 2, 1, 0, 0, 1, 2
+    };
+    int32_t * uniques_2D = linalg_uniques_2D_int32_t(list_2D, 8);
+    lok(DARR_NUM(uniques_2D) == 4 * NMATH_TWO_D);
+    lok((uniques_2D[0] == 1) && (uniques_2D[1] == 2));
+    lok((uniques_2D[2] == 3) && (uniques_2D[3] == 4));
+    lok((uniques_2D[4] == 2) && (uniques_2D[5] == 1));
+    lok((uniques_2D[6] == 0) && (uniques_2D[7] == 0));
+    DARR_FREE(uniques_2D);
+
+    float list_3D[12] = {0.0f, 1.5f, 2.0f, -0.0f, 1.5f, 2.0f, 0.0f, 2.0f, 1.5f, 0.0f, 1.5f, 2.0f};
+    float * uniques_3D = linalg_uniques_3D_float(list_3D, 4);
+    lok(DARR_NUM(uniques_3D) == 2 * NMATH_THREE_D);
+    lok((uniques_3D[0] == 0.0f) && (uniques_3D[1] == 1.5f) && (uniques_3D[2] == 2.0f));
+    lok((uniques_3D[3] == 0.0f) && (uniques_3D[4] == 2.0f) && (uniques_3D[5] == 1.5f));
+    DARR_FREE(uniques_3D);
+
+    size_t arr_len = 10000;
+    uint16_t * array = calloc(arr_len, sizeof(*array));
+    for (size_t i = 0; i < arr_len; i++) {
+        array[i] = (uint16_t)((i * 7919) % 1000);
+    }
+    uint16_t * uniques = linalg_uniques_uint16_t(array, arr_len);
+    lok(DARR_NUM(uniques) == 1000);
+    lok(DARR_LEN(uniques) == 1000);
+    for (size_t i = 0; i < DARR_NUM(uniques); i++) {
+        lok(uniques[i] == array[i]);
+    }
+    DARR_FREE(uniques);
+    free(array);
+
+    uniques = linalg_uniques_uint16_t(NULL, 0);
+    lok(DARR_NUM(uniques) == 0);
+    DARR_FREE(uniques);
+
+    float cost_matrix[9] = {
+        1, 1, 1,
+        1, 0, 1,
+        1, 1, 1
+    };
+    struct nmath_point_float start = {0, 0};
+    float * move_list = pathfinding_Map_Moveto_float(cost_matrix, 3, 3, start, 2, NMATH_POINTS_MODE_LIST);
+    lok(DARR_NUM(move_list) == 5 * NMATH_TWO_D);
+    float * move_uniques = linalg_uniques_2D_float(move_list, DARR_NUM(move_list) / NMATH_TWO_D);
+    lok(DARR_NUM(move_uniques) == DARR_NUM(move_list));
+    for (size_t i = 0; i < DARR_NUM(move_list); i++) {
+        lok((move_list[i] >= 0.0f) && (move_list[i] <= 2.0f));
+    }
+    lok(!linalg_list_isIn_2D_float(move_list, DARR_NUM(move_list) / NMATH_TWO_D, 1.0f, 1.0f));
+    DARR_FREE(move_uniques);
+    DARR_FREE(move_list);
+}
+
+void test_sort() {
+    int8_t arr_int8[10] = {5, -3, 127, -128, 0, 5, -1, 1, 0, -3};
+    int8_t sorted_int8[10] = {-128, -3, -3, -1, 0, 0, 1, 5, 5, 127};
+    int8_t * out_int8 = linalg_sort_int8_t(arr_int8, 10);
+    for (size_t i = 0; i < 10; i++) {
+        lok(out_int8[i] == sorted_int8[i]);
+    }
+    lok(linalg_searchsorted_int8_t(out_int8, 10, -3) == 1);
+    lok(linalg_searchsorted_int8_t(out_int8, 10, 2) == 7);
+    lok(linalg_searchsorted_int8_t(out_int8, 10, -128) == 0);
+    lok(linalg_searchsorted_int8_t(out_int8, 10, 127) == 9);
+    nmath_free(out_int8);
+    size_t argsorted_int8[10] = {3, 1, 9, 6, 4, 8, 7, 0, 5, 2};
+    size_t * indices = linalg_argsort_int8_t(arr_int8, 10);
+    for (size_t i = 0; i < 10; i++) {
+        lok(indices[i] == argsorted_int8[i]);
+    }
+    nmath_free(indices);
+
+    int64_t arr_int64[6] = {INT64_MAX, -1, INT64_MIN, 1LL << 40, 0, -(1LL << 40)};
+    int64_t buffer_int64[6];
+    linalg_sort_noM_int64_t(arr_int64, buffer_int64, 6);
+    lok(arr_int64[0] == INT64_MIN);
+    lok(arr_int64[1] == -(1LL << 40));
+    lok(arr_int64[2] == -1);
+    lok(arr_int64[3] == 0);
+    lok(arr_int64[4] == (1LL << 40));
+    lok(arr_int64[5] == INT64_MAX);
+
+    size_t arr_len = 5000;
+    uint32_t * arr_uint32 = calloc(arr_len, sizeof(*arr_uint32));
+    double * arr_double = calloc(arr_len, sizeof(*arr_double));
+    uint32_t state = 12345;
+    for (size_t i = 0; i < arr_len; i++) {
+        state = state * 1664525u + 1013904223u;
+        arr_uint32[i] = state;
+        arr_double[i] = ((double)(state % 2000) - 1000.0) / 7.0;
+    }
+    uint32_t * out_uint32 = linalg_sort_uint32_t(arr_uint32, arr_len);
+    double * out_double = linalg_sort_double(arr_double, arr_len);
+    indices = linalg_argsort_double(arr_double, arr_len);
+    bool sorted = true, stable = true;
+    for (size_t i = 1; i < arr_len; i++) {
+        sorted &= (out_uint32[i - 1] <= out_uint32[i]);
+        sorted &= (out_double[i - 1] <= out_double[i]);
+        sorted &= (arr_double[indices[i]] == out_double[i]);
+        if (arr_double[indices[i - 1]] == arr_double[indices[i]]) {
+            stable &= (indices[i - 1] < indices[i]);
+        }
+    }
+    lok(sorted);
+    lok(stable);
+    size_t index = linalg_searchsorted_double(out_double, arr_len, 0.0);
+    lok((index == arr_len) || (out_double[index] >= 0.0));
+    lok((index == 0) || (out_double[index - 1] < 0.0));
+    nmath_free(indices);
+    nmath_free(out_uint32);
+    nmath_free(out_double);
+    free(arr_uint32);
+    free(arr_double);
+
+    float arr_float[5] = {2.5f, -1.0f, 2.5f, 0.0f, -7.25f};
+    linalg_sort_noM_float(arr_float, NULL, 5);
+    lok(arr_float[0] == -7.25f);
+    lok(arr_float[1] == -1.0f);
+    lok(arr_float[2] == 0.0f);
+    lok(arr_float[3] == 2.5f);
+    lok(arr_float[4] == 2.5f);
+
+    bool arr_bool[6] = {true, false, true, false, false, true};
+    indices = linalg_argsort_bool(arr_bool, 6);
+    lok((indices[0] == 1) && (indices[1] == 3) && (indices[2] == 4));
+    lok((indices[3] == 0) && (indices[4] == 2) && (indices[5] == 5));
+    nmath_free(indices);
+}
+
+#define REGISTER_ENUM(type) void test_kernels_##type() {\
+    size_t arr_len = 77;\
+    type * matrix1 = calloc(arr_len, sizeof(type));\
+    type * matrix2 = calloc(arr_len, sizeof(type));\
+    type * out = calloc(arr_len, sizeof(type));\
+    for (size_t i = 0; i < arr_len; i++) {\
+        matrix1[i] = (type)((i * 7) % 11 + 2);\
+        matrix2[i] = (type)((i * 3) % 9 + 1);\
+    }\
+    type * plus = linalg_plus_##type(matrix1, matrix2, arr_len);\
+    type * minus = linalg_minus_##type(matrix1, matrix2, arr_len);\
+    type * mult = linalg_mult_##type(matrix1, matrix2, arr_len);\
+    type * div = linalg_div_##type(matrix1, matrix2, arr_len);\
+    type * plus_s = linalg_plus_scalar_##type(matrix1, 3, arr_len);\
+    type * minus_s = linalg_minus_scalar_##type(matrix1, 2, arr_len);\
+    type * mult_s = linalg_mult_scalar_##type(matrix1, 2, arr_len);\
+    type * div_s = linalg_div_scalar_##type(matrix1, 2, arr_len);\
+    bool same = true;\
+    for (size_t i = 0; i < arr_len; i++) {\
+        same &= (plus[i] == (type)(matrix1[i] + matrix2[i]));\
+        same &= (minus[i] == (type)(matrix1[i] - matrix2[i]));\
+        same &= (mult[i] == (type)(matrix1[i] * matrix2[i]));\
+        same &= (div[i] == (type)(matrix1[i] / matrix2[i]));\
+        same &= (plus_s[i] == (type)(matrix1[i] + 3));\
+        same &= (minus_s[i] == (type)(matrix1[i] - 2));\
+        same &= (mult_s[i] == (type)(matrix1[i] * 2));\
+        same &= (div_s[i] == (type)(matrix1[i] / 2));\
+    }\
+    lok(same);\
+    linalg_mult_noM_##type(out, matrix1, matrix2, arr_len);\
+    lok(memcmp(out, mult, arr_len * sizeof(type)) == 0);\
+    linalg_plus_noM_##type(matrix1, matrix2, arr_len);\
+    lok(memcmp(matrix1, plus, arr_len * sizeof(type)) == 0);\
+    linalg_sub_noM_##type(matrix1, matrix2, arr_len);\
+    linalg_minus_noM_##type(out, plus, matrix2, arr_len);\
+    lok(memcmp(matrix1, out, arr_len * sizeof(type)) == 0);\
+    nmath_free(plus);\
+    nmath_free(minus);\
+    nmath_free(mult);\
+    nmath_free(div);\
+    nmath_free(plus_s);\
+    nmath_free(minus_s);\
+    nmath_free(mult_s);\
+    nmath_free(div_s);\
+    free(matrix1);\
+    free(matrix2);\
+    free(out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) void test_bitmask_##type() {\
+    size_t arr_len = 133;\
+    type * matrix1 = calloc(arr_len, sizeof(type));\
+    type * matrix2 = calloc(arr_len, sizeof(type));\
+    bit_array_t * mask = calloc(NMATH_BIT_ARRAY_SIZE_CEIL(arr_len), sizeof(*mask));\
+    for (size_t i = 0; i < arr_len; i++) {\
+        matrix1[i] = (type)((i * 7) % 13);\
+        matrix2[i] = (type)((i * 5) % 11);\
+    }\
+    type * smaller = linalg_smaller_##type(matrix1, matrix2, arr_len);\
+    type * geq = linalg_geq_##type(matrix1, matrix2, arr_len);\
+    type * equal = linalg_equal_##type(matrix1, matrix2, arr_len);\
+    type * sgreater = linalg_sgreater_##type(matrix1, 6, arr_len);\
+    type * sseq = linalg_sseq_##type(matrix1, 6, arr_len);\
+    bool same = true;\
+    for (size_t i = 0; i < arr_len; i++) {\
+        same &= (smaller[i] == (matrix1[i] < matrix2[i]));\
+        same &= (geq[i] == (matrix1[i] >= matrix2[i]));\
+        same &= (equal[i] == (matrix1[i] == matrix2[i]));\
+        same &= (sgreater[i] == (matrix1[i] > 6));\
+        same &= (sseq[i] == (matrix1[i] <= 6));\
+    }\
+    lok(same);\
+    memset(mask, 0xFF, NMATH_BIT_ARRAY_SIZE_CEIL(arr_len) * sizeof(*mask));\
+    linalg_smaller_bitmask_##type(mask, matrix1, matrix2, arr_len);\
+    same = true;\
+    for (size_t i = 0; i < arr_len; i++) {\
+        same &= (NMATH_BIT_ARRAY_GET(mask, i) == smaller[i]);\
+    }\
+    for (size_t i = arr_len; i < NMATH_BIT_ARRAY_SIZE_CEIL(arr_len) * NMATH_BIT_ARRAY_BITSPER; i++) {\
+        same &= (NMATH_BIT_ARRAY_GET(mask, i) == 0);\
+    }\
+    linalg_sseq_bitmask_##type(mask, matrix1, 6, arr_len);\
+    for (size_t i = 0; i < arr_len; i++) {\
+        same &= (NMATH_BIT_ARRAY_GET(mask, i) == sseq[i]);\
+    }\
+    linalg_equal_bitmask_##type(mask, matrix1, matrix2, arr_len);\
+    for (size_t i = 0; i < arr_len; i++) {\
+        same &= (NMATH_BIT_ARRAY_GET(mask, i) == equal[i]);\
+    }\
+    lok(same);\
+    nmath_free(smaller);\
+    nmath_free(geq);\
+    nmath_free(equal);\
+    nmath_free(sgreater);\
+    nmath_free(sseq);\
+    free(mask);\
+    free(matrix1);\
+    free(matrix2);\
+}
+TEMPLATE_TYPES_INT
+#undef REGISTER_ENUM
+
+void test_bitmask_float() {
+    size_t arr_len = 70;
+    double matrix1[70], matrix2[70];
+    bit_array_t mask[NMATH_BIT_ARRAY_SIZE_CEIL(70)];
+    for (size_t i = 0; i < arr_len; i++) {
+        matrix1[i] = i * 0.5;
+        matrix2[i] = matrix1[i] + ((i % 3 == 0) ? 0.25 : 0.0);
+    }
+    linalg_equal_bitmask_double(mask, matrix1, matrix2, arr_len, 0.1);
+    bool * equal = linalg_equal_double(matrix1, matrix2, arr_len, 0.1);
+    bool same = true;
+    for (size_t i = 0; i < arr_len; i++) {
+        same &= (NMATH_BIT_ARRAY_GET(mask, i) == equal[i]);
+        same &= (equal[i] == (i % 3 != 0));
+    }
+    lok(same);
+    nmath_free(equal);
+}
+
+#define REGISTER_ENUM(type) void test_reductions_##type() {\
+    size_t arr_len = 301;\
+    type * matrix = calloc(arr_len, sizeof(type));\
+    for (size_t i = 0; i < arr_len; i++) {\
+        matrix[i] = (type)(((i * 7) % 13) + 1);\
+    }\
+    matrix[150] = (type)100;\
+    matrix[77] = (type)-1;\
+    type min = matrix[0], max = matrix[0];\
+    size_t count = 0;\
+    for (size_t i = 0; i < arr_len; i++) {\
+        min = (matrix[i] < min) ? matrix[i] : min;\
+        max = (matrix[i] > max) ? matrix[i] : max;\
+        count += (matrix[i] == (type)5);\
+    }\
+    lok(linalg_min_##type(matrix, arr_len) == min);\
+    lok(linalg_max_##type(matrix, arr_len) == max);\
+    lok(linalg_count_##type(matrix, 5, arr_len) == count);\
+    lok(linalg_min_##type(matrix + 3, 2) == (type)3);\
+    lok(linalg_sum_##type(matrix, 0) == 0);\
+    lok(linalg_any_##type(matrix, arr_len));\
+    lok(linalg_all_##type(matrix, arr_len));\
+    lok(linalg_isIn_##type(matrix, 100, arr_len));\
+    lok(!linalg_isIn_##type(matrix, 42, arr_len));\
+    matrix[arr_len - 1] = 42;\
+    lok(linalg_isIn_##type(matrix, 42, arr_len));\
+    lok(!linalg_isIn_##type(matrix, 42, arr_len - 1));\
+    matrix[arr_len - 1] = 0;\
+    lok(!linalg_all_##type(matrix, arr_len));\
+    lok(linalg_all_##type(matrix, arr_len - 1));\
+    memset(matrix, 0, arr_len * sizeof(type));\
+    lok(!linalg_any_##type(matrix, arr_len));\
+    matrix[200] = 1;\
+    lok(linalg_any_##type(matrix, arr_len));\
+    lok(!linalg_any_##type(matrix, 200));\
+    lok(linalg_count_##type(matrix, 0, arr_len) == (arr_len - 1));\
+    /* One in three tiles: the sum fits in int8_t. */\
+    for (size_t i = 0; i < arr_len; i++) {\
+        matrix[i] = (type)((i % 3) == 0);\
+    }\
+    lok(linalg_sum_##type(matrix, arr_len) == (type)((arr_len + 2) / 3));\
+    free(matrix);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+void test_reductions_bool() {
+    bool matrix[130] = {0};
+    lok(!linalg_any_bool(matrix, 130));
+    lok(!linalg_isIn_bool(matrix, true, 130));
+    matrix[129] = true;
+    lok(linalg_any_bool(matrix, 130));
+    lok(linalg_count_bool(matrix, true, 130) == 1);
+    memset(matrix, true, sizeof(matrix));
+    lok(linalg_all_bool(matrix, 130));
+    matrix[64] = false;
+    lok(!linalg_all_bool(matrix, 130));
+    lok(linalg_count_bool(matrix, false, 130) == 1);
+}
+
+#define REGISTER_ENUM(type) void test_fused_##type() {\
+    size_t arr_len = 5000;\
+    type * a = calloc(arr_len, sizeof(type));\
+    type * b = calloc(arr_len, sizeof(type));\
+    type * mask = calloc(arr_len, sizeof(type));\
+    type * out = calloc(arr_len, sizeof(type));\
+    for (size_t i = 0; i < arr_len; i++) {\
+        a[i] = (type)((i * 7) % 13);\
+        b[i] = (type)((i * 5) % 11);\
+        mask[i] = (type)((i % 3) > 0);\
+    }\
+    struct nmath_fused_op_##type ops[3] = {\
+        {NMATH_FUSED_MULT, mask, 0},\
+        {NMATH_FUSED_PLUS, b, 0},\
+        {NMATH_FUSED_SGEQ, NULL, 9},\
+    };\
+    type * temp1 = linalg_mult_##type(a, mask, arr_len);\
+    type * temp2 = linalg_plus_##type(temp1, b, arr_len);\
+    type * expected = calloc(arr_len, sizeof(type));\
+    for (size_t i = 0; i < arr_len; i++) {\
+        expected[i] = (temp2[i] >= 9);\
+    }\
+    type * fused = linalg_fused_##type(a, ops, 3, arr_len);\
+    lok(memcmp(fused, expected, arr_len * sizeof(type)) == 0);\
+    bool same = true;\
+    for (size_t i = 0; i < arr_len; i++) {\
+        same &= (fused[i] == (type)(((i % 3) > 0) ? (a[i] + b[i] >= 9) : (b[i] >= 9)));\
+    }\
+    lok(same);\
+    linalg_fused_noM_##type(out, a, ops, 0, arr_len);\
+    lok(memcmp(out, a, arr_len * sizeof(type)) == 0);\
+    linalg_fused_noM_##type(out, out, ops, 3, arr_len);\
+    lok(memcmp(out, expected, arr_len * sizeof(type)) == 0);\
+    struct nmath_fused_op_##type ops_mask[2] = {\
+        {NMATH_FUSED_MINUS_SCALAR, NULL, 3},\
+        {NMATH_FUSED_MASK, mask, 0},\
+    };\
+    linalg_fused_noM_##type(out, a, ops_mask, 2, arr_len);\
+    same = true;\
+    for (size_t i = 0; i < arr_len; i++) {\
+        same &= (out[i] == (type)(((type)(a[i] - 3) != 0) && (mask[i] > 0)));\
+    }\
+    lok(same);\
+    nmath_free(temp1);\
+    nmath_free(temp2);\
+    free(expected);\
+    nmath_free(fused);\
+    free(a);\
+    free(b);\
+    free(mask);\
+    free(out);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) void test_matmul_##type() {\
+    type matrix1[6] = {1, 2, 3, 4, 5, 6};\
+    type matrix2[6] = {1, 0, 2, 1, 0, 3};\
+    type expected[4] = {5, 11, 14, 23};\
+    type * product = linalg_matmul_##type(matrix1, matrix2, 2, 3, 2);\
+    lok(memcmp(product, expected, 4 * sizeof(type)) == 0);\
+    nmath_free(product);\
+    size_t row_len = 37, inner_len = 300, col_len = 70;\
+    type * a = calloc(row_len * inner_len, sizeof(type));\
+    type * b = calloc(inner_len * col_len, sizeof(type));\
+    type * naive = calloc(row_len * col_len, sizeof(type));\
+    type * out = calloc(row_len * col_len, sizeof(type));\
+    type * buffer = calloc(NMATH_MATMUL_BUFFER_LEN, sizeof(type));\
+    /* Sparse a: every sum fits in int8_t. */\
+    for (size_t i = 0; i < (row_len * inner_len); i++) {\
+        a[i] = (type)((i % 13) == 0);\
+    }\
+    for (size_t i = 0; i < (inner_len * col_len); i++) {\
+        b[i] = (type)((i * 3) % 4);\
+    }\
+    for (size_t row = 0; row < row_len; row++) {\
+        for (size_t col = 0; col < col_len; col++) {\
+            type sum = 0;\
+            for (size_t k = 0; k < inner_len; k++) {\
+                sum += a[row * inner_len + k] * b[k * col_len + col];\
+            }\
+            naive[row * col_len + col] = sum;\
+        }\
+    }\
+    linalg_matmul_noM_##type(out, a, b, buffer, row_len, inner_len, col_len);\
+    lok(memcmp(out, naive, row_len * col_len * sizeof(type)) == 0);\
+    product = linalg_matmul_##type(a, b, row_len, inner_len, col_len);\
+    lok(memcmp(product, naive, row_len * col_len * sizeof(type)) == 0);\
+    nmath_free(product);\
+    free(a);\
+    free(b);\
+    free(naive);\
+    free(out);\
+    free(buffer);\
+}
+TEMPLATE_TYPES_INT
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+void test_threads() {
+    size_t arr_len = NMATH_PARALLEL_THRESHOLD + 3 * NMATH_PARALLEL_CHUNK_LEN + 37;
+    int32_t * matrix1 = calloc(arr_len, sizeof(*matrix1));
+    int32_t * matrix2 = calloc(arr_len, sizeof(*matrix2));
+    int32_t * serial = calloc(arr_len, sizeof(*serial));
+    int32_t * parallel = calloc(arr_len, sizeof(*parallel));
+    bit_array_t * mask_serial = calloc(NMATH_BIT_ARRAY_SIZE_CEIL(arr_len), sizeof(*mask_serial));
+    bit_array_t * mask_parallel = calloc(NMATH_BIT_ARRAY_SIZE_CEIL(arr_len), sizeof(*mask_parallel));
+    for (size_t i = 0; i < arr_len; i++) {
+        matrix1[i] = (int32_t)((i * 7) % 13) - 6;
+        matrix2[i] = (int32_t)((i * 5) % 11) + 1;
+    }
+    matrix1[arr_len - 2] = -100;
+    struct nmath_fused_op_int32_t ops[2] = {
+        {NMATH_FUSED_MULT, matrix2, 0},
+        {NMATH_FUSED_SGEQ, NULL, 3},
+    };
+
+    nmath_set_threads(1);
+    lok(nmath_get_threads() == 1);
+    linalg_minus_noM_int32_t(serial, matrix1, matrix2, arr_len);
+    linalg_smaller_bitmask_int32_t(mask_serial, matrix1, matrix2, arr_len);
+    int32_t sum = linalg_sum_int32_t(matrix1, arr_len);
+    int32_t min = linalg_min_int32_t(matrix1, arr_len);
+    int32_t max = linalg_max_int32_t(matrix1, arr_len);
+    size_t count = linalg_count_int32_t(matrix1, 0, arr_len);
+    int32_t * fused = linalg_fused_int32_t(matrix1, ops, 2, arr_len);
+
+    nmath_set_threads(4);
+    linalg_minus_noM_int32_t(parallel, matrix1, matrix2, arr_len);
+    linalg_smaller_bitmask_int32_t(mask_parallel, matrix1, matrix2, arr_len);
+    lok(memcmp(serial, parallel, arr_len * sizeof(*serial)) == 0);
+    lok(memcmp(mask_serial, mask_parallel, NMATH_BIT_ARRAY_SIZE_CEIL(arr_len) * sizeof(*mask_serial)) == 0);
+    lok(linalg_sum_int32_t(matrix1, arr_len) == sum);
+    lok(linalg_min_int32_t(matrix1, arr_len) == -100);
+    lok(linalg_min_int32_t(matrix1, arr_len) == min);
+    lok(linalg_max_int32_t(matrix1, arr_len) == max);
+    lok(linalg_count_int32_t(matrix1, 0, arr_len) == count);
+    lok(linalg_isIn_int32_t(matrix1, -100, arr_len));
+    lok(!linalg_isIn_int32_t(matrix1, 100, arr_len));
+    lok(linalg_all_int32_t(matrix2, arr_len));
+    linalg_fused_noM_int32_t(parallel, matrix1, ops, 2, arr_len);
+    lok(memcmp(fused, parallel, arr_len * sizeof(*fused)) == 0);
+
+    size_t sq_len = 300;
+    double * a = calloc(sq_len * sq_len, sizeof(*a));
+    double * b = calloc(sq_len * sq_len, sizeof(*b));
+    for (size_t i = 0; i < (sq_len * sq_len); i++) {
+        a[i] = (double)((i * 7) % 5);
+        b[i] = (double)((i * 3) % 4);
+    }
+    double * product_parallel = linalg_matmul_double(a, b, sq_len, sq_len, sq_len);
+    nmath_set_threads(1);
+    double * product_serial = linalg_matmul_double(a, b, sq_len, sq_len, sq_len);
+    lok(memcmp(product_serial, product_parallel, sq_len * sq_len * sizeof(double)) == 0);
+    nmath_set_threads(0);
+
+    nmath_free(product_serial);
+    nmath_free(product_parallel);
+    free(a);
+    free(b);
+    nmath_free(fused);
+    free(matrix1);
+    free(matrix2);
+    free(serial);
+    free(parallel);
+    free(mask_serial);
+    free(mask_parallel);
+}
+
+void test_lu() {
+    int32_t int_mat[9] = {0, 2, 1, 3, -1, 2, 1, 1, 1};
+    lok(linalg_determinant_int32_t(int_mat, 3) == 2);
+    int_mat[8] = 4;
+    lok(linalg_determinant_int32_t(int_mat, 3) == -16);
+    int_mat[8] = 3;
+    lok(linalg_determinant_int32_t(int_mat, 3) == -10);
+    int32_t int_singular[9] = {1, 2, 3, 2, 4, 6, 1, 0, 1};
+    lok(linalg_determinant_int32_t(int_singular, 3) == 0);
+    int64_t int_mat4[16] = {2, 0, 0, 0, 0, 3, 0, 0, 0, 0, -1, 0, 0, 0, 0, 5};
+    lok(linalg_determinant_int64_t(int_mat4, 4) == -30);
+
+    double mat3[9] = {0, 2, 1, 3, -1, 2, 1, 1, 4};
+    lok(fabs(linalg_determinant_double(mat3, 3) + 16.0) < 1e-9);
+    double singular[9] = {1, 2, 3, 2, 4, 6, 1, 0, 1};
+    lok(linalg_determinant_double(singular, 3) == 0.0);
+    lok(linalg_inverse_double(singular, 3) == NULL);
+
+    /* Larger than NMATH_LU_BLOCK, diagonally dominant */
+    size_t sq_len = 70;
+    double * square_mat = calloc(sq_len * sq_len, sizeof(double));
+    double * lu = calloc(sq_len * sq_len, sizeof(double));
+    double * inverse = calloc(sq_len * sq_len, sizeof(double));
+    double * b = calloc(sq_len, sizeof(double));
+    double * x = calloc(sq_len, sizeof(double));
+    size_t * pivots = calloc(sq_len, sizeof(size_t));
+    for (size_t i = 0; i < sq_len; i++) {
+        for (size_t j = 0; j < sq_len; j++) {
+            square_mat[i * sq_len + j] = (double)((i * 7 + j * 3) % 11) / 11.0;
+        }
+        square_mat[i * sq_len + i] += (double)sq_len;
+        b[i] = (double)(i % 5);
+    }
+    memcpy(lu, square_mat, sq_len * sq_len * sizeof(double));
+    lok(linalg_lu_noM_double(lu, pivots, sq_len) != 0);
+    linalg_solve_noM_double(x, lu, pivots, b, sq_len);
+    double residual = 0.0;
+    for (size_t i = 0; i < sq_len; i++) {
+        double row = -b[i];
+        for (size_t j = 0; j < sq_len; j++) {
+            row += square_mat[i * sq_len + j] * x[j];
+        }
+        residual = fmax(residual, fabs(row));
+    }
+    lok(residual < 1e-9);
+    linalg_inverse_noM_double(inverse, lu, pivots, sq_len);
+    double * identity = linalg_matmul_double(square_mat, inverse, sq_len, sq_len, sq_len);
+    double error = 0.0;
+    for (size_t i = 0; i < sq_len; i++) {
+        for (size_t j = 0; j < sq_len; j++) {
+            error = fmax(error, fabs(identity[i * sq_len + j] - (i == j)));
+        }
+    }
+    lok(error < 1e-9);
+    double * x2 = linalg_solve_double(square_mat, b, sq_len);
+    lok(memcmp(x, x2, sq_len * sizeof(double)) == 0);
+    /* determinant: product of U diagonal, compare with LU of the transpose */
+    double * transpose = calloc(sq_len * sq_len, sizeof(double));
+    for (size_t i = 0; i < sq_len; i++) {
+        for (size_t j = 0; j < sq_len; j++) {
+            transpose[j * sq_len + i] = square_mat[i * sq_len + j];
+        }
+    }
+    double determinant = linalg_determinant_noM_double(square_mat, lu, pivots, sq_len);
+    double determinant_t = linalg_determinant_double(transpose, sq_len);
+    lok(fabs(determinant - determinant_t) < (1e-9 * fabs(determinant)));
+    free(transpose);
+    nmath_free(identity);
+    nmath_free(x2);
+    free(square_mat);
+    free(lu);
+    free(inverse);
+    free(b);
+    free(x);
+    free(pivots);
+}
+
+/* AoS -> SoA: element k of item i from aos[i * len + k] to soa[k * num + i] */
+#define TEST_AOS2SOA(soa, aos, len, num) for (size_t i = 0; i < (num); i++) {\
+    for (size_t k = 0; k < (len); k++) {\
+        soa[k * (num) + i] = aos[i * (len) + k];\
+    }\
+}
+
+#define TEST_BATCH(type, D) {\
+    size_t num = 5;\
+    type matrices[5 * D * D], inverses[5 * D * D], products[5 * D * D];\
+    type soa[5 * D * D], soa_out[5 * D * D], expected[5 * D * D];\
+    type vecs[5 * D], out[5 * D], soa_vecs[5 * D], soa_vec_out[5 * D], vec_expected[5 * D];\
+    type determinants[5], soa_determinants[5];\
+    for (size_t i = 0; i < (num * D * D); i++) {\
+        matrices[i] = (type)((i * 7) % 11) - 5;\
+    }\
+    for (size_t i = 0; i < num; i++) {\
+        matrices[i * D * D] += 20;\
+        matrices[i * D * D + D * D - 1] += 20;\
+    }\
+    for (size_t i = 0; i < (num * D); i++) {\
+        vecs[i] = (type)((i * 3) % 5) - 2;\
+    }\
+    linalg_batch_inverse##D##_noM_##type(inverses, matrices, num);\
+    linalg_batch_matmul##D##_noM_##type(products, matrices, inverses, num);\
+    bool same = true;\
+    for (size_t i = 0; i < num; i++) {\
+        for (size_t r = 0; r < D; r++) {\
+            for (size_t c = 0; c < D; c++) {\
+                same &= (fabs(products[i * D * D + r * D + c] - (r == c)) < 1e-4);\
+            }\
+        }\
+    }\
+    lok(same);\
+    linalg_batch_determinant##D##_noM_##type(determinants, matrices, num);\
+    same = true;\
+    for (size_t i = 0; i < num; i++) {\
+        type determinant = linalg_determinant_##type(matrices + i * D * D, D);\
+        same &= (fabs(determinants[i] - determinant) < (1e-4 * fabs(determinant)));\
+    }\
+    lok(same);\
+    TEST_AOS2SOA(soa, matrices, D * D, num);\
+    linalg_batch_determinant##D##_soa_noM_##type(soa_determinants, soa, num);\
+    lok(memcmp(determinants, soa_determinants, sizeof(determinants)) == 0);\
+    linalg_batch_inverse##D##_soa_noM_##type(soa_out, soa, num);\
+    TEST_AOS2SOA(expected, inverses, D * D, num);\
+    lok(memcmp(soa_out, expected, sizeof(expected)) == 0);\
+    linalg_batch_matmul##D##_soa_noM_##type(soa_out, soa, soa_out, num);\
+    TEST_AOS2SOA(expected, products, D * D, num);\
+    lok(memcmp(soa_out, expected, sizeof(expected)) == 0);\
+    for (size_t i = 0; i < num; i++) {\
+        for (size_t r = 0; r < D; r++) {\
+            vec_expected[i * D + r] = 0;\
+            for (size_t c = 0; c < D; c++) {\
+                vec_expected[i * D + r] += matrices[i * D * D + r * D + c] * vecs[i * D + c];\
+            }\
+        }\
+    }\
+    linalg_batch_matvec##D##_noM_##type(out, matrices, vecs, num);\
+    lok(memcmp(out, vec_expected, sizeof(out)) == 0);\
+    TEST_AOS2SOA(soa_vecs, vecs, D, num);\
+    linalg_batch_matvec##D##_soa_noM_##type(soa_vec_out, soa, soa_vecs, num);\
+    TEST_AOS2SOA(soa_vecs, vec_expected, D, num);\
+    lok(memcmp(soa_vec_out, soa_vecs, sizeof(soa_vecs)) == 0);\
+    for (size_t i = 0; i < num; i++) {\
+        for (size_t r = 0; r < D; r++) {\
+            vec_expected[i * D + r] = 0;\
+            for (size_t c = 0; c < D; c++) {\
+                vec_expected[i * D + r] += matrices[r * D + c] * vecs[i * D + c];\
+            }\
+        }\
+    }\
+    TEST_AOS2SOA(soa_vecs, vecs, D, num);\
+    linalg_batch_transform##D##_noM_##type(vecs, matrices, vecs, num);\
+    lok(memcmp(vecs, vec_expected, sizeof(vecs)) == 0);\
+    linalg_batch_transform##D##_soa_noM_##type(soa_vec_out, matrices, soa_vecs, num);\
+    TEST_AOS2SOA(soa_vecs, vec_expected, D, num);\
+    lok(memcmp(soa_vec_out, soa_vecs, sizeof(soa_vecs)) == 0);\
+}
+
+#define REGISTER_ENUM(type) void test_batch_##type() {\
+    TEST_BATCH(type, 2)\
+    TEST_BATCH(type, 3)\
+    TEST_BATCH(type, 4)\
+    type singular[9] = {1, 2, 3, 2, 4, 6, 1, 0, 1};\
+    type inverse[9];\
+    linalg_batch_inverse3_noM_##type(inverse, singular, 1);\
+    lok(!linalg_any_##type(inverse, 9));\
+    type vecs1[6] = {1, 0, 0, 1, 2, 3};\
+    type vecs2[6] = {0, 1, 0, -2, 0, 5};\
+    type crosses[6], soa1[6], soa2[6], soa_out[6], cross[3];\
+    linalg_batch_crossProduct_noM_##type(crosses, vecs1, vecs2, 2);\
+    lok((crosses[0] == 0) && (crosses[1] == 0) && (crosses[2] == 1));\
+    linalg_crossProduct_noM_##type(cross, vecs1 + 3, vecs2 + 3);\
+    lok(memcmp(cross, crosses + 3, sizeof(cross)) == 0);\
+    TEST_AOS2SOA(soa1, vecs1, 3, 2);\
+    TEST_AOS2SOA(soa2, vecs2, 3, 2);\
+    linalg_batch_crossProduct_soa_noM_##type(soa_out, soa1, soa2, 2);\
+    TEST_AOS2SOA(soa1, crosses, 3, 2);\
+    lok(memcmp(soa_out, soa1, sizeof(soa1)) == 0);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) void test_eigen_##type() {\
+    type small[9] = {2, 1, 0, 1, 2, 0, 0, 0, 3};\
+    type eigenvalues[40], work[40];\
+    lok(linalg_eigen_symmetric_noM_##type(small, eigenvalues, work, 3) == eigenvalues);\
+    lok(fabs(eigenvalues[0] - 1) < 1e-5);\
+    lok(fabs(eigenvalues[1] - 3) < 1e-5);\
+    lok(fabs(eigenvalues[2] - 3) < 1e-5);\
+    lok(fabs(fabs(small[0]) - sqrt(0.5)) < 1e-5);\
+    lok(fabs(small[0] + small[1]) < 1e-5);\
+    size_t sq_len = 40;\
+    type * square_mat = calloc(sq_len * sq_len, sizeof(type));\
+    type * vectors = calloc(sq_len * sq_len, sizeof(type));\
+    for (size_t i = 0; i < sq_len; i++) {\
+        for (size_t j = 0; j <= i; j++) {\
+            square_mat[i * sq_len + j] = (type)((i * 7 + j * 3) % 13) / 13 - 0.5;\
+            square_mat[j * sq_len + i] = square_mat[i * sq_len + j];\
+        }\
+    }\
+    memcpy(vectors, square_mat, sq_len * sq_len * sizeof(type));\
+    lok(linalg_eigen_symmetric_noM_##type(vectors, eigenvalues, work, sq_len) != NULL);\
+    type tolerance = (type)(sizeof(type) == sizeof(float) ? 1e-3 : 1e-9);\
+    bool sorted = true, eigen = true, orthonormal = true;\
+    for (size_t i = 0; i < sq_len; i++) {\
+        sorted &= ((i == 0) || (eigenvalues[i - 1] <= eigenvalues[i]));\
+        for (size_t r = 0; r < sq_len; r++) {\
+            type av = 0;\
+            for (size_t c = 0; c < sq_len; c++) {\
+                av += square_mat[r * sq_len + c] * vectors[i * sq_len + c];\
+            }\
+            eigen &= (fabs(av - eigenvalues[i] * vectors[i * sq_len + r]) < tolerance);\
+        }\
+        for (size_t j = 0; j < sq_len; j++) {\
+            type dot = linalg_dotProduct_##type(vectors + i * sq_len, vectors + j * sq_len, sq_len);\
+            orthonormal &= (fabs(dot - (i == j)) < tolerance);\
+        }\
+    }\
+    lok(sorted);\
+    lok(eigen);\
+    lok(orthonormal);\
+    free(square_mat);\
+    free(vectors);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+#define REGISTER_ENUM(type) void test_csr_##type() {\
+    type costmap[12] = {\
+        1, 2, 0, 1,\
+        1, 1, 4, 1,\
+        0, 1, 1, 2\
+    };\
+    size_t tile_num = 12;\
+    lok(linalg_csr_grid_##type(costmap, 3, 4, 5) == NULL);\
+    struct nmath_csr_##type * square = linalg_csr_grid_##type(costmap, 3, 4, NMATH_SQUARE_NEIGHBOURS);\
+    lok(square->row_len == tile_num);\
+    lok(square->nnz == 24);\
+    lok(square->row_starts[2] == square->row_starts[3]);\
+    lok(square->row_starts[8] == square->row_starts[9]);\
+    type * dense = calloc(tile_num * tile_num, sizeof(type));\
+    for (size_t row = 0; row < tile_num; row++) {\
+        for (size_t i = square->row_starts[row]; i < square->row_starts[row + 1]; i++) {\
+            dense[row * tile_num + square->col_indices[i]] = square->values[i];\
+        }\
+    }\
+    lok(dense[0 * tile_num + 1] == (type)0.5);\
+    lok(dense[1 * tile_num + 0] == 1);\
+    lok(dense[5 * tile_num + 6] == (type)0.25);\
+    lok(dense[6 * tile_num + 5] == 1);\
+    lok(dense[3 * tile_num + 2] == 0);\
+    type vec[12], out[12];\
+    for (size_t i = 0; i < tile_num; i++) {\
+        vec[i] = (type)i + 1;\
+    }\
+    linalg_csr_spmv_noM_##type(out, square, vec);\
+    bool equal = true;\
+    for (size_t row = 0; row < tile_num; row++) {\
+        type expected = 0;\
+        for (size_t col = 0; col < tile_num; col++) {\
+            expected += dense[row * tile_num + col] * vec[col];\
+        }\
+        equal &= (fabs(out[row] - expected) < 1e-5);\
+    }\
+    lok(equal);\
+    struct nmath_csr_##type * transpose = linalg_csr_transpose_##type(square);\
+    lok(transpose->nnz == square->nnz);\
+    equal = true;\
+    for (size_t row = 0; row < tile_num; row++) {\
+        for (size_t i = transpose->row_starts[row]; i < transpose->row_starts[row + 1]; i++) {\
+            equal &= (dense[transpose->col_indices[i] * tile_num + row] == transpose->values[i]);\
+            equal &= ((i == transpose->row_starts[row]) || (transpose->col_indices[i - 1] < transpose->col_indices[i]));\
+        }\
+    }\
+    lok(equal);\
+    struct nmath_csr_##type * hex = linalg_csr_grid_##type(costmap, 3, 4, NMATH_HEXAGON_NEIGHBOURS);\
+    lok(hex->nnz == 32);\
+    lok(hex->row_starts[5] - hex->row_starts[4] == 3);\
+    size_t big_len = 512;\
+    type * big_costmap = malloc(big_len * big_len * sizeof(type));\
+    type * big_vec = malloc(big_len * big_len * sizeof(type));\
+    for (size_t i = 0; i < big_len * big_len; i++) {\
+        big_costmap[i] = 1;\
+        big_vec[i] = 1;\
+    }\
+    struct nmath_csr_##type * big = linalg_csr_grid_##type(big_costmap, big_len, big_len, NMATH_SQUARE_NEIGHBOURS);\
+    lok(big->nnz == 4 * big_len * (big_len - 1));\
+    type * big_out = linalg_csr_spmv_##type(big, big_vec);\
+    lok(big_out[0] == 2);\
+    lok(big_out[1] == 3);\
+    lok(big_out[big_len + 1] == 4);\
+    nmath_free(big_out);\
+    free(big_vec);\
+    free(big_costmap);\
+    free(dense);\
+    linalg_csr_free_##type(big);\
+    linalg_csr_free_##type(hex);\
+    linalg_csr_free_##type(transpose);\
+    linalg_csr_free_##type(square);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+/* Naive convolve2D: every tap, borders by index arithmetic */
+#define TEST_BORDER(i, len, border) (((i) >= 0) && ((i) < (int64_t)(len)) ? (i) :\
+    ((border) == NMATH_BORDER_CLAMP) ? (((i) < 0) ? 0 : (int64_t)(len) - 1) :\
+    ((border) == NMATH_BORDER_WRAP) ? ((((i) % (int64_t)(len)) + (int64_t)(len)) % (int64_t)(len)) : -1)
+#define TEST_CONVOLVE(type, out, matrix, kernel, row_len, col_len, k_row_len, k_col_len, border) for (int64_t row = 0; row < (int64_t)(row_len); row++) {\
+    for (int64_t col = 0; col < (int64_t)(col_len); col++) {\
+        type sum = 0;\
+        for (int64_t i = 0; i < (int64_t)(k_row_len); i++) {\
+            for (int64_t j = 0; j < (int64_t)(k_col_len); j++) {\
+                int64_t r = TEST_BORDER(row + i - (int64_t)(k_row_len) / 2, row_len, border);\
+                int64_t c = TEST_BORDER(col + j - (int64_t)(k_col_len) / 2, col_len, border);\
+                sum += ((r >= 0) && (c >= 0)) ? kernel[i * (k_col_len) + j] * matrix[r * (col_len) + c] : 0;\
+            }\
+        }\
+        out[row * (col_len) + col] = sum;\
+    }\
+}
+
+#define REGISTER_ENUM(type) void test_convolve_##type() {\
+    size_t row_len = 23, col_len = 37;\
+    type * matrix = malloc(row_len * col_len * sizeof(type));\
+    type * expected = malloc(row_len * col_len * sizeof(type));\
+    type * buffer = malloc(row_len * col_len * sizeof(type));\
+    type * out = malloc(row_len * col_len * sizeof(type));\
+    for (size_t i = 0; i < row_len * col_len; i++) {\
+        matrix[i] = (type)((i * 7) % 11);\
+    }\
+    type row_kernel[3] = {1, 2, 1}, col_kernel[5] = {0.5, 1, 3, 1, -0.5};\
+    type kernel[15], box[25], wide[21];\
+    for (size_t i = 0; i < 5; i++) {\
+        for (size_t j = 0; j < 3; j++) {\
+            kernel[i * 3 + j] = col_kernel[i] * row_kernel[j];\
+        }\
+    }\
+    for (size_t i = 0; i < 25; i++) {\
+        box[i] = (type)1 / 25;\
+    }\
+    for (size_t i = 0; i < 21; i++) {\
+        wide[i] = (type)(i % 4);\
+    }\
+    for (int border = NMATH_BORDER_ZERO; border <= NMATH_BORDER_WRAP; border++) {\
+        bool equal = true;\
+        TEST_CONVOLVE(type, expected, matrix, kernel, row_len, col_len, 5, 3, border);\
+        linalg_convolve2D_noM_##type(out, matrix, kernel, row_len, col_len, 5, 3, border);\
+        for (size_t i = 0; i < row_len * col_len; i++) {\
+            equal &= (fabs(out[i] - expected[i]) < 1e-4);\
+        }\
+        linalg_convolve2D_separable_noM_##type(out, matrix, buffer, row_kernel, col_kernel, row_len, col_len, 5, 3, border);\
+        for (size_t i = 0; i < row_len * col_len; i++) {\
+            equal &= (fabs(out[i] - expected[i]) < 1e-4);\
+        }\
+        TEST_CONVOLVE(type, expected, matrix, box, row_len, col_len, 5, 5, border);\
+        linalg_box_filter_noM_##type(out, matrix, buffer, row_len, col_len, 2, border);\
+        for (size_t i = 0; i < row_len * col_len; i++) {\
+            equal &= (fabs(out[i] - expected[i]) < 1e-4);\
+        }\
+        TEST_CONVOLVE(type, expected, matrix, wide, 4, 5, 3, 7, border);\
+        linalg_convolve2D_noM_##type(out, matrix, wide, 4, 5, 3, 7, border);\
+        for (size_t i = 0; i < 4 * 5; i++) {\
+            equal &= (fabs(out[i] - expected[i]) < 1e-4);\
+        }\
+        lok(equal);\
+    }\
+    type * allocated = linalg_convolve2D_##type(matrix, kernel, row_len, col_len, 5, 3, NMATH_BORDER_ZERO);\
+    lok(allocated[0] == (3 * 2 * matrix[0] + 3 * matrix[1] + 1 * (2 * matrix[col_len] + matrix[col_len + 1]) - 0.5 * (2 * matrix[2 * col_len] + matrix[2 * col_len + 1])));\
+    nmath_free(allocated);\
+    free(matrix);\
+    free(expected);\
+    free(buffer);\
+    free(out);\
+}
+TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+
+void test_alignment() {
+    int32_t * darr = DARR_INIT(darr, int32_t, 4);
+    lok(DARR_LEN(darr) == 4);
+    lok(DARR_NUM(darr) == 0);
+    for (int32_t i = 0; i < 100; i++) {
+        DARR_PUT(darr, i);
+        if (NMATH_ALIGNMENT > 0) {
+            lok(((uintptr_t)darr % NMATH_ALIGNMENT) == 0);
+        }
+    }
+    lok(DARR_NUM(darr) == 100);
+    lok(DARR_LEN(darr) >= 100);
+    for (int32_t i = 0; i < 100; i++) {
+        lok(darr[i] == i);
+    }
+    DARR_FREE(darr);
+
+    double mat1[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    double mat2[9] = {9, 8, 7, 6, 5, 4, 3, 2, 1};
+    double * sum = linalg_plus_double(mat1, mat2, 9);
+    if (NMATH_ALIGNMENT > 0) {
+        lok(((uintptr_t)sum % NMATH_ALIGNMENT) == 0);
+    }
+    for (size_t i = 0; i < 9; i++) {
+        lok(sum[i] == 10);
+    }
+    nmath_free(sum);
+
+    void * mem = nmath_calloc(13, sizeof(uint8_t));
+    lok(mem != NULL);
+    if (NMATH_ALIGNMENT > 0) {
+        lok(((uintptr_t)mem % NMATH_ALIGNMENT) == 0);
+    }
+    lok(((uint8_t *)mem)[12] == 0);
+    mem = nmath_realloc(mem, 1000);
+    lok(mem != NULL);
+    lok(((uint8_t *)mem)[12] == 0);
+    if (NMATH_ALIGNMENT > 0) {
+        lok(((uintptr_t)mem % NMATH_ALIGNMENT) == 0);
+    }
+    nmath_free(mem);
+}
+
+void test_simd_dispatch() {
+    int detected = nmath_detect_simd();
+    lok((detected >= NMATH_SIMD_SCALAR) && (detected < NMATH_SIMD_LEVEL_NUM));
+    lok(nmath_get_simd() <= detected);
+    lok(strcmp(nmath_simd_name(NMATH_SIMD_SCALAR), "scalar") == 0);
+    lok(strcmp(nmath_simd_name(NMATH_SIMD_LEVEL_NUM), "unknown") == 0);
+    nmath_set_simd(NMATH_SIMD_LEVEL_NUM);
+    lok(nmath_get_simd() == detected);
+
+    size_t arr_len = 1000 + 37;
+    int64_t * matrix1 = calloc(arr_len, sizeof(*matrix1));
+    int64_t * matrix2 = calloc(arr_len, sizeof(*matrix2));
+    int64_t * scalar = calloc(arr_len, sizeof(*scalar));
+    int64_t * simd = calloc(arr_len, sizeof(*simd));
+    double * dmatrix = calloc(arr_len, sizeof(*dmatrix));
+    bit_array_t * mask_scalar = calloc(NMATH_BIT_ARRAY_SIZE_CEIL(arr_len), sizeof(*mask_scalar));
+    bit_array_t * mask_simd = calloc(NMATH_BIT_ARRAY_SIZE_CEIL(arr_len), sizeof(*mask_simd));
+    for (size_t i = 0; i < arr_len; i++) {
+        matrix1[i] = (int64_t)((i * 7) % 13) - 6;
+        matrix2[i] = (int64_t)((i * 5) % 11) + 1;
+        dmatrix[i] = (double)matrix1[i] / 4.0;
+    }
+    matrix1[arr_len - 2] = -100;
+    matrix1[arr_len - 3] = 100;
+    dmatrix[arr_len - 3] = 25.0;
+
+    nmath_set_simd(NMATH_SIMD_SCALAR);
+    lok(nmath_get_simd() == NMATH_SIMD_SCALAR);
+    linalg_mult_noM_int64_t(scalar, matrix1, matrix2, arr_len);
+    linalg_smaller_bitmask_int64_t(mask_scalar, matrix1, matrix2, arr_len);
+    int64_t sum = linalg_sum_int64_t(matrix1, arr_len);
+    size_t count = linalg_count_int64_t(matrix1, 0, arr_len);
+    double dsum = linalg_sum_double(dmatrix, arr_len);
+    lok(linalg_min_int64_t(matrix1, arr_len) == -100);
+    lok(linalg_max_int64_t(matrix1, arr_len) == 100);
+    lok(linalg_max_double(dmatrix, arr_len) == 25.0);
+    /* GEMM micro-kernel and axpy: odd sizes for edge tiles, exact doubles */
+    size_t row_len = 31, inner_len = 29, col_len = 33;
+    double kernel[3] = {0.5, 1.0, -0.25};
+    double * dmatrix2 = calloc(arr_len, sizeof(*dmatrix2));
+    double * buffer = calloc(row_len * col_len, sizeof(*buffer));
+    double * conv_scalar = calloc(row_len * col_len, sizeof(*conv_scalar));
+    double * conv_simd = calloc(row_len * col_len, sizeof(*conv_simd));
+    for (size_t i = 0; i < arr_len; i++) {
+        dmatrix2[i] = (double)matrix2[i];
+    }
+    double * matmul_scalar = linalg_matmul_double(dmatrix, dmatrix2, row_len, inner_len, col_len);
+    linalg_convolve2D_separable_noM_double(conv_scalar, dmatrix, buffer, kernel, kernel, row_len, col_len, 3, 3, NMATH_BORDER_CLAMP);
+
+    for (int level = NMATH_SIMD_SSE2; level <= detected; level++) {
+        nmath_set_simd(level);
+        lok(nmath_get_simd() == level);
+        linalg_mult_noM_int64_t(simd, matrix1, matrix2, arr_len);
+        linalg_smaller_bitmask_int64_t(mask_simd, matrix1, matrix2, arr_len);
+        lok(memcmp(scalar, simd, arr_len * sizeof(*scalar)) == 0);
+        lok(memcmp(mask_scalar, mask_simd, NMATH_BIT_ARRAY_SIZE_CEIL(arr_len) * sizeof(*mask_scalar)) == 0);
+        lok(linalg_sum_int64_t(matrix1, arr_len) == sum);
+        lok(linalg_count_int64_t(matrix1, 0, arr_len) == count);
+        lok(fabs(linalg_sum_double(dmatrix, arr_len) - dsum) < 1e-9);
+        lok(linalg_min_int64_t(matrix1, arr_len) == -100);
+        lok(linalg_max_int64_t(matrix1, arr_len) == 100);
+        lok(linalg_max_double(dmatrix, arr_len) == 25.0);
+        lok(linalg_isIn_int64_t(matrix1, -100, arr_len));
+        lok(!linalg_isIn_int64_t(matrix1, 99, arr_len));
+        double * matmul_simd = linalg_matmul_double(dmatrix, dmatrix2, row_len, inner_len, col_len);
+        lok(memcmp(matmul_scalar, matmul_simd, row_len * col_len * sizeof(*matmul_scalar)) == 0);
+        nmath_free(matmul_simd);
+        linalg_convolve2D_separable_noM_double(conv_simd, dmatrix, buffer, kernel, kernel, row_len, col_len, 3, 3, NMATH_BORDER_CLAMP);
+        lok(memcmp(conv_scalar, conv_simd, row_len * col_len * sizeof(*conv_scalar)) == 0);
+    }
+    nmath_set_simd(-1);
+    lok(nmath_get_simd() == detected);
+
+    free(matrix1);
+    free(matrix2);
+    free(scalar);
+    free(simd);
+    free(dmatrix);
+    free(mask_scalar);
+    free(mask_simd);
+    free(dmatrix2);
+    free(buffer);
+    free(conv_scalar);
+    free(conv_simd);
+    nmath_free(matmul_scalar);
+}
+
+void test_stats() {
+    uint64_t before = nmath_get_ns();
+    int32_t costmap[5 * 5] = {
+        1, 1, 1, 1, 1,
+        1, 0, 0, 2, 1,
+        1, 1, 1, 0, 1,
+        1, 0, 1, 1, 1,
+        1, 1, 1, 1, 1,
+    };
+    struct nmath_point_int32_t start = {0, 0}, end = {4, 4};
+    int32_t * movemap = pathfinding_Map_Moveto_int32_t(costmap, 5, 5, start, 4, NMATH_POINTS_MODE_MATRIX);
+    struct nmath_stats stats = nmath_get_stats();
+#ifdef NMATH_STATS
+    lok(stats.pops > 0);
+    lok(stats.pushes == stats.pops);
+    lok(stats.closed_scans > 0);
+    lok(stats.allocs >= 3);
+    lok(stats.sight_checks == 0);
+#ifdef _OPENMP
+    /* per thread counters: concurrent calls each see their own */
+    size_t mismatches = 0;
+    #pragma omp parallel for num_threads(4) reduction(+:mismatches)
+    for (int i = 0; i < 64; i++) {
+        int32_t * thread_movemap = pathfinding_Map_Moveto_int32_t(costmap, 5, 5, start, 4, NMATH_POINTS_MODE_MATRIX);
+        struct nmath_stats thread_stats = nmath_get_stats();
+        mismatches += (thread_stats.pops != stats.pops) || (thread_stats.closed_scans != stats.closed_scans);
+        nmath_free(thread_movemap);
+    }
+    lok(mismatches == 0);
+#endif
+#else
+    lok(stats.pops == 0);
+    lok(stats.pushes == 0);
+    lok(stats.allocs == 0);
+    lok(stats.ns == 0);
+#endif
+    int32_t * path_map = calloc(5 * 5, sizeof(*path_map));
+    path_map = pathfinding_Astar_Map_int32_t(path_map, costmap, 5, 5, start, end);
+    stats = nmath_get_stats();
+#ifdef NMATH_STATS
+    lok(stats.pops > 0);
+    lok(stats.pushes >= stats.pops);
+    lok(stats.closed_scans == 0);
+    lok(stats.allocs >= 2);
+#else
+    lok(stats.pops == 0);
+#endif
+    lok(nmath_get_ns() >= before);
+    nmath_free(movemap);
+    free(path_map);
+}
+
+void test_histograms() {
+    struct nmath_latency latency = nmath_histogram_get(NMATH_HISTOGRAM_MOVETO);
+    lok(strcmp(latency.name, "pathfinding_Map_Moveto") == 0);
+    lok(nmath_histogram_get(NMATH_HISTOGRAM_NUM).count == 0);
+    lok(nmath_histogram_bucket_ns(17) == 17);
+    lok(nmath_histogram_bucket_ns(NMATH_HISTOGRAM_SUB_LEN * 2) == NMATH_HISTOGRAM_SUB_LEN * 2);
+    lok(nmath_histogram_bucket_ns(NMATH_HISTOGRAM_SUB_LEN * 2 + 1) == NMATH_HISTOGRAM_SUB_LEN * 2 + 2);
+#ifdef NMATH_HISTOGRAMS
+    nmath_histogram_reset();
+    int32_t costmap[5 * 5] = {
+        1, 1, 1, 1, 1,
+        1, 0, 0, 2, 1,
+        1, 1, 1, 0, 1,
+        1, 0, 1, 1, 1,
+        1, 1, 1, 1, 1,
+    };
+    struct nmath_point_int32_t start = {0, 0};
+    for (size_t i = 0; i < 10; i++) {
+        int32_t * movemap = pathfinding_Map_Moveto_int32_t(costmap, 5, 5, start, 4, NMATH_POINTS_MODE_MATRIX);
+        free(movemap);
+    }
+    latency = nmath_histogram_get(NMATH_HISTOGRAM_MOVETO);
+    lok(latency.count == 10);
+    lok(latency.min <= latency.p50);
+    lok(latency.p50 <= latency.p99);
+    lok(latency.p99 <= latency.p999);
+    lok(latency.p999 <= latency.max);
+    lok(nmath_histogram_get(NMATH_HISTOGRAM_ASTAR_LIST).count == 0);
+    /* 1 to 1000 ns: percentiles within 1/NMATH_HISTOGRAM_SUB_LEN */
+    for (uint64_t ns = 1; ns <= 1000; ns++) {
+        nmath_histogram_record(NMATH_HISTOGRAM_ASTAR_LIST, ns);
+    }
+    latency = nmath_histogram_get(NMATH_HISTOGRAM_ASTAR_LIST);
+    lok(latency.count == 1000);
+    lok(latency.min == 1);
+    lok(latency.max == 1000);
+    lok((latency.p50 <= 500) && (latency.p50 >= (500 - 500 / NMATH_HISTOGRAM_SUB_LEN)));
+    lok((latency.p99 <= 990) && (latency.p99 >= (990 - 990 / NMATH_HISTOGRAM_SUB_LEN)));
+    lok((latency.p999 <= 999) && (latency.p999 >= (999 - 999 / NMATH_HISTOGRAM_SUB_LEN)));
+    uint64_t * buckets = calloc(NMATH_HISTOGRAM_BUCKETS, sizeof(*buckets));
+    nmath_histogram_buckets(NMATH_HISTOGRAM_ASTAR_LIST, buckets);
+    lok(buckets[1] == 1);
+    lok(buckets[0] == 0);
+    free(buckets);
+#ifdef _OPENMP
+    /* one histogram block per thread, merged */
+    #pragma omp parallel for num_threads(4)
+    for (int i = 0; i < 400; i++) {
+        nmath_histogram_record(NMATH_HISTOGRAM_ASTAR_MAP, 100);
+    }
+    lok(nmath_histogram_get(NMATH_HISTOGRAM_ASTAR_MAP).count == 400);
+    lok(nmath_histogram_get(NMATH_HISTOGRAM_ASTAR_MAP).p50 == 100);
+#endif
+    nmath_histogram_reset();
+    lok(nmath_histogram_get(NMATH_HISTOGRAM_ASTAR_LIST).count == 0);
+#else
+    nmath_histogram_record(NMATH_HISTOGRAM_ASTAR_LIST, 100);
+    lok(nmath_histogram_get(NMATH_HISTOGRAM_ASTAR_LIST).count == 0);
+#endif
+}
+
+size_t test_alloc_live = 0;
+void * test_malloc(size_t bytesize) {
+    test_alloc_live++;
+    return (malloc(bytesize));
+}
+void * test_realloc(void * ptr, size_t bytesize) {
+    test_alloc_live += (ptr == NULL);
+    return (realloc(ptr, bytesize));
+}
+void test_free(void * ptr) {
+    test_alloc_live -= (ptr != NULL);
+    free(ptr);
+}
+
+void test_allocator() {
+    struct nmath_allocator counting = {test_malloc, NULL, test_realloc, test_free};
+    nmath_set_allocator(counting);
+    lok(nmath_get_allocator().malloc_fn == test_malloc);
+    lok(nmath_get_allocator().calloc_fn == NULL);
+#if NMATH_ALIGNMENT == 0
+    int32_t costmap[5 * 5] = {
+        1, 1, 1, 1, 1,
+        1, 0, 0, 2, 1,
+        1, 1, 1, 0, 1,
+        1, 0, 1, 1, 1,
+        1, 1, 1, 1, 1,
+    };
+    int32_t blockmap[5 * 5] = {0};
+    blockmap[2 * 5 + 2] = 1;
+    int8_t range[2] = {1, 2};
+    struct nmath_point_int32_t start = {0, 0}, end = {4, 4};
+    struct nmath_hexpoint_int32_t hex_start = {1, 0, 1};
+    int32_t * out = calloc(5 * 5, sizeof(*out));
+    int32_t * movemap = calloc(5 * 5, sizeof(*movemap));
+    int32_t * matrix;
+    /* pathfinding functions free everything but their output */
+    pathfinding_Map_Moveto_noM_int32_t(movemap, costmap, 5, 5, start, 4);
+    lok(test_alloc_live == 0);
+    matrix = pathfinding_Map_Moveto_int32_t(costmap, 5, 5, start, 4, NMATH_POINTS_MODE_MATRIX);
+    lok(test_alloc_live == 1);
+    nmath_free(matrix);
+    matrix = pathfinding_Map_Moveto_int32_t(costmap, 5, 5, start, 4, NMATH_POINTS_MODE_LIST);
+    lok(test_alloc_live == 1);
+    DARR_FREE(matrix);
+    matrix = pathfinding_Map_Moveto_Hex_int32_t(costmap, 5, 5, hex_start, 4, NMATH_POINTS_MODE_MATRIX);
+    lok(test_alloc_live == 1);
+    nmath_free(matrix);
+    matrix = pathfinding_Map_Visible_int32_t(blockmap, 5, 5, start, 4, NMATH_POINTS_MODE_MATRIX);
+    lok(test_alloc_live == 1);
+    nmath_free(matrix);
+    pathfinding_Map_Attackto_noM_int32_t(out, movemap, 5, 5, 4, range, NMATH_MOVETILE_INCLUDE);
+    lok(test_alloc_live == 0);
+    matrix = pathfinding_Map_Attackto_int32_t(movemap, 5, 5, 4, range, NMATH_POINTS_MODE_LIST, NMATH_MOVETILE_INCLUDE);
+    lok(test_alloc_live == 1);
+    DARR_FREE(matrix);
+    matrix = pathfinding_Map_Attackfrom_int32_t(movemap, 5, 5, end, range, NMATH_POINTS_MODE_LIST);
+    lok(test_alloc_live == 1);
+    DARR_FREE(matrix);
+    pathfinding_Map_unitGradient_noM_int32_t(out, costmap, 5, 5, &end, 1);
+    lok(test_alloc_live == 0);
+    pathfinding_Astar_Map_int32_t(out, costmap, 5, 5, start, end);
+    lok(test_alloc_live == 0);
+    int32_t * path_list = DARR_INIT(path_list, int32_t, 16);
+    path_list = pathfinding_Astar_List_int32_t(path_list, costmap, 5, 5, start, end);
+    lok(test_alloc_live == 1);
+    DARR_FREE(path_list);
+    lok(test_alloc_live == 0);
+    free(out);
+    free(movemap);
+#endif
+    struct nmath_allocator standard = {NULL, NULL, NULL, NULL};
+    nmath_set_allocator(standard);
+    lok(nmath_get_allocator().malloc_fn == NULL);
+#ifdef NMATH_ALLOC_DEBUG
+    struct nmath_alloc_count before = nmath_alloc_count(NULL);
+    int32_t * tracked = nmath_malloc(100 * sizeof(*tracked));
+    struct nmath_alloc_count after = nmath_alloc_count("test_allocator");
+    lok(after.live_num >= 1);
+    lok(nmath_alloc_count(NULL).live_bytes == (before.live_bytes + 100 * sizeof(*tracked)));
+    tracked = nmath_realloc(tracked, 200 * sizeof(*tracked));
+    lok(nmath_alloc_count(NULL).live_bytes == (before.live_bytes + 200 * sizeof(*tracked)));
+    nmath_free(tracked);
+    lok(nmath_alloc_count(NULL).live_bytes == before.live_bytes);
+    lok(nmath_alloc_count(NULL).live_num == before.live_num);
+#else
+    lok(nmath_alloc_count(NULL).calls == 0);
+#endif
+}
+
 int main() {
     globalf = fopen("nmath_test_results.txt", "w+");
     dupprintf(globalf, "\nHello, World! I am testing noursmath.\n");
@@ -4307,8 +5683,52 @@ int main() {
     lrun("test_double", linalg_double);
     lrun("test_float", linalg_float);
     lrun("test_path_A", test_pathfinding_Astar);
+    lrun("test_path_borders", test_pathfinding_borders);
     lrun("test_bops", test_bops);
     lrun("test_bit_array", test_bit_array);
+    lrun("test_alignment", test_alignment);
+    lrun("test_darr", test_darr);
+    lrun("test_uniques", test_uniques);
+    lrun("test_sort", test_sort);
+#define REGISTER_ENUM(type) lrun(STRINGIFY(kernels_##type), test_kernels_##type);
+    TEMPLATE_TYPES_INT
+    TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+#define REGISTER_ENUM(type) lrun(STRINGIFY(bitmask_##type), test_bitmask_##type);
+    TEMPLATE_TYPES_INT
+#undef REGISTER_ENUM
+    lrun("test_bitmask_float", test_bitmask_float);
+#define REGISTER_ENUM(type) lrun(STRINGIFY(reductions_##type), test_reductions_##type);
+    TEMPLATE_TYPES_INT
+    TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+    lrun("test_reductions_bool", test_reductions_bool);
+#define REGISTER_ENUM(type) lrun(STRINGIFY(fused_##type), test_fused_##type);
+    TEMPLATE_TYPES_INT
+    TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+#define REGISTER_ENUM(type) lrun(STRINGIFY(matmul_##type), test_matmul_##type);
+    TEMPLATE_TYPES_INT
+    TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+    lrun("test_threads", test_threads);
+    lrun("test_lu", test_lu);
+#define REGISTER_ENUM(type) lrun(STRINGIFY(batch_##type), test_batch_##type);
+    TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+#define REGISTER_ENUM(type) lrun(STRINGIFY(eigen_##type), test_eigen_##type);
+    TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+#define REGISTER_ENUM(type) lrun(STRINGIFY(csr_##type), test_csr_##type);
+    TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+#define REGISTER_ENUM(type) lrun(STRINGIFY(convolve_##type), test_convolve_##type);
+    TEMPLATE_TYPES_FLOAT
+#undef REGISTER_ENUM
+    lrun("test_simd_dispatch", test_simd_dispatch);
+    lrun("test_stats", test_stats);
+    lrun("test_allocator", test_allocator);
+    lrun("test_histograms", test_histograms);
 
 // #define REGISTER_ENUM(type) lrun(STRINGIFY(path_##type), test_pathfinding_##type);
 //     TEMPLATE_TYPES_SINT